@@ -7,31 +7,102 @@
  * 2. Nested loops
  * 3. Dimension validation for matrix multiplication
  * 4. Dynamic memory allocation for matrices
+ * 5. Contiguous, cache-aligned matrix storage (one allocation per matrix)
+ * 6. Loop reordering (i-k-j) and cache blocking (tiling) for L1/L2
+ * 7. Bulk file I/O: a text format read with a custom integer parser and
+ *    written through a buffered formatter, and a binary format with a
+ *    header that can be memory-mapped and used in place
+ *
+ * File formats:
+ * - Text:   "rows cols" followed by rows * cols integers separated by whitespace
+ * - Binary: 64-byte MatrixFileHeader, then rows * stride ints (row-major,
+ *           rows padded to `stride` exactly as in memory)
+ *
+ * Usage:
+ * gcc -O3 -march=native matrix_multiplication.c -o matmul
+ * ./matmul                          (interactive: enter dimensions and elements)
+ * ./matmul --bench [max]            (GFLOP/s benchmark for sizes 64..max, default 4096)
+ * ./matmul A B C                    (C = A * B; each file is text or binary, C is
+ *                                    written as binary if its name ends in .bin)
+ * ./matmul --io-bench [n]           (MB/s of each loader/writer on an n x n matrix)
  */
 
+#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define MATRIX_ALIGNMENT 64  // Cache line size in bytes
+#define BLOCK_I 64           // Rows of A/C per tile
+#define BLOCK_K 128          // Shared dimension per tile (B tile stays in L2)
+#define BLOCK_J 256          // Columns of B/C per tile (one C row slice stays in L1)
+#define LEGACY_MAX_N 1024    // Larger sizes take minutes with the old kernel
+#define IO_BUFFER_SIZE (1 << 16)
+#define MATRIX_FILE_MAGIC "MATB"
+#define MATRIX_FILE_VERSION 1
+
+/**
+ * A row-major matrix stored in one aligned buffer. Each row is padded to
+ * `stride` elements so that every row starts on a cache-line boundary.
+ */
+typedef struct {
+    int rows;
+    int cols;
+    int stride;
+    int *data;
+    size_t mapped_bytes;  // Non-zero if data points into an mmap'd file
+} Matrix;
+
+/**
+ * Header of the binary matrix format. It is padded to one cache line so
+ * that, in a page-aligned mapping, the element data is cache-line aligned
+ * and can be used directly as Matrix storage.
+ */
+typedef struct {
+    char magic[4];         // "MATB"
+    uint32_t version;
+    uint32_t element_size; // sizeof(int) of the writer
+    int32_t rows;
+    int32_t cols;
+    int32_t stride;
+    uint8_t reserved[MATRIX_ALIGNMENT - 24];
+} MatrixFileHeader;
+
+// Element (i, j) of matrix m
+#define MAT_AT(m, i, j) ((m)->data[(size_t)(i) * (m)->stride + (j)])
 
 /**
- * @brief Allocates memory for a matrix of size rows x cols.
+ * @brief Allocates a zero-initialised matrix of size rows x cols.
  *
  * @param rows Number of rows
  * @param cols Number of columns
- * @return int** Pointer to the allocated matrix
+ * @return Matrix* Pointer to the allocated matrix, or NULL on failure
  */
-int** allocate_matrix(int rows, int cols) {
-    int **matrix = (int **)malloc(rows * sizeof(int *));
+Matrix *allocate_matrix(int rows, int cols) {
+    Matrix *matrix = (Matrix *)malloc(sizeof(Matrix));
     if (matrix == NULL) return NULL;
 
-    for (int i = 0; i < rows; i++) {
-        matrix[i] = (int *)malloc(cols * sizeof(int));
-        if (matrix[i] == NULL) {
-            // Free previously allocated rows on failure
-            for (int j = 0; j < i; j++) free(matrix[j]);
-            free(matrix);
-            return NULL;
-        }
+    int per_line = MATRIX_ALIGNMENT / sizeof(int);
+    matrix->rows = rows;
+    matrix->cols = cols;
+    matrix->stride = (cols + per_line - 1) / per_line * per_line;
+    matrix->mapped_bytes = 0;
+
+    // aligned_alloc requires the size to be a multiple of the alignment,
+    // which the padded stride guarantees
+    size_t bytes = (size_t)rows * matrix->stride * sizeof(int);
+    matrix->data = (int *)aligned_alloc(MATRIX_ALIGNMENT, bytes ? bytes : MATRIX_ALIGNMENT);
+    if (matrix->data == NULL) {
+        free(matrix);
+        return NULL;
     }
+    memset(matrix->data, 0, bytes);
     return matrix;
 }
 
@@ -39,12 +110,13 @@ int** allocate_matrix(int rows, int cols) {
  * @brief Frees the memory allocated for a matrix.
  *
  * @param matrix Pointer to the matrix
- * @param rows Number of rows
  */
-void free_matrix(int **matrix, int rows) {
-    for (int i = 0; i < rows; i++) {
-        free(matrix[i]);
-    }
+void free_matrix(Matrix *matrix) {
+    if (matrix == NULL) return;
+    if (matrix->mapped_bytes)
+        munmap((char *)matrix->data - sizeof(MatrixFileHeader), matrix->mapped_bytes);
+    else
+        free(matrix->data);
     free(matrix);
 }
 
@@ -52,39 +124,668 @@ void free_matrix(int **matrix, int rows) {
  * @brief Reads matrix elements from standard input.
  *
  * @param matrix Pointer to the matrix
- * @param rows Number of rows
- * @param cols Number of columns
  * @param name Name of the matrix (for prompt)
  */
-void read_matrix(int **matrix, int rows, int cols, const char *name) {
-    printf("Enter elements for Matrix %s (%dx%d):\n", name, rows, cols);
-    for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
+void read_matrix(Matrix *matrix, const char *name) {
+    printf("Enter elements for Matrix %s (%dx%d):\n", name, matrix->rows, matrix->cols);
+    for (int i = 0; i < matrix->rows; i++) {
+        for (int j = 0; j < matrix->cols; j++) {
             printf("Element [%d][%d]: ", i, j);
-            scanf("%d", &matrix[i][j]);
+            scanf("%d", &MAT_AT(matrix, i, j));
         }
     }
 }
 
+/* ---------- Bulk text and binary I/O ---------- */
+
+/**
+ * Output buffer flushed with one fwrite per IO_BUFFER_SIZE bytes instead of
+ * one printf call per element.
+ */
+typedef struct {
+    FILE *fp;
+    size_t used;
+    int failed;
+    char data[IO_BUFFER_SIZE];
+} OutBuffer;
+
+void out_flush(OutBuffer *out) {
+    if (out->used && fwrite(out->data, 1, out->used, out->fp) != out->used) out->failed = 1;
+    out->used = 0;
+}
+
+/**
+ * @brief Appends the decimal form of value, digits written back to front.
+ */
+static inline void out_int(OutBuffer *out, int value) {
+    if (out->used + 12 > IO_BUFFER_SIZE) out_flush(out);
+    char digits[12];
+    int len = 0;
+    unsigned int u = value < 0 ? 0u - (unsigned int)value : (unsigned int)value;
+    do {
+        digits[len++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (value < 0) digits[len++] = '-';
+    char *dst = out->data + out->used;
+    for (int i = 0; i < len; i++) dst[i] = digits[len - 1 - i];
+    out->used += len;
+}
+
+static inline void out_char(OutBuffer *out, char c) {
+    if (out->used == IO_BUFFER_SIZE) out_flush(out);
+    out->data[out->used++] = c;
+}
+
+/**
+ * @brief Writes the elements of a matrix, `separator` between columns and a
+ * newline after each row.
+ */
+void write_elements(const Matrix *matrix, OutBuffer *out, char separator) {
+    for (int i = 0; i < matrix->rows; i++) {
+        const int *row = &MAT_AT(matrix, i, 0);
+        for (int j = 0; j < matrix->cols; j++) {
+            out_int(out, row[j]);
+            if (separator != ' ' || j + 1 < matrix->cols) out_char(out, separator);
+        }
+        out_char(out, '\n');
+    }
+}
+
 /**
  * @brief Prints matrix elements to standard output.
  *
  * @param matrix Pointer to the matrix
- * @param rows Number of rows
- * @param cols Number of columns
  */
-void print_matrix(int **matrix, int rows, int cols) {
+void print_matrix(const Matrix *matrix) {
+    static OutBuffer out;
+    out.fp = stdout;
+    out.used = 0;
+    fflush(stdout);
+    write_elements(matrix, &out, '\t');
+    out_flush(&out);
+}
+
+/**
+ * @brief Parses one optionally signed decimal integer, skipping leading
+ * whitespace. Advances *cursor past the number.
+ *
+ * @return 1 on success, 0 if no digits were found before `end`
+ */
+static inline int parse_int(const char **cursor, const char *end, int *value) {
+    const char *p = *cursor;
+    while (p < end && (*p == ' ' || *p == '\n' || *p == '\t' || *p == '\r')) p++;
+
+    int negative = 0;
+    if (p < end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p == end || (unsigned)(*p - '0') > 9) return 0;
+
+    unsigned int u = 0;
+    while (p < end && (unsigned)(*p - '0') <= 9) u = u * 10 + (unsigned)(*p++ - '0');
+    *value = negative ? (int)(0u - u) : (int)u;
+    *cursor = p;
+    return 1;
+}
+
+/**
+ * @brief Reads a whole file into memory with a single read loop.
+ *
+ * @return Malloc'd buffer (caller frees), or NULL on failure
+ */
+char *read_file(const char *filename, size_t *size) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        perror(filename);
+        close(fd);
+        return NULL;
+    }
+
+    char *buffer = (char *)malloc(st.st_size + 1);
+    size_t done = 0;
+    while (buffer && done < (size_t)st.st_size) {
+        ssize_t got = read(fd, buffer + done, st.st_size - done);
+        if (got <= 0) {
+            perror(filename);
+            free(buffer);
+            buffer = NULL;
+            break;
+        }
+        done += got;
+    }
+    close(fd);
+    *size = done;
+    return buffer;
+}
+
+/**
+ * @brief Loads a matrix in the text format.
+ *
+ * @return Newly allocated matrix, or NULL on error (message printed)
+ */
+Matrix *load_matrix_text(const char *filename) {
+    size_t size;
+    char *text = read_file(filename, &size);
+    if (text == NULL) return NULL;
+
+    const char *p = text, *end = text + size;
+    int rows, cols;
+    Matrix *matrix = NULL;
+    if (!parse_int(&p, end, &rows) || !parse_int(&p, end, &cols) || rows <= 0 || cols <= 0) {
+        fprintf(stderr, "Error: %s does not start with \"rows cols\".\n", filename);
+    } else if ((matrix = allocate_matrix(rows, cols)) == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+    } else {
+        for (int i = 0; i < rows && matrix; i++) {
+            int *row = &MAT_AT(matrix, i, 0);
+            for (int j = 0; j < cols; j++) {
+                if (!parse_int(&p, end, &row[j])) {
+                    fprintf(stderr, "Error: %s: element [%d][%d] is missing or invalid.\n",
+                            filename, i, j);
+                    free_matrix(matrix);
+                    matrix = NULL;
+                    break;
+                }
+            }
+        }
+    }
+    free(text);
+    return matrix;
+}
+
+/**
+ * @return 1 on success, 0 on error (message printed)
+ */
+int save_matrix_text(const char *filename, const Matrix *matrix) {
+    static OutBuffer out;
+    out.fp = fopen(filename, "w");
+    if (out.fp == NULL) {
+        perror(filename);
+        return 0;
+    }
+    out.used = 0;
+    out.failed = 0;
+
+    out_int(&out, matrix->rows);
+    out_char(&out, ' ');
+    out_int(&out, matrix->cols);
+    out_char(&out, '\n');
+    write_elements(matrix, &out, ' ');
+    out_flush(&out);
+
+    if (fclose(out.fp) != 0 || out.failed) {
+        perror(filename);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @return 1 on success, 0 on error (message printed)
+ */
+int save_matrix_binary(const char *filename, const Matrix *matrix) {
+    MatrixFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MATRIX_FILE_MAGIC, 4);
+    header.version = MATRIX_FILE_VERSION;
+    header.element_size = sizeof(int);
+    header.rows = matrix->rows;
+    header.cols = matrix->cols;
+    header.stride = matrix->stride;
+
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        perror(filename);
+        return 0;
+    }
+    size_t count = (size_t)matrix->rows * matrix->stride;
+    int ok = fwrite(&header, sizeof(header), 1, fp) == 1
+             && fwrite(matrix->data, sizeof(int), count, fp) == count;
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) perror(filename);
+    return ok;
+}
+
+/**
+ * @brief Validates a binary header against the size of the file.
+ */
+int check_header(const MatrixFileHeader *header, size_t file_size, const char *filename) {
+    if (file_size < sizeof(*header) || memcmp(header->magic, MATRIX_FILE_MAGIC, 4) != 0) {
+        fprintf(stderr, "Error: %s is not a binary matrix file.\n", filename);
+        return 0;
+    }
+    if (header->version != MATRIX_FILE_VERSION || header->element_size != sizeof(int)
+        || header->rows <= 0 || header->cols <= 0 || header->stride < header->cols
+        || header->stride % (MATRIX_ALIGNMENT / sizeof(int)) != 0
+        || file_size - sizeof(*header) < (size_t)header->rows * header->stride * sizeof(int)) {
+        fprintf(stderr, "Error: %s has an unsupported or inconsistent header.\n", filename);
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Maps a binary matrix file read-only and uses it in place: no parse
+ * and no copy, pages are faulted in as the multiply touches them.
+ *
+ * The returned matrix must not be written to; free_matrix unmaps it.
+ */
+Matrix *map_matrix_binary(const char *filename) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(MatrixFileHeader)) {
+        fprintf(stderr, "Error: %s is not a binary matrix file.\n", filename);
+        close(fd);
+        return NULL;
+    }
+    void *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        perror(filename);
+        return NULL;
+    }
+
+    const MatrixFileHeader *header = (const MatrixFileHeader *)base;
+    Matrix *matrix = (Matrix *)malloc(sizeof(Matrix));
+    if (!check_header(header, st.st_size, filename) || matrix == NULL) {
+        munmap(base, st.st_size);
+        free(matrix);
+        return NULL;
+    }
+    matrix->rows = header->rows;
+    matrix->cols = header->cols;
+    matrix->stride = header->stride;
+    matrix->data = (int *)((char *)base + sizeof(MatrixFileHeader));
+    matrix->mapped_bytes = st.st_size;
+    return matrix;
+}
+
+/**
+ * @brief Loads a binary matrix file into a newly allocated (writable) matrix.
+ */
+Matrix *load_matrix_binary(const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        perror(filename);
+        return NULL;
+    }
+    MatrixFileHeader header;
+    struct stat st;
+    Matrix *matrix = NULL;
+    if (fstat(fileno(fp), &st) != 0 || fread(&header, sizeof(header), 1, fp) != 1) {
+        fprintf(stderr, "Error: %s is not a binary matrix file.\n", filename);
+    } else if (check_header(&header, st.st_size, filename)) {
+        matrix = allocate_matrix(header.rows, header.cols);
+        int ok = matrix != NULL;
+        if (!ok) {
+            fprintf(stderr, "Memory allocation failed.\n");
+        } else if (header.stride == matrix->stride) {
+            size_t count = (size_t)header.rows * header.stride;
+            ok = fread(matrix->data, sizeof(int), count, fp) == count;
+        } else {
+            // Written with other padding: read each row's cols and skip the rest
+            long skip = (long)(header.stride - header.cols) * (long)sizeof(int);
+            for (int i = 0; ok && i < header.rows; i++)
+                ok = fread(&MAT_AT(matrix, i, 0), sizeof(int), header.cols, fp) == (size_t)header.cols
+                     && fseek(fp, skip, SEEK_CUR) == 0;
+        }
+        if (matrix != NULL && !ok) {
+            fprintf(stderr, "Error: %s is truncated.\n", filename);
+            free_matrix(matrix);
+            matrix = NULL;
+        }
+    }
+    fclose(fp);
+    return matrix;
+}
+
+/**
+ * @brief Opens a matrix file of either format, choosing by its magic bytes.
+ * Binary files are mapped rather than copied.
+ */
+Matrix *load_matrix_file(const char *filename) {
+    char magic[4] = {0};
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        perror(filename);
+        return NULL;
+    }
+    size_t got = fread(magic, 1, sizeof(magic), fp);
+    fclose(fp);
+    if (got == sizeof(magic) && memcmp(magic, MATRIX_FILE_MAGIC, 4) == 0)
+        return map_matrix_binary(filename);
+    return load_matrix_text(filename);
+}
+
+/**
+ * @brief Computes result = a * b using a tiled i-k-j loop order.
+ *
+ * The innermost loop walks a row of b and a row of result with unit stride,
+ * so it streams through cache lines and vectorises. Tiling over i, k and j
+ * keeps the working set of b and result resident in L2/L1 while a tile is
+ * reused across many rows of a.
+ *
+ * @param a Left operand (r1 x c1)
+ * @param b Right operand (c1 x c2)
+ * @param result Output (r1 x c2); overwritten
+ */
+void multiply_matrices(const Matrix *a, const Matrix *b, Matrix *result) {
+    int n = a->rows, shared = a->cols, m = b->cols;
+
+    for (int i = 0; i < n; i++)
+        memset(&MAT_AT(result, i, 0), 0, m * sizeof(int));
+
+    for (int ii = 0; ii < n; ii += BLOCK_I) {
+        int i_end = ii + BLOCK_I < n ? ii + BLOCK_I : n;
+        for (int kk = 0; kk < shared; kk += BLOCK_K) {
+            int k_end = kk + BLOCK_K < shared ? kk + BLOCK_K : shared;
+            for (int jj = 0; jj < m; jj += BLOCK_J) {
+                int j_end = jj + BLOCK_J < m ? jj + BLOCK_J : m;
+
+                for (int i = ii; i < i_end; i++) {
+                    int *restrict c_row = &MAT_AT(result, i, 0);
+                    for (int k = kk; k < k_end; k++) {
+                        int a_ik = MAT_AT(a, i, k);
+                        const int *restrict b_row = &MAT_AT(b, k, 0);
+                        for (int j = jj; j < j_end; j++)
+                            c_row[j] += a_ik * b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+/* ---------- Benchmark against the original int** implementation ---------- */
+
+/**
+ * @brief Original allocator: one malloc per row behind an array of pointers.
+ */
+int **legacy_allocate_matrix(int rows, int cols) {
+    int **matrix = (int **)malloc(rows * sizeof(int *));
+    if (matrix == NULL) return NULL;
+
     for (int i = 0; i < rows; i++) {
-        for (int j = 0; j < cols; j++) {
-            printf("%d\t", matrix[i][j]);
+        matrix[i] = (int *)malloc(cols * sizeof(int));
+        if (matrix[i] == NULL) {
+            for (int j = 0; j < i; j++) free(matrix[j]);
+            free(matrix);
+            return NULL;
         }
-        printf("\n");
     }
+    return matrix;
 }
 
-int main() {
+void legacy_free_matrix(int **matrix, int rows) {
+    for (int i = 0; i < rows; i++) {
+        free(matrix[i]);
+    }
+    free(matrix);
+}
+
+/**
+ * @brief Original naive i-j-k multiply, striding down columns of m2.
+ */
+void legacy_multiply(int **m1, int **m2, int **result, int r1, int c1, int c2) {
+    for (int i = 0; i < r1; i++) {
+        for (int j = 0; j < c2; j++) {
+            result[i][j] = 0;
+            for (int k = 0; k < c1; k++) {
+                result[i][j] += m1[i][k] * m2[k][j];
+            }
+        }
+    }
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * @brief Times both kernels on n x n matrices for n = 64, 128, ..., max_n.
+ *
+ * One multiply-add is counted as two operations. Results of the two kernels
+ * are compared element by element whenever the legacy kernel is run.
+ */
+int run_benchmark(int max_n) {
+    printf("%6s %16s %16s %10s\n", "n", "legacy GFLOP/s", "blocked GFLOP/s", "speedup");
+
+    for (int n = 64; n <= max_n; n *= 2) {
+        Matrix *a = allocate_matrix(n, n);
+        Matrix *b = allocate_matrix(n, n);
+        Matrix *c = allocate_matrix(n, n);
+        if (!a || !b || !c) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            free_matrix(a); free_matrix(b); free_matrix(c);
+            return 1;
+        }
+
+        srand(n);
+        for (int i = 0; i < n; i++) {
+            for (int j = 0; j < n; j++) {
+                MAT_AT(a, i, j) = rand() % 100 - 50;
+                MAT_AT(b, i, j) = rand() % 100 - 50;
+            }
+        }
+
+        double flops = 2.0 * n * n * n;
+        double t0 = now_seconds();
+        multiply_matrices(a, b, c);
+        double blocked = flops / (now_seconds() - t0) / 1e9;
+
+        if (n <= LEGACY_MAX_N) {
+            int **la = legacy_allocate_matrix(n, n);
+            int **lb = legacy_allocate_matrix(n, n);
+            int **lc = legacy_allocate_matrix(n, n);
+            if (!la || !lb || !lc) {
+                fprintf(stderr, "Memory allocation failed.\n");
+                return 1;
+            }
+            for (int i = 0; i < n; i++) {
+                memcpy(la[i], &MAT_AT(a, i, 0), n * sizeof(int));
+                memcpy(lb[i], &MAT_AT(b, i, 0), n * sizeof(int));
+            }
+
+            t0 = now_seconds();
+            legacy_multiply(la, lb, lc, n, n, n);
+            double legacy = flops / (now_seconds() - t0) / 1e9;
+
+            int mismatch = 0;
+            for (int i = 0; i < n && !mismatch; i++)
+                mismatch = memcmp(lc[i], &MAT_AT(c, i, 0), n * sizeof(int)) != 0;
+
+            printf("%6d %16.2f %16.2f %9.1fx%s\n", n, legacy, blocked, blocked / legacy,
+                   mismatch ? "  RESULT MISMATCH" : "");
+            legacy_free_matrix(la, n);
+            legacy_free_matrix(lb, n);
+            legacy_free_matrix(lc, n);
+        } else {
+            printf("%6d %16s %16.2f %10s\n", n, "(skipped)", blocked, "-");
+        }
+
+        free_matrix(a);
+        free_matrix(b);
+        free_matrix(c);
+    }
+    return 0;
+}
+
+/* ---------- File I/O benchmark ---------- */
+
+/**
+ * @brief Returns 1 if the two matrices have equal shape and elements.
+ */
+int matrices_equal(const Matrix *a, const Matrix *b) {
+    if (a->rows != b->rows || a->cols != b->cols) return 0;
+    for (int i = 0; i < a->rows; i++)
+        if (memcmp(&MAT_AT(a, i, 0), &MAT_AT(b, i, 0), a->cols * sizeof(int)) != 0) return 0;
+    return 1;
+}
+
+long file_size(const char *filename) {
+    struct stat st;
+    return stat(filename, &st) == 0 ? (long)st.st_size : 0;
+}
+
+void report_io(const char *label, const char *filename, double seconds, int correct) {
+    double mb = file_size(filename) / 1e6;
+    printf("%-28s %10.1f %10.3f %10.1f%s\n", label, mb, seconds, mb / seconds,
+           correct ? "" : "  MISMATCH");
+}
+
+/**
+ * @brief Writes and reads an n x n matrix with each method and reports MB/s
+ * of file data. Reads run right after the write, so files come from the
+ * page cache: the numbers measure parsing cost rather than the disk.
+ */
+int run_io_benchmark(int n) {
+    const char *text_file = "matmul_io_bench.txt";
+    const char *binary_file = "matmul_io_bench.bin";
+    Matrix *m = allocate_matrix(n, n);
+    if (m == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 1;
+    }
+    srand(n);
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < n; j++)
+            MAT_AT(m, i, j) = rand() % 200001 - 100000;
+
+    printf("%d x %d matrix\n", n, n);
+    printf("%-28s %10s %10s %10s\n", "method", "MB", "seconds", "MB/s");
+
+    // Baseline: one fprintf / fscanf call per element
+    double t0 = now_seconds();
+    FILE *fp = fopen(text_file, "w");
+    if (fp == NULL) {
+        perror(text_file);
+        free_matrix(m);
+        return 1;
+    }
+    fprintf(fp, "%d %d\n", n, n);
+    for (int i = 0; i < n; i++) {
+        for (int j = 0; j < n; j++) fprintf(fp, j + 1 < n ? "%d " : "%d", MAT_AT(m, i, j));
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    report_io("text write (fprintf)", text_file, now_seconds() - t0, 1);
+
+    t0 = now_seconds();
+    Matrix *loaded = NULL;
+    int rows, cols, ok = 0;
+    fp = fopen(text_file, "r");
+    if (fp && fscanf(fp, "%d %d", &rows, &cols) == 2 && (loaded = allocate_matrix(rows, cols))) {
+        ok = 1;
+        for (int i = 0; i < rows && ok; i++)
+            for (int j = 0; j < cols && ok; j++)
+                ok = fscanf(fp, "%d", &MAT_AT(loaded, i, j)) == 1;
+    }
+    if (fp) fclose(fp);
+    report_io("text read (fscanf)", text_file, now_seconds() - t0, ok && matrices_equal(m, loaded));
+    free_matrix(loaded);
+
+    // Custom formatter and parser
+    t0 = now_seconds();
+    ok = save_matrix_text(text_file, m);
+    report_io("text write (buffered)", text_file, now_seconds() - t0, ok);
+
+    t0 = now_seconds();
+    loaded = load_matrix_text(text_file);
+    report_io("text read (custom parser)", text_file, now_seconds() - t0,
+              loaded && matrices_equal(m, loaded));
+    free_matrix(loaded);
+
+    // Binary
+    t0 = now_seconds();
+    ok = save_matrix_binary(binary_file, m);
+    report_io("binary write", binary_file, now_seconds() - t0, ok);
+
+    t0 = now_seconds();
+    loaded = load_matrix_binary(binary_file);
+    report_io("binary read (fread)", binary_file, now_seconds() - t0,
+              loaded && matrices_equal(m, loaded));
+    free_matrix(loaded);
+
+    // The comparison touches every page, so the mapping time includes the faults
+    t0 = now_seconds();
+    loaded = map_matrix_binary(binary_file);
+    report_io("binary mmap + first touch", binary_file, now_seconds() - t0,
+              loaded && matrices_equal(m, loaded));
+    free_matrix(loaded);
+
+    remove(text_file);
+    remove(binary_file);
+    free_matrix(m);
+    return 0;
+}
+
+/**
+ * @brief Multiplies two matrix files and writes the product to a third.
+ */
+int run_file_multiply(const char *a_file, const char *b_file, const char *out_file) {
+    Matrix *a = load_matrix_file(a_file);
+    Matrix *b = a ? load_matrix_file(b_file) : NULL;
+    if (a == NULL || b == NULL) {
+        free_matrix(a);
+        return 1;
+    }
+    if (a->cols != b->rows) {
+        fprintf(stderr, "Error: Matrix multiplication not possible. "
+                        "Columns of first matrix (%d) must equal rows of second matrix (%d).\n",
+                a->cols, b->rows);
+        free_matrix(a);
+        free_matrix(b);
+        return 1;
+    }
+
+    Matrix *result = allocate_matrix(a->rows, b->cols);
+    if (result == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        free_matrix(a);
+        free_matrix(b);
+        return 1;
+    }
+    multiply_matrices(a, b, result);
+
+    size_t len = strlen(out_file);
+    int binary = len >= 4 && strcmp(out_file + len - 4, ".bin") == 0;
+    int ok = binary ? save_matrix_binary(out_file, result) : save_matrix_text(out_file, result);
+
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(result);
+    return ok ? 0 : 1;
+}
+
+int main(int argc, char *argv[]) {
     int r1, c1, r2, c2;
 
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        int max_n = argc > 2 ? atoi(argv[2]) : 4096;
+        return run_benchmark(max_n);
+    }
+    if (argc > 1 && strcmp(argv[1], "--io-bench") == 0) {
+        int n = argc > 2 ? atoi(argv[2]) : 4096;
+        if (n <= 0) {
+            fprintf(stderr, "Error: size must be positive.\n");
+            return 1;
+        }
+        return run_io_benchmark(n);
+    }
+    if (argc == 4) {
+        return run_file_multiply(argv[1], argv[2], argv[3]);
+    }
+
     // Input dimensions for first matrix
     printf("Enter rows and columns for first matrix: ");
     scanf("%d %d", &r1, &c1);
@@ -101,9 +802,9 @@ int main() {
     }
 
     // Allocate memory
-    int **m1 = allocate_matrix(r1, c1);
-    int **m2 = allocate_matrix(r2, c2);
-    int **result = allocate_matrix(r1, c2);
+    Matrix *m1 = allocate_matrix(r1, c1);
+    Matrix *m2 = allocate_matrix(r2, c2);
+    Matrix *result = allocate_matrix(r1, c2);
 
     if (!m1 || !m2 || !result) {
         fprintf(stderr, "Memory allocation failed.\n");
@@ -111,28 +812,21 @@ int main() {
     }
 
     // Read matrices
-    read_matrix(m1, r1, c1, "A");
-    read_matrix(m2, r2, c2, "B");
+    read_matrix(m1, "A");
+    read_matrix(m2, "B");
 
     // Perform multiplication
     // Result[i][j] = Sum(m1[i][k] * m2[k][j]) for k=0 to c1-1
-    for (int i = 0; i < r1; i++) {
-        for (int j = 0; j < c2; j++) {
-            result[i][j] = 0; // Initialize
-            for (int k = 0; k < c1; k++) {
-                result[i][j] += m1[i][k] * m2[k][j];
-            }
-        }
-    }
+    multiply_matrices(m1, m2, result);
 
     // Output result
     printf("\nResultant Matrix:\n");
-    print_matrix(result, r1, c2);
+    print_matrix(result);
 
     // Free memory
-    free_matrix(m1, r1);
-    free_matrix(m2, r2);
-    free_matrix(result, r1);
+    free_matrix(m1);
+    free_matrix(m2);
+    free_matrix(result);
 
     return 0;
 }
@@ -7,6 +7,11 @@
  * 2. Algorithm implementation (Sieve of Eratosthenes)
  * 3. Input validation
  * 4. Efficient boolean flagging
+ *
+ * For large limits see 05_advanced_algorithms/prime_sieve_segmented.c,
+ * which uses one bit per odd number and bounded memory. To count primes
+ * in a range or find the n-th prime without listing them all, see
+ * 05_advanced_algorithms/prime_counting.c.
  */
 
 #include <stdio.h>
@@ -22,7 +27,8 @@ void sieve_of_eratosthenes(int limit) {
     // We create an array of booleans.
     // is_prime[i] will be true if i is prime, false otherwise.
     // We use (limit + 1) to accommodate the number 'limit' itself.
-    bool *is_prime = (bool *)malloc((limit + 1) * sizeof(bool));
+    // (size_t) so that limit = INT_MAX does not overflow to 0 bytes.
+    bool *is_prime = (bool *)malloc(((size_t)limit + 1) * sizeof(bool));
 
     if (is_prime == NULL) {
         fprintf(stderr, "Memory allocation failed!\n");
@@ -31,7 +37,7 @@ void sieve_of_eratosthenes(int limit) {
 
     // Initialize all entries as true. A value in array[i] will
     // finally be false if i is Not a prime, else true.
-    for (int i = 0; i <= limit; i++) {
+    for (long long i = 0; i <= limit; i++) {
         is_prime[i] = true;
     }
 
@@ -41,12 +47,14 @@ void sieve_of_eratosthenes(int limit) {
 
     // Iterate from 2 to sqrt(limit).
     // If p is prime, then all multiples of p are not prime.
-    for (int p = 2; p * p <= limit; p++) {
+    // p <= limit / p is p * p <= limit without overflowing int.
+    for (int p = 2; p <= limit / p; p++) {
         // If is_prime[p] is not changed, then it is a prime
         if (is_prime[p] == true) {
             // Update all multiples of p greater than or equal to the square of it
             // numbers which are multiple of p and are less than p^2 are already been marked.
-            for (int i = p * p; i <= limit; i += p) {
+            // i is wider than int because i += p can pass INT_MAX.
+            for (long long i = (long long)p * p; i <= limit; i += p) {
                 is_prime[i] = false;
             }
         }
@@ -55,9 +63,9 @@ void sieve_of_eratosthenes(int limit) {
     // Print all prime numbers
     printf("Prime numbers up to %d are:\n", limit);
     int count = 0;
-    for (int p = 2; p <= limit; p++) {
+    for (long long p = 2; p <= limit; p++) {
         if (is_prime[p]) {
-            printf("%d ", p);
+            printf("%lld ", p);
             count++;
             // Print a newline every 10 numbers for better formatting
             if (count % 10 == 0) {
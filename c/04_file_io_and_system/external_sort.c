@@ -0,0 +1,754 @@
+/**
+ * @file external_sort.c
+ * @brief Sorts files of integers that are larger than the memory budget.
+ *
+ * This program demonstrates:
+ * 1. External merge sort: sorted runs are built in memory and written to
+ *    temporary files, then merged
+ * 2. A loser tree (tournament tree) that picks the smallest head among k
+ *    runs with one comparison per tree level
+ * 3. Large block reads and writes with read()/write() and
+ *    posix_fadvise(SEQUENTIAL) instead of per-element stdio calls
+ * 4. Multi-pass merging when the number of runs exceeds the fan-in the
+ *    memory budget allows
+ * 5. Binary (native int32) and text (one integer per line) formats
+ * 6. Per-phase timing and throughput reporting
+ *
+ * Usage:
+ * gcc -O2 external_sort.c -o external_sort
+ * ./external_sort [-t] [-m MB] [-T tmpdir] input output
+ *     -t      input and output are text, one integer per line (default binary)
+ *     -m MB   memory budget in MiB (default 256)
+ *     -T dir  directory for temporary run files (default: $TMPDIR or /tmp)
+ * ./external_sort --generate count file [-t]   (write random test data)
+ * ./external_sort --check file [-t]            (verify a file is sorted)
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#define MIB (1024 * 1024)
+#define TEXT_CHUNK (1 << 20)           // Bytes of text parsed at a time
+#define MIN_MERGE_BUFFER (256 * 1024)  // Smallest useful read buffer per run
+#define MAX_FAN_IN 512
+#define RADIX 256
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void *xmalloc(size_t bytes) {
+    void *p = malloc(bytes ? bytes : 1);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation failed (%zu bytes).\n", bytes);
+        exit(1);
+    }
+    return p;
+}
+
+/* ---------- Block I/O ---------- */
+
+/**
+ * @brief Reads up to `bytes`, retrying short reads.
+ *
+ * @return Bytes read (less than requested only at end of file), or -1
+ */
+ssize_t read_fully(int fd, void *buf, size_t bytes) {
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t got = read(fd, (char *)buf + done, bytes - done);
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        if (got == 0) break;
+        done += got;
+    }
+    return (ssize_t)done;
+}
+
+int write_fully(int fd, const void *buf, size_t bytes) {
+    size_t done = 0;
+    while (done < bytes) {
+        ssize_t put = write(fd, (const char *)buf + done, bytes - done);
+        if (put < 0) {
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        done += put;
+    }
+    return 1;
+}
+
+/**
+ * An integer source: a binary file read straight into the caller's array,
+ * or a text file parsed from a chunk buffer.
+ */
+typedef struct {
+    int fd;
+    int text;
+    char *chunk;        // Text only
+    size_t pos, len;    // Unparsed bytes are chunk[pos..len)
+    int eof;
+    long long line;     // For error messages
+    long long bytes;    // Total bytes read
+} IntReader;
+
+void reader_open(IntReader *r, int fd, int text) {
+    memset(r, 0, sizeof(*r));
+    r->fd = fd;
+    r->text = text;
+    r->line = 1;
+    if (text) r->chunk = (char *)xmalloc(TEXT_CHUNK);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+}
+
+void reader_close(IntReader *r) {
+    free(r->chunk);
+    close(r->fd);
+}
+
+/**
+ * @brief Moves the unparsed tail to the front of the chunk and reads more.
+ *
+ * @return 0 on success, -1 on read error
+ */
+static int refill_text(IntReader *r) {
+    size_t keep = r->len - r->pos;
+    memmove(r->chunk, r->chunk + r->pos, keep);
+    r->pos = 0;
+    r->len = keep;
+    ssize_t got = read_fully(r->fd, r->chunk + keep, TEXT_CHUNK - keep);
+    if (got < 0) return -1;
+    if (got == 0) r->eof = 1;
+    r->len += got;
+    r->bytes += got;
+    return 0;
+}
+
+/**
+ * @brief Reads up to max integers into dst.
+ *
+ * @return Number read (0 at end of input), or -1 on error (message printed)
+ */
+ssize_t read_ints(IntReader *r, int32_t *dst, size_t max) {
+    if (!r->text) {
+        ssize_t got = read_fully(r->fd, dst, max * sizeof(int32_t));
+        if (got < 0) {
+            perror("read");
+            return -1;
+        }
+        r->bytes += got;
+        if (got % sizeof(int32_t) != 0) {
+            fprintf(stderr, "Error: binary input size is not a multiple of 4 bytes.\n");
+            return -1;
+        }
+        return got / (ssize_t)sizeof(int32_t);
+    }
+
+    size_t count = 0;
+    while (count < max) {
+        // Skip separators
+        while (r->pos < r->len && (r->chunk[r->pos] == '\n' || r->chunk[r->pos] == ' '
+                                   || r->chunk[r->pos] == '\r' || r->chunk[r->pos] == '\t')) {
+            if (r->chunk[r->pos] == '\n') r->line++;
+            r->pos++;
+        }
+        // A number must lie entirely in the buffer: 12 bytes is the longest
+        // int32 plus a terminator, so refill when fewer remain
+        if (r->len - r->pos < 12 && !r->eof) {
+            if (refill_text(r) < 0) {
+                perror("read");
+                return -1;
+            }
+            continue;
+        }
+        if (r->pos == r->len) break;
+
+        const char *p = r->chunk + r->pos, *end = r->chunk + r->len;
+        int negative = 0;
+        if (*p == '-' || *p == '+') negative = *p++ == '-';
+        if (p == end || (unsigned)(*p - '0') > 9) {
+            fprintf(stderr, "Error: line %lld is not an integer.\n", r->line);
+            return -1;
+        }
+        int64_t v = 0;
+        while (p < end && (unsigned)(*p - '0') <= 9 && v <= (int64_t)INT32_MAX + 1)
+            v = v * 10 + (*p++ - '0');
+        if (negative) v = -v;
+        if (v < INT32_MIN || v > INT32_MAX || (p < end && (unsigned)(*p - '0') <= 9)) {
+            fprintf(stderr, "Error: line %lld is out of the int32 range.\n", r->line);
+            return -1;
+        }
+        dst[count++] = (int32_t)v;
+        r->pos = p - r->chunk;
+    }
+    return (ssize_t)count;
+}
+
+/**
+ * An integer sink with a byte buffer flushed in large writes.
+ */
+typedef struct {
+    int fd;
+    int text;
+    char *buf;
+    size_t cap, len;
+    int failed;
+    long long bytes;   // Total bytes written
+} IntWriter;
+
+void writer_open(IntWriter *w, int fd, int text, size_t buffer_bytes) {
+    memset(w, 0, sizeof(*w));
+    w->fd = fd;
+    w->text = text;
+    w->cap = buffer_bytes < 64 ? 64 : buffer_bytes;
+    w->buf = (char *)xmalloc(w->cap);
+}
+
+void writer_flush(IntWriter *w) {
+    if (w->len && !write_fully(w->fd, w->buf, w->len)) w->failed = 1;
+    w->bytes += w->len;
+    w->len = 0;
+}
+
+/**
+ * @return 1 on success, 0 if any write failed (message printed)
+ */
+int writer_close(IntWriter *w, int close_fd) {
+    writer_flush(w);
+    free(w->buf);
+    if (close_fd && close(w->fd) != 0) w->failed = 1;
+    if (w->failed) perror("write");
+    return !w->failed;
+}
+
+static inline void write_int(IntWriter *w, int32_t value) {
+    if (!w->text) {
+        if (w->len + sizeof(value) > w->cap) writer_flush(w);
+        memcpy(w->buf + w->len, &value, sizeof(value));
+        w->len += sizeof(value);
+        return;
+    }
+    if (w->len + 12 > w->cap) writer_flush(w);
+    char digits[11];
+    int n = 0;
+    uint32_t u = value < 0 ? 0u - (uint32_t)value : (uint32_t)value;
+    do {
+        digits[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    char *out = w->buf + w->len;
+    if (value < 0) *out++ = '-';
+    while (n) *out++ = digits[--n];
+    *out++ = '\n';
+    w->len = out - w->buf;
+}
+
+void write_ints(IntWriter *w, const int32_t *src, size_t n) {
+    if (!w->text) {
+        writer_flush(w);
+        if (!write_fully(w->fd, src, n * sizeof(int32_t))) w->failed = 1;
+        w->bytes += n * sizeof(int32_t);
+        return;
+    }
+    for (size_t i = 0; i < n; i++) write_int(w, src[i]);
+}
+
+/* ---------- In-memory sort ---------- */
+
+/**
+ * @brief LSD radix sort of int32 keys (sign bit flipped so the order is
+ * unsigned), ping-ponging between keys and scratch.
+ */
+void sort_run(int32_t *keys, int32_t *scratch, size_t n) {
+    uint32_t *a = (uint32_t *)keys, *b = (uint32_t *)scratch;
+    size_t counts[4][RADIX];
+    memset(counts, 0, sizeof(counts));
+    for (size_t i = 0; i < n; i++) {
+        a[i] ^= 0x80000000u;
+        for (int p = 0; p < 4; p++) counts[p][(a[i] >> (8 * p)) & (RADIX - 1)]++;
+    }
+    for (int p = 0; p < 4; p++) {
+        size_t offset[RADIX], sum = 0;
+        for (int d = 0; d < RADIX; d++) {
+            offset[d] = sum;
+            sum += counts[p][d];
+        }
+        for (size_t i = 0; i < n; i++) b[offset[(a[i] >> (8 * p)) & (RADIX - 1)]++] = a[i];
+        uint32_t *t = a;
+        a = b;
+        b = t;
+    }
+    // Four passes: the result is back in keys
+    for (size_t i = 0; i < n; i++) a[i] ^= 0x80000000u;
+}
+
+/* ---------- Temporary run files ---------- */
+
+/**
+ * Runs are named files that are closed once written and reopened only while
+ * being merged, so at most fan_in + 1 files are open however many runs the
+ * input produces. Runs [first, count) are pending; consumed runs are already
+ * unlinked. Their paths stay allocated until the end so the signal handler
+ * never reads freed memory.
+ */
+typedef struct {
+    char **paths;
+    int first, count, capacity;
+} RunList;
+
+static RunList *live_runs;   // Removed by the signal handler
+
+void remove_pending_runs(RunList *runs) {
+    for (int i = runs->first; i < runs->count; i++) unlink(runs->paths[i]);
+    runs->first = runs->count;
+}
+
+static void on_fatal_signal(int sig) {
+    // unlink() is async-signal-safe; a run being appended is not yet listed
+    // and is left behind, which a crash mid-write would do anyway
+    if (live_runs)
+        for (int i = live_runs->first; i < live_runs->count; i++) unlink(live_runs->paths[i]);
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+void install_cleanup(RunList *runs) {
+    live_runs = runs;
+    signal(SIGINT, on_fatal_signal);
+    signal(SIGTERM, on_fatal_signal);
+    signal(SIGHUP, on_fatal_signal);
+}
+
+void runs_add(RunList *runs, char *path) {
+    // Block the cleanup signals while the arrays may move
+    sigset_t block, old;
+    sigemptyset(&block);
+    sigaddset(&block, SIGINT);
+    sigaddset(&block, SIGTERM);
+    sigaddset(&block, SIGHUP);
+    sigprocmask(SIG_BLOCK, &block, &old);
+    if (runs->count == runs->capacity) {
+        int new_capacity = runs->capacity ? 2 * runs->capacity : 16;
+        char **new_paths = (char **)realloc(runs->paths, new_capacity * sizeof(char *));
+        if (!new_paths) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            unlink(path);
+            remove_pending_runs(runs);
+            exit(1);
+        }
+        runs->paths = new_paths;
+        runs->capacity = new_capacity;
+    }
+    runs->paths[runs->count++] = path;
+    sigprocmask(SIG_SETMASK, &old, NULL);
+}
+
+/**
+ * @brief Creates a temporary file in `dir`.
+ *
+ * @param path Receives the malloc'd path, which the caller must unlink
+ * @return File descriptor, or -1 on error (message printed)
+ */
+int create_temp_file(const char *dir, char **path) {
+    size_t len = strlen(dir) + sizeof("/external_sort.XXXXXX");
+    *path = (char *)xmalloc(len);
+    snprintf(*path, len, "%s/external_sort.XXXXXX", dir);
+    int fd = mkstemp(*path);
+    if (fd < 0) {
+        perror(*path);
+        free(*path);
+        *path = NULL;
+    }
+    return fd;
+}
+
+/* ---------- Loser tree k-way merge ---------- */
+
+typedef struct {
+    IntReader in;
+    int32_t *vals;
+    size_t pos, len, cap;
+    int done;
+} RunCursor;
+
+static int cursor_fill(RunCursor *c) {
+    ssize_t got = read_ints(&c->in, c->vals, c->cap);
+    if (got < 0) return -1;
+    c->pos = 0;
+    c->len = got;
+    c->done = got == 0;
+    return 0;
+}
+
+/**
+ * Internal node t (1 <= t < k) stores the loser of the match between its
+ * subtrees; leaf i sits at position k + i. After the winner advances, only
+ * the matches on its path to the root are replayed: log2(k) comparisons.
+ *
+ * Each run's head is packed into one 64-bit key, (value + 2^31) << 32 | run,
+ * so a single unsigned comparison orders by value and breaks ties by run
+ * index. An exhausted run gets EXHAUSTED, which loses to everything.
+ */
+#define EXHAUSTED UINT64_MAX
+
+typedef struct {
+    int k;
+    uint64_t *loser_key;  // Key of the loser stored at each internal node
+    uint64_t *head;       // Current key of each run
+} LoserTree;
+
+static inline uint64_t pack_key(int32_t value, int run) {
+    return ((uint64_t)((int64_t)value + 2147483648LL) << 32) | (uint32_t)run;
+}
+
+static uint64_t tree_build(LoserTree *t, int node) {
+    if (node >= t->k) return t->head[node - t->k];
+    uint64_t left = tree_build(t, 2 * node), right = tree_build(t, 2 * node + 1);
+    t->loser_key[node] = left < right ? right : left;
+    return left < right ? left : right;
+}
+
+/**
+ * @brief Replays the path of run `run`, whose head changed to `key`.
+ *
+ * @return Key of the new overall winner
+ */
+static inline uint64_t tree_replay(LoserTree *t, int run, uint64_t key) {
+    // Each match is a min/max pair (conditional moves): on random data the
+    // outcome is a coin flip, which a branch would mispredict half the time
+    for (int node = (run + t->k) / 2; node >= 1; node /= 2) {
+        uint64_t l = t->loser_key[node];
+        uint64_t low = l < key ? l : key;
+        t->loser_key[node] = l ^ key ^ low;
+        key = low;
+    }
+    return key;
+}
+
+/**
+ * @brief Merges the k oldest pending runs of `runs` into `out`.
+ *
+ * The runs are consumed whether or not the merge succeeds: their files are
+ * closed and unlinked and runs->first moves past them.
+ *
+ * @param buffer_bytes Read buffer per run
+ * @return Integers written, or -1 on error
+ */
+long long merge_runs(RunList *runs, int k, IntWriter *out, size_t buffer_bytes) {
+    int first = runs->first;
+    RunCursor *cursors = (RunCursor *)xmalloc(k * sizeof(RunCursor));
+    LoserTree tree = { k, (uint64_t *)xmalloc((k + 1) * sizeof(uint64_t)),
+                       (uint64_t *)xmalloc(k * sizeof(uint64_t)) };
+    long long written = 0;
+    int opened = 0;
+
+    for (int i = 0; i < k; i++) {
+        int fd = open(runs->paths[first + i], O_RDONLY);
+        if (fd < 0) {
+            perror(runs->paths[first + i]);
+            written = -1;
+            goto cleanup;
+        }
+        reader_open(&cursors[i].in, fd, 0);
+        cursors[i].cap = buffer_bytes / sizeof(int32_t);
+        cursors[i].vals = (int32_t *)xmalloc(cursors[i].cap * sizeof(int32_t));
+        opened++;
+        if (cursor_fill(&cursors[i]) < 0) {
+            written = -1;
+            goto cleanup;
+        }
+        tree.head[i] = cursors[i].done ? EXHAUSTED : pack_key(cursors[i].vals[0], i);
+    }
+
+    uint64_t winner = tree_build(&tree, 1);
+    while (winner != EXHAUSTED) {
+        int run = (int)(uint32_t)winner;
+        RunCursor *c = &cursors[run];
+        write_int(out, (int32_t)((int64_t)(winner >> 32) - 2147483648LL));
+        written++;
+        if (++c->pos == c->len && cursor_fill(c) < 0) {
+            written = -1;
+            break;
+        }
+        winner = tree_replay(&tree, run, c->done ? EXHAUSTED : pack_key(c->vals[c->pos], run));
+    }
+
+cleanup:
+    for (int i = 0; i < opened; i++) {
+        free(cursors[i].vals);
+        reader_close(&cursors[i].in);
+    }
+    for (int i = 0; i < k; i++) unlink(runs->paths[first + i]);
+    runs->first = first + k;
+    free(cursors);
+    free(tree.loser_key);
+    free(tree.head);
+    return written;
+}
+
+/* ---------- Driver ---------- */
+
+typedef struct {
+    int text;
+    size_t budget;       // Bytes
+    const char *tmpdir;
+} SortOptions;
+
+int external_sort(const char *input, const char *output, const SortOptions *opt) {
+    int in_fd = open(input, O_RDONLY);
+    if (in_fd < 0) {
+        perror(input);
+        return 1;
+    }
+
+    // Phase 1: runs of budget / 8 ints (keys + radix scratch; the text
+    // chunk buffer is small next to them)
+    size_t run_ints = opt->budget / (2 * sizeof(int32_t));
+    int32_t *keys = (int32_t *)xmalloc(run_ints * sizeof(int32_t));
+    int32_t *scratch = (int32_t *)xmalloc(run_ints * sizeof(int32_t));
+
+    RunList runs = {0};
+    install_cleanup(&runs);
+    IntReader reader;
+    reader_open(&reader, in_fd, opt->text);
+    long long total = 0;
+    double t_read = 0, t_sort = 0, t_write = 0, t_start = now_seconds();
+    int status = 0;
+
+    while (1) {
+        double t0 = now_seconds();
+        ssize_t n = read_ints(&reader, keys, run_ints);
+        double t1 = now_seconds();
+        t_read += t1 - t0;
+        if (n < 0) {
+            status = 1;
+            break;
+        }
+        if (n == 0) break;
+
+        sort_run(keys, scratch, n);
+        double t2 = now_seconds();
+        t_sort += t2 - t1;
+
+        char *path;
+        int fd = create_temp_file(opt->tmpdir, &path);
+        if (fd < 0) {
+            status = 1;
+            break;
+        }
+        int ok = write_fully(fd, keys, n * sizeof(int32_t));
+        if (close(fd) != 0) ok = 0;
+        if (!ok) {
+            perror("write");
+            unlink(path);
+            free(path);
+            status = 1;
+            break;
+        }
+        runs_add(&runs, path);
+        total += n;
+        t_write += now_seconds() - t2;
+        if ((size_t)n < run_ints) break;
+    }
+    long long input_bytes = reader.bytes;
+    reader_close(&reader);
+    free(keys);
+    free(scratch);
+    double t_phase1 = now_seconds() - t_start;
+
+    if (status == 0) {
+        printf("Phase 1: %lld integers in %d runs of up to %zu (%.1f MiB budget)\n",
+               total, runs.count, run_ints, opt->budget / (double)MIB);
+        printf("  read %.2f s, sort %.2f s, write %.2f s -> %.1f MB/s\n", t_read, t_sort,
+               t_write, input_bytes / t_phase1 / 1e6);
+    }
+
+    // Phase 2: merge. Each of k readers and the writer get an equal share
+    int fan_in = (int)(opt->budget / MIN_MERGE_BUFFER) - 1;
+    if (fan_in > MAX_FAN_IN) fan_in = MAX_FAN_IN;
+    // Leave room for stdio and the merge output under the open-file limit
+    struct rlimit files;
+    if (getrlimit(RLIMIT_NOFILE, &files) == 0 && files.rlim_cur != RLIM_INFINITY
+        && (rlim_t)fan_in + 4 > files.rlim_cur)
+        fan_in = files.rlim_cur > 4 ? (int)files.rlim_cur - 4 : 0;
+    if (fan_in < 2) fan_in = 2;
+
+    double t_merge = now_seconds();
+    int intermediate = 0;
+    // Intermediate passes: merge the oldest fan_in runs into one new run
+    // until a single pass can finish the job
+    while (status == 0 && runs.count - runs.first > fan_in) {
+        char *path;
+        int fd = create_temp_file(opt->tmpdir, &path);
+        if (fd < 0) {
+            status = 1;
+            break;
+        }
+        size_t share = opt->budget / (fan_in + 1);
+        IntWriter w;
+        writer_open(&w, fd, 0, share);
+        long long n = merge_runs(&runs, fan_in, &w, share);
+        if (!writer_close(&w, 1) || n < 0) {
+            unlink(path);
+            free(path);
+            status = 1;
+            break;
+        }
+        runs_add(&runs, path);
+        intermediate++;
+    }
+
+    if (status == 0) {
+        int out_fd = open(output, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (out_fd < 0) {
+            perror(output);
+            status = 1;
+        } else {
+            int k = runs.count - runs.first;
+            size_t share = opt->budget / (k + 1);
+            IntWriter w;
+            writer_open(&w, out_fd, opt->text, share);
+            long long n = k > 0 ? merge_runs(&runs, k, &w, share) : 0;
+            long long output_bytes = w.bytes + w.len;
+            if (!writer_close(&w, 1) || n != total) status = 1;
+
+            t_merge = now_seconds() - t_merge;
+            if (status == 0) {
+                printf("Phase 2: %d intermediate %d-way merges, final %d-way merge, "
+                       "%.2f s -> %.1f MB/s\n", intermediate, fan_in, k, t_merge,
+                       output_bytes / t_merge / 1e6);
+                double t_total = t_phase1 + t_merge;
+                printf("Total: %.1f MB in %.2f s -> %.1f MB/s\n", input_bytes / 1e6, t_total,
+                       input_bytes / t_total / 1e6);
+            }
+        }
+    }
+
+    remove_pending_runs(&runs);
+    live_runs = NULL;
+    for (int i = 0; i < runs.count; i++) free(runs.paths[i]);
+    free(runs.paths);
+    return status;
+}
+
+/* ---------- Test data ---------- */
+
+int generate_file(const char *filename, long long count, int text) {
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror(filename);
+        return 1;
+    }
+    IntWriter w;
+    writer_open(&w, fd, text, 4 * MIB);
+    uint64_t s = 88172645463325252ull ^ (uint64_t)count;
+    for (long long i = 0; i < count; i++) {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        write_int(&w, (int32_t)(s >> 32));
+    }
+    return writer_close(&w, 1) ? 0 : 1;
+}
+
+int check_file(const char *filename, int text) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        perror(filename);
+        return 1;
+    }
+    IntReader r;
+    reader_open(&r, fd, text);
+    int32_t *buf = (int32_t *)xmalloc(MIB * sizeof(int32_t));
+    long long count = 0;
+    int32_t prev = INT32_MIN;
+    ssize_t n;
+    int sorted = 1;
+    while (sorted && (n = read_ints(&r, buf, MIB)) > 0) {
+        for (ssize_t i = 0; i < n; i++) {
+            if (buf[i] < prev) {
+                fprintf(stderr, "Not sorted at element %lld.\n", count + i);
+                sorted = 0;
+                break;
+            }
+            prev = buf[i];
+        }
+        count += n;
+    }
+    free(buf);
+    reader_close(&r);
+    if (sorted && n == 0) printf("%s: %lld integers, sorted.\n", filename, count);
+    return sorted && n == 0 ? 0 : 1;
+}
+
+void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-t] [-m MB] [-T tmpdir] input output\n"
+                    "       %s --generate count file [-t]\n"
+                    "       %s --check file [-t]\n", prog, prog, prog);
+}
+
+int main(int argc, char *argv[]) {
+    SortOptions opt;
+    opt.text = 0;
+    opt.budget = 256 * (size_t)MIB;
+    opt.tmpdir = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+
+    const char *mode = NULL, *args[2] = { NULL, NULL };
+    int nargs = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-t") == 0) {
+            opt.text = 1;
+        } else if (strcmp(argv[i], "-m") == 0 && i + 1 < argc) {
+            long mb = atol(argv[++i]);
+            if (mb < 1) {
+                fprintf(stderr, "Error: memory budget must be at least 1 MiB.\n");
+                return 1;
+            }
+            opt.budget = (size_t)mb * MIB;
+        } else if (strcmp(argv[i], "-T") == 0 && i + 1 < argc) {
+            opt.tmpdir = argv[++i];
+        } else if (strcmp(argv[i], "--generate") == 0 || strcmp(argv[i], "--check") == 0) {
+            mode = argv[i];
+        } else if (nargs < 2) {
+            args[nargs++] = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (mode && strcmp(mode, "--generate") == 0) {
+        if (nargs != 2 || atoll(args[0]) < 0) {
+            usage(argv[0]);
+            return 1;
+        }
+        return generate_file(args[1], atoll(args[0]), opt.text);
+    }
+    if (mode) {
+        if (nargs != 1) {
+            usage(argv[0]);
+            return 1;
+        }
+        return check_file(args[0], opt.text);
+    }
+    if (nargs != 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    return external_sort(args[0], args[1], &opt);
+}
@@ -0,0 +1,933 @@
+/**
+ * @file contraction_hierarchies.c
+ * @brief Contraction Hierarchies (CH) for fast point-to-point shortest paths.
+ *
+ * This program demonstrates:
+ * 1. Node ordering by edge difference with lazy priority updates
+ * 2. Node contraction with bounded witness searches and shortcut insertion
+ * 3. Serializing the resulting upward/downward search graphs to a binary file
+ * 4. Bidirectional upward Dijkstra queries with stall-on-demand
+ * 5. Benchmarking preprocessing time, index size and query latency percentiles
+ *    against plain (early-exit) Dijkstra, plus a distance cross-check on a
+ *    graph where most arcs weigh 0
+ *
+ * Graph file format is the same as dijkstra_point_to_point.c:
+ *   n m
+ *   x y        (n lines, vertex coordinates - read but unused here)
+ *   u v w      (m lines, directed edge u -> v with integer weight w >= 0)
+ *
+ * Usage:
+ * gcc -O2 contraction_hierarchies.c -o ch -lm
+ * ./ch                                  (random 200x200 grid graph)
+ * ./ch graph.txt [index.ch] [queries]   (preprocess a graph file)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#define INF_DIST LLONG_MAX
+#define DEFAULT_GRID_SIDE 200
+#define DEFAULT_QUERIES 1000
+#define DEFAULT_INDEX_FILE "graph.ch"
+#define ZERO_WEIGHT_NODES 2000    // Size of the zero-weight cross-check graph
+#define SIMULATE_SETTLE_LIMIT 50  // Witness search budget when estimating priorities
+#define CONTRACT_SETTLE_LIMIT 500 // Witness search budget when adding shortcuts
+#define HIGHWAY_SPACING 8         // Every 8th grid row/column is a fast road
+#define CH_MAGIC "CH01"
+
+/* ---------- Shared helpers ---------- */
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+void *xmalloc(size_t size) {
+    void *p = malloc(size ? size : 1);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    return p;
+}
+
+/* ---------- Min Heap (lazy deletion) ---------- */
+
+typedef struct {
+    long long key;
+    int v;
+} HeapItem;
+
+typedef struct {
+    HeapItem *items;
+    int size;
+    int capacity;
+} MinHeap;
+
+void heap_push(MinHeap *h, long long key, int v) {
+    if (h->size == h->capacity) {
+        h->capacity = h->capacity ? h->capacity * 2 : 64;
+        h->items = (HeapItem *)realloc(h->items, h->capacity * sizeof(HeapItem));
+        if (h->items == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+
+    int i = h->size++;
+    while (i > 0 && h->items[(i - 1) / 2].key > key) {
+        h->items[i] = h->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->items[i].key = key;
+    h->items[i].v = v;
+}
+
+HeapItem heap_pop(MinHeap *h) {
+    HeapItem top = h->items[0];
+    HeapItem last = h->items[--h->size];
+    int i = 0;
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && h->items[child + 1].key < h->items[child].key)
+            child++;
+        if (h->items[child].key >= last.key) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->size > 0) h->items[i] = last;
+    return top;
+}
+
+long long heap_top_key(const MinHeap *h) {
+    return h->size ? h->items[0].key : INF_DIST;
+}
+
+/**
+ * Distance labels reset in O(1) between searches by bumping `round`.
+ */
+typedef struct {
+    long long *dist;
+    unsigned *seen;
+    unsigned *done;
+    unsigned round;
+    MinHeap heap;
+} SearchSide;
+
+void init_side(SearchSide *s, int n) {
+    s->dist = (long long *)xmalloc(n * sizeof(long long));
+    s->seen = (unsigned *)calloc(n, sizeof(unsigned));
+    s->done = (unsigned *)calloc(n, sizeof(unsigned));
+    if (!s->seen || !s->done) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    s->round = 0;
+    s->heap.items = NULL;
+    s->heap.size = s->heap.capacity = 0;
+}
+
+void free_side(SearchSide *s) {
+    free(s->dist);
+    free(s->seen);
+    free(s->done);
+    free(s->heap.items);
+}
+
+void reset_side(SearchSide *s) {
+    s->round++;
+    s->heap.size = 0;
+}
+
+long long side_dist(const SearchSide *s, int v) {
+    return s->seen[v] == s->round ? s->dist[v] : INF_DIST;
+}
+
+int side_relax(SearchSide *s, int v, long long d) {
+    if (s->seen[v] != s->round || d < s->dist[v]) {
+        s->seen[v] = s->round;
+        s->dist[v] = d;
+        return 1;
+    }
+    return 0;
+}
+
+/* ---------- Static graph (CSR) ---------- */
+
+typedef struct {
+    int n;
+    int *start, *to, *w;
+} StaticGraph;
+
+void free_static_graph(StaticGraph *g) {
+    free(g->start);
+    free(g->to);
+    free(g->w);
+}
+
+/**
+ * @brief Plain Dijkstra on the input graph that stops once target is settled.
+ */
+long long dijkstra_query(const StaticGraph *g, SearchSide *s, int src, int target,
+                         long long *settled) {
+    reset_side(s);
+    side_relax(s, src, 0);
+    heap_push(&s->heap, 0, src);
+
+    while (s->heap.size > 0) {
+        HeapItem it = heap_pop(&s->heap);
+        int u = it.v;
+        if (s->done[u] == s->round) continue;
+        s->done[u] = s->round;
+        (*settled)++;
+        if (u == target) break;
+
+        for (int e = g->start[u]; e < g->start[u + 1]; e++)
+            if (side_relax(s, g->to[e], it.key + g->w[e]))
+                heap_push(&s->heap, it.key + g->w[e], g->to[e]);
+    }
+    return side_dist(s, target);
+}
+
+/* ---------- Dynamic graph used during contraction ---------- */
+
+typedef struct {
+    int to;
+    int w;
+} Arc;
+
+typedef struct {
+    Arc *arcs;
+    int size;
+    int capacity;
+} ArcList;
+
+typedef struct {
+    int n;
+    int m;              // Input edges after merging parallel edges
+    ArcList *out;
+    ArcList *in;
+} DynamicGraph;
+
+/**
+ * @brief Adds arc (to, w) or lowers the weight of an existing arc to `to`.
+ * @return 1 if a new arc was appended.
+ */
+int arc_add(ArcList *list, int to, int w) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->arcs[i].to == to) {
+            if (w < list->arcs[i].w) list->arcs[i].w = w;
+            return 0;
+        }
+    }
+    if (list->size == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 4;
+        list->arcs = (Arc *)realloc(list->arcs, list->capacity * sizeof(Arc));
+        if (list->arcs == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+    list->arcs[list->size].to = to;
+    list->arcs[list->size].w = w;
+    list->size++;
+    return 1;
+}
+
+int graph_add_edge(DynamicGraph *g, int u, int v, int w) {
+    if (u == v) return 0; // Self loops never lie on a shortest path
+    arc_add(&g->in[v], u, w);
+    return arc_add(&g->out[u], v, w);
+}
+
+DynamicGraph *new_dynamic_graph(int n) {
+    DynamicGraph *g = (DynamicGraph *)xmalloc(sizeof(DynamicGraph));
+    g->n = n;
+    g->m = 0;
+    g->out = (ArcList *)calloc(n, sizeof(ArcList));
+    g->in = (ArcList *)calloc(n, sizeof(ArcList));
+    if (!g->out || !g->in) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    return g;
+}
+
+void free_dynamic_graph(DynamicGraph *g) {
+    for (int v = 0; v < g->n; v++) {
+        free(g->out[v].arcs);
+        free(g->in[v].arcs);
+    }
+    free(g->out);
+    free(g->in);
+    free(g);
+}
+
+StaticGraph to_static_graph(const DynamicGraph *g) {
+    StaticGraph s;
+    s.n = g->n;
+    s.start = (int *)xmalloc((g->n + 1) * sizeof(int));
+    s.start[0] = 0;
+    for (int v = 0; v < g->n; v++)
+        s.start[v + 1] = s.start[v] + g->out[v].size;
+    s.to = (int *)xmalloc(s.start[g->n] * sizeof(int));
+    s.w = (int *)xmalloc(s.start[g->n] * sizeof(int));
+    for (int v = 0; v < g->n; v++) {
+        for (int i = 0; i < g->out[v].size; i++) {
+            s.to[s.start[v] + i] = g->out[v].arcs[i].to;
+            s.w[s.start[v] + i] = g->out[v].arcs[i].w;
+        }
+    }
+    return s;
+}
+
+DynamicGraph *load_graph(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        perror("Error opening graph file");
+        return NULL;
+    }
+
+    int n, m;
+    if (fscanf(fp, "%d %d", &n, &m) != 2 || n <= 0 || m < 0) {
+        fprintf(stderr, "Error: invalid graph header in %s\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+
+    DynamicGraph *g = new_dynamic_graph(n);
+    double x, y;
+    for (int v = 0; v < n; v++) {
+        if (fscanf(fp, "%lf %lf", &x, &y) != 2) {
+            fprintf(stderr, "Error: malformed vertex line in %s\n", filename);
+            fclose(fp);
+            free_dynamic_graph(g);
+            return NULL;
+        }
+    }
+    for (int e = 0; e < m; e++) {
+        int u, v, w;
+        if (fscanf(fp, "%d %d %d", &u, &v, &w) != 3 || u < 0 || u >= n
+            || v < 0 || v >= n || w < 0) {
+            fprintf(stderr, "Error: malformed edge line in %s\n", filename);
+            fclose(fp);
+            free_dynamic_graph(g);
+            return NULL;
+        }
+        g->m += graph_add_edge(g, u, v, w);
+    }
+    fclose(fp);
+    return g;
+}
+
+/**
+ * @brief Generates a side x side grid road network with random weights.
+ *
+ * Every HIGHWAY_SPACING-th row and column is four times faster than the
+ * local streets, giving the graph the road hierarchy CH exploits.
+ */
+DynamicGraph *generate_grid_graph(int side) {
+    DynamicGraph *g = new_dynamic_graph(side * side);
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int u = r * side + c;
+            if (c + 1 < side) {
+                int w = 100 + (int)(next_random() % 50);
+                if (r % HIGHWAY_SPACING == 0) w /= 4;
+                g->m += graph_add_edge(g, u, u + 1, w);
+                g->m += graph_add_edge(g, u + 1, u, w);
+            }
+            if (r + 1 < side) {
+                int w = 100 + (int)(next_random() % 50);
+                if (c % HIGHWAY_SPACING == 0) w /= 4;
+                g->m += graph_add_edge(g, u, u + side, w);
+                g->m += graph_add_edge(g, u + side, u, w);
+            }
+        }
+    }
+    return g;
+}
+
+/* ---------- Contraction ---------- */
+
+/**
+ * While contracting, the in/out lists of the dynamic graph only hold arcs
+ * between nodes that are still uncontracted. When v is contracted its
+ * remaining arcs all lead to higher-ranked nodes, so they are moved into
+ * up[v] / down[v] and become v's part of the search graphs.
+ */
+typedef struct {
+    DynamicGraph *g;
+    ArcList *up;            // Arcs v -> x towards higher-ranked x
+    ArcList *down;          // Arcs x -> v from higher-ranked x, stored as (x, w)
+    int *rank;              // Contraction order, -1 while not yet contracted
+    int *deleted_neighbors; // Contracted neighbours, used in the priority
+    int *level;             // Hierarchy depth bound, used in the priority
+    long long *priority;    // Latest priority; older heap entries are stale
+    SearchSide witness;
+    long long shortcuts;
+} Contractor;
+
+void arc_remove(ArcList *list, int to) {
+    for (int i = 0; i < list->size; i++) {
+        if (list->arcs[i].to == to) {
+            list->arcs[i] = list->arcs[--list->size];
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Bounded Dijkstra from src in the remaining graph, skipping `avoid`.
+ *
+ * Stops at `limit` distance or after `max_settled` nodes. A truncated search
+ * may miss a witness, which only adds a redundant (but still correct)
+ * shortcut.
+ */
+void witness_search(Contractor *c, int src, int avoid, long long limit, int max_settled) {
+    SearchSide *s = &c->witness;
+    int settled = 0;
+
+    reset_side(s);
+    side_relax(s, src, 0);
+    heap_push(&s->heap, 0, src);
+
+    while (s->heap.size > 0 && settled < max_settled) {
+        HeapItem it = heap_pop(&s->heap);
+        int u = it.v;
+        if (s->done[u] == s->round) continue;
+        if (it.key > limit) break;
+        s->done[u] = s->round;
+        settled++;
+
+        const ArcList *out = &c->g->out[u];
+        for (int i = 0; i < out->size; i++) {
+            int v = out->arcs[i].to;
+            if (v == avoid) continue;
+            long long d = it.key + out->arcs[i].w;
+            if (d <= limit && side_relax(s, v, d))
+                heap_push(&s->heap, d, v);
+        }
+    }
+}
+
+/**
+ * @brief Simulates (apply == 0) or performs (apply == 1) the contraction of v.
+ * @return Number of shortcuts that are (or would be) required.
+ */
+int contract_node(Contractor *c, int v, int apply) {
+    const ArcList *in = &c->g->in[v];
+    const ArcList *out = &c->g->out[v];
+    int needed = 0;
+
+    for (int i = 0; i < in->size; i++) {
+        int u = in->arcs[i].to;
+
+        // -1: no path u -> v -> x at all (a 0-weight path still needs checking)
+        long long max_via = -1;
+        for (int j = 0; j < out->size; j++) {
+            long long via = (long long)in->arcs[i].w + out->arcs[j].w;
+            if (out->arcs[j].to != u && via > max_via) max_via = via;
+        }
+        if (max_via < 0) continue;
+
+        witness_search(c, u, v, max_via,
+                       apply ? CONTRACT_SETTLE_LIMIT : SIMULATE_SETTLE_LIMIT);
+
+        // Shortcuts u -> x only touch the lists of u and x, never those of v
+        for (int j = 0; j < out->size; j++) {
+            int x = out->arcs[j].to;
+            long long via = (long long)in->arcs[i].w + out->arcs[j].w;
+            if (x == u || side_dist(&c->witness, x) <= via) continue;
+            needed++;
+            if (!apply) continue;
+            // Arc weights are ints; a longer shortcut cannot be stored exactly
+            if (via > INT_MAX) {
+                fprintf(stderr, "Error: shortcut %d -> %d has weight %lld, which exceeds "
+                                "INT_MAX; scale the edge weights down.\n", u, x, via);
+                exit(1);
+            }
+            if (graph_add_edge(c->g, u, x, (int)via))
+                c->shortcuts++;
+        }
+    }
+    return needed;
+}
+
+/**
+ * @brief Priority of contracting v next: lower is better.
+ *
+ * Edge difference (shortcuts added minus edges removed) keeps the graph
+ * sparse; the deleted-neighbour and level terms spread contraction evenly
+ * so the hierarchy stays shallow.
+ */
+long long node_priority(Contractor *c, int v) {
+    int removed = c->g->in[v].size + c->g->out[v].size;
+    int added = contract_node(c, v, 0);
+    return 2LL * (added - removed) + c->deleted_neighbors[v] + c->level[v];
+}
+
+/**
+ * @brief Contracts all nodes in priority order, adding shortcuts to c->g.
+ *
+ * After each contraction the neighbours' priorities are recomputed; the
+ * popped node's priority is also re-checked lazily and the node re-queued
+ * if it is no longer the minimum.
+ */
+void build_hierarchy(Contractor *c) {
+    int n = c->g->n;
+    MinHeap queue = { NULL, 0, 0 };
+
+    for (int v = 0; v < n; v++) {
+        c->rank[v] = -1;
+        c->deleted_neighbors[v] = 0;
+        c->level[v] = 0;
+    }
+    for (int v = 0; v < n; v++) {
+        c->priority[v] = node_priority(c, v);
+        heap_push(&queue, c->priority[v], v);
+    }
+
+    int next_rank = 0;
+    while (queue.size > 0) {
+        HeapItem it = heap_pop(&queue);
+        int v = it.v;
+        if (c->rank[v] >= 0 || it.key != c->priority[v]) continue;
+
+        long long p = node_priority(c, v);
+        if (queue.size > 0 && p > heap_top_key(&queue)) {
+            c->priority[v] = p;
+            heap_push(&queue, p, v);
+            continue;
+        }
+
+        contract_node(c, v, 1);
+        c->rank[v] = next_rank++;
+
+        ArcList *in = &c->g->in[v];
+        ArcList *out = &c->g->out[v];
+        for (int i = 0; i < in->size; i++)
+            arc_remove(&c->g->out[in->arcs[i].to], v);
+        for (int i = 0; i < out->size; i++)
+            arc_remove(&c->g->in[out->arcs[i].to], v);
+
+        // Hand v's remaining arcs over to the search graphs
+        c->up[v] = *out;
+        c->down[v] = *in;
+        memset(out, 0, sizeof(*out));
+        memset(in, 0, sizeof(*in));
+
+        for (int k = 0; k < 2; k++) {
+            const ArcList *list = k ? &c->down[v] : &c->up[v];
+            for (int i = 0; i < list->size; i++) {
+                int x = list->arcs[i].to;
+                c->deleted_neighbors[x]++;
+                if (c->level[x] < c->level[v] + 1) c->level[x] = c->level[v] + 1;
+                c->priority[x] = node_priority(c, x);
+                heap_push(&queue, c->priority[x], x);
+            }
+        }
+    }
+    free(queue.items);
+}
+
+/* ---------- CH index: build, save, load ---------- */
+
+/**
+ * The query-side index. up_* holds arcs u -> x with rank[x] > rank[u] for the
+ * forward search; down_* holds, for each u, arcs x -> u with rank[x] > rank[u]
+ * stored as (x, w) so the backward search can also move upward.
+ */
+typedef struct {
+    int n;
+    int *rank;
+    int *up_start, *up_to, *up_w;
+    int *down_start, *down_to, *down_w;
+} CHIndex;
+
+/**
+ * @brief Flattens per-node arc lists into CSR arrays.
+ */
+void flatten_arcs(const ArcList *lists, int n, int **start, int **to, int **w) {
+    *start = (int *)xmalloc((n + 1) * sizeof(int));
+    (*start)[0] = 0;
+    for (int u = 0; u < n; u++)
+        (*start)[u + 1] = (*start)[u] + lists[u].size;
+
+    *to = (int *)xmalloc((*start)[n] * sizeof(int));
+    *w = (int *)xmalloc((*start)[n] * sizeof(int));
+    for (int u = 0; u < n; u++) {
+        for (int i = 0; i < lists[u].size; i++) {
+            (*to)[(*start)[u] + i] = lists[u].arcs[i].to;
+            (*w)[(*start)[u] + i] = lists[u].arcs[i].w;
+        }
+    }
+}
+
+CHIndex build_index(const Contractor *c) {
+    CHIndex ch;
+    ch.n = c->g->n;
+    ch.rank = (int *)xmalloc(ch.n * sizeof(int));
+    memcpy(ch.rank, c->rank, ch.n * sizeof(int));
+    flatten_arcs(c->up, ch.n, &ch.up_start, &ch.up_to, &ch.up_w);
+    flatten_arcs(c->down, ch.n, &ch.down_start, &ch.down_to, &ch.down_w);
+    return ch;
+}
+
+/**
+ * @brief Contracts every node of g and returns the query index. g is left
+ * without arcs (they move into the index); the caller still frees it.
+ */
+CHIndex preprocess(DynamicGraph *g, long long *shortcuts) {
+    Contractor c;
+    c.g = g;
+    c.up = (ArcList *)calloc(g->n, sizeof(ArcList));
+    c.down = (ArcList *)calloc(g->n, sizeof(ArcList));
+    c.rank = (int *)xmalloc(g->n * sizeof(int));
+    c.deleted_neighbors = (int *)xmalloc(g->n * sizeof(int));
+    c.level = (int *)xmalloc(g->n * sizeof(int));
+    c.priority = (long long *)xmalloc(g->n * sizeof(long long));
+    c.shortcuts = 0;
+    if (!c.up || !c.down) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    init_side(&c.witness, g->n);
+
+    build_hierarchy(&c);
+    CHIndex ch = build_index(&c);
+    *shortcuts = c.shortcuts;
+
+    for (int v = 0; v < g->n; v++) {
+        free(c.up[v].arcs);
+        free(c.down[v].arcs);
+    }
+    free(c.up);
+    free(c.down);
+    free_side(&c.witness);
+    free(c.priority);
+    free(c.level);
+    free(c.deleted_neighbors);
+    free(c.rank);
+    return ch;
+}
+
+void free_index(CHIndex *ch) {
+    free(ch->rank);
+    free(ch->up_start); free(ch->up_to); free(ch->up_w);
+    free(ch->down_start); free(ch->down_to); free(ch->down_w);
+}
+
+/**
+ * @brief Writes the index as: magic, n, #up arcs, #down arcs, then the rank
+ * array and both CSR graphs as int32 arrays in native byte order (an index
+ * is only readable on a machine of the same endianness).
+ */
+int save_index(const CHIndex *ch, const char *filename) {
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        perror("Error opening index file for writing");
+        return 0;
+    }
+
+    int header[3] = { ch->n, ch->up_start[ch->n], ch->down_start[ch->n] };
+    int ok = fwrite(CH_MAGIC, 1, 4, fp) == 4
+          && fwrite(header, sizeof(int), 3, fp) == 3
+          && fwrite(ch->rank, sizeof(int), ch->n, fp) == (size_t)ch->n
+          && fwrite(ch->up_start, sizeof(int), ch->n + 1, fp) == (size_t)ch->n + 1
+          && fwrite(ch->up_to, sizeof(int), header[1], fp) == (size_t)header[1]
+          && fwrite(ch->up_w, sizeof(int), header[1], fp) == (size_t)header[1]
+          && fwrite(ch->down_start, sizeof(int), ch->n + 1, fp) == (size_t)ch->n + 1
+          && fwrite(ch->down_to, sizeof(int), header[2], fp) == (size_t)header[2]
+          && fwrite(ch->down_w, sizeof(int), header[2], fp) == (size_t)header[2];
+    if (fclose(fp) != 0) ok = 0;
+    if (!ok) fprintf(stderr, "Error: failed to write %s\n", filename);
+    return ok;
+}
+
+int read_ints(FILE *fp, int **dst, int count) {
+    *dst = (int *)xmalloc(count * sizeof(int));
+    return fread(*dst, sizeof(int), count, fp) == (size_t)count;
+}
+
+/**
+ * @brief Checks that a CSR graph read from disk is safe to traverse:
+ * offsets start at 0 and never decrease, targets are nodes, weights are
+ * non-negative. (The last offset was already matched to the arc count.)
+ */
+int valid_csr(const int *start, const int *to, const int *w, int n) {
+    if (start[0] != 0) return 0;
+    for (int v = 0; v < n; v++)
+        if (start[v] > start[v + 1]) return 0;
+    for (int e = 0; e < start[n]; e++)
+        if (to[e] < 0 || to[e] >= n || w[e] < 0) return 0;
+    return 1;
+}
+
+int load_index(CHIndex *ch, const char *filename) {
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        perror("Error opening index file");
+        return 0;
+    }
+
+    char magic[4];
+    int header[3];
+    memset(ch, 0, sizeof(*ch));
+    int ok = fread(magic, 1, 4, fp) == 4 && memcmp(magic, CH_MAGIC, 4) == 0
+          && fread(header, sizeof(int), 3, fp) == 3
+          && header[0] > 0 && header[0] < INT_MAX && header[1] >= 0 && header[2] >= 0;
+    if (ok) {
+        ch->n = header[0];
+        ok = read_ints(fp, &ch->rank, ch->n)
+          && read_ints(fp, &ch->up_start, ch->n + 1)
+          && read_ints(fp, &ch->up_to, header[1])
+          && read_ints(fp, &ch->up_w, header[1])
+          && read_ints(fp, &ch->down_start, ch->n + 1)
+          && read_ints(fp, &ch->down_to, header[2])
+          && read_ints(fp, &ch->down_w, header[2])
+          && ch->up_start[ch->n] == header[1] && ch->down_start[ch->n] == header[2]
+          && valid_csr(ch->up_start, ch->up_to, ch->up_w, ch->n)
+          && valid_csr(ch->down_start, ch->down_to, ch->down_w, ch->n);
+    }
+    fclose(fp);
+
+    if (!ok) {
+        fprintf(stderr, "Error: %s is not a valid CH index\n", filename);
+        free_index(ch);
+    }
+    return ok;
+}
+
+/* ---------- CH query ---------- */
+
+/**
+ * @brief Returns 1 if u's label can be proven suboptimal by an arc coming
+ * down from a higher node (stall-on-demand); such nodes are not expanded.
+ */
+int is_stalled(const SearchSide *s, const int *start, const int *adj, const int *wt,
+               int u, long long du) {
+    for (int e = start[u]; e < start[u + 1]; e++) {
+        long long dx = side_dist(s, adj[e]);
+        if (dx != INF_DIST && dx + wt[e] < du) return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Bidirectional upward search: both sides only relax arcs towards
+ * higher-ranked nodes, and the shortest path is the best meeting point.
+ */
+long long ch_query(const CHIndex *ch, SearchSide *fwd, SearchSide *bwd,
+                   int src, int target, long long *settled) {
+    reset_side(fwd);
+    reset_side(bwd);
+    side_relax(fwd, src, 0);
+    side_relax(bwd, target, 0);
+    heap_push(&fwd->heap, 0, src);
+    heap_push(&bwd->heap, 0, target);
+
+    long long best = (src == target) ? 0 : INF_DIST;
+    int forward = 1;
+
+    while (fwd->heap.size > 0 || bwd->heap.size > 0) {
+        // Each side can stop independently once its queue head reaches best
+        if (heap_top_key(&fwd->heap) >= best) fwd->heap.size = 0;
+        if (heap_top_key(&bwd->heap) >= best) bwd->heap.size = 0;
+        if (fwd->heap.size == 0 && bwd->heap.size == 0) break;
+        if (fwd->heap.size == 0) forward = 0;
+        else if (bwd->heap.size == 0) forward = 1;
+
+        SearchSide *me = forward ? fwd : bwd;
+        SearchSide *other = forward ? bwd : fwd;
+        const int *start = forward ? ch->up_start : ch->down_start;
+        const int *adj = forward ? ch->up_to : ch->down_to;
+        const int *wt = forward ? ch->up_w : ch->down_w;
+        // Arcs entering u from above live in the opposite direction's lists
+        const int *stall_start = forward ? ch->down_start : ch->up_start;
+        const int *stall_adj = forward ? ch->down_to : ch->up_to;
+        const int *stall_wt = forward ? ch->down_w : ch->up_w;
+        forward = !forward;
+
+        HeapItem it = heap_pop(&me->heap);
+        int u = it.v;
+        if (me->done[u] == me->round) continue;
+        me->done[u] = me->round;
+        (*settled)++;
+
+        long long du = it.key;
+        long long dv = side_dist(other, u);
+        if (dv != INF_DIST && du + dv < best) best = du + dv;
+
+        if (is_stalled(me, stall_start, stall_adj, stall_wt, u, du)) continue;
+
+        for (int e = start[u]; e < start[u + 1]; e++)
+            if (side_relax(me, adj[e], du + wt[e]))
+                heap_push(&me->heap, du + wt[e], adj[e]);
+    }
+    return best;
+}
+
+/* ---------- Benchmark ---------- */
+
+int compare_doubles(const void *a, const void *b) {
+    double da = *(const double *)a, db = *(const double *)b;
+    return (da > db) - (da < db);
+}
+
+void print_latency_row(const char *name, double *us, int count, double avg_settled) {
+    qsort(us, count, sizeof(double), compare_doubles);
+    printf("%-18s %10.2f %10.2f %10.2f %10.2f %12.1f\n", name,
+           us[count / 2], us[(int)(count * 0.90)], us[(int)(count * 0.99)],
+           us[count - 1], avg_settled);
+}
+
+int run_benchmark(const StaticGraph *base, const CHIndex *ch, int queries) {
+    SearchSide a, b;
+    init_side(&a, base->n);
+    init_side(&b, base->n);
+    double *dij_us = (double *)xmalloc(queries * sizeof(double));
+    double *ch_us = (double *)xmalloc(queries * sizeof(double));
+    long long dij_settled = 0, ch_settled = 0;
+    int mismatches = 0;
+
+    for (int q = 0; q < queries; q++) {
+        int src = (int)(next_random() % base->n);
+        int target = (int)(next_random() % base->n);
+
+        double t0 = now_seconds();
+        long long d1 = dijkstra_query(base, &a, src, target, &dij_settled);
+        double t1 = now_seconds();
+        long long d2 = ch_query(ch, &a, &b, src, target, &ch_settled);
+        double t2 = now_seconds();
+
+        dij_us[q] = (t1 - t0) * 1e6;
+        ch_us[q] = (t2 - t1) * 1e6;
+        if (d1 != d2) mismatches++;
+    }
+
+    printf("\nQuery latency over %d random queries (microseconds):\n", queries);
+    printf("%-18s %10s %10s %10s %10s %12s\n", "Method", "p50", "p90", "p99", "max", "avg settled");
+    print_latency_row("Dijkstra", dij_us, queries, (double)dij_settled / queries);
+    print_latency_row("CH query", ch_us, queries, (double)ch_settled / queries);
+    printf("\nMedian speedup: %.1fx\n", dij_us[queries / 2] / ch_us[queries / 2]);
+    printf("Distance mismatches: %d\n", mismatches);
+
+    free(dij_us);
+    free(ch_us);
+    free_side(&a);
+    free_side(&b);
+    return mismatches;
+}
+
+/**
+ * @brief Cross-checks CH against Dijkstra on a random sparse graph where
+ * most arcs weigh 0, so many shortcuts have weight 0 as well.
+ *
+ * @return Number of queries whose distances differ
+ */
+int zero_weight_check(int n, int queries) {
+    static const int weights[] = { 0, 0, 0, 1, 3 };
+    DynamicGraph *g = new_dynamic_graph(n);
+    for (int e = 0; e < 3 * n; e++) {
+        int u = (int)(next_random() % n), v = (int)(next_random() % n);
+        g->m += graph_add_edge(g, u, v, weights[next_random() % 5]);
+    }
+    StaticGraph base = to_static_graph(g);
+    long long shortcuts;
+    CHIndex ch = preprocess(g, &shortcuts);
+    free_dynamic_graph(g);
+
+    SearchSide a, b;
+    init_side(&a, n);
+    init_side(&b, n);
+    long long settled = 0;
+    int mismatches = 0;
+    for (int q = 0; q < queries; q++) {
+        int src = (int)(next_random() % n), target = (int)(next_random() % n);
+        if (dijkstra_query(&base, &a, src, target, &settled)
+            != ch_query(&ch, &a, &b, src, target, &settled))
+            mismatches++;
+    }
+    printf("Zero-weight graph (%d vertices, weights 0/1/3): %d of %d distances differ\n",
+           n, mismatches, queries);
+
+    free_side(&a);
+    free_side(&b);
+    free_index(&ch);
+    free_static_graph(&base);
+    return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+    const char *index_file = DEFAULT_INDEX_FILE;
+    int queries = DEFAULT_QUERIES;
+    DynamicGraph *g;
+
+    if (argc > 1) {
+        g = load_graph(argv[1]);
+        if (argc > 2) index_file = argv[2];
+        if (argc > 3) queries = atoi(argv[3]);
+    } else {
+        g = generate_grid_graph(DEFAULT_GRID_SIDE);
+    }
+    if (g == NULL) return 1;
+    if (queries <= 0) {
+        fprintf(stderr, "Error: number of queries must be positive.\n");
+        free_dynamic_graph(g);
+        return 1;
+    }
+
+    printf("Graph: %d vertices, %d edges\n", g->n, g->m);
+    StaticGraph base = to_static_graph(g);
+
+    double t0 = now_seconds();
+    long long shortcuts;
+    CHIndex built = preprocess(g, &shortcuts);
+    double prep = now_seconds() - t0;
+    printf("Preprocessing: %.3f s, %lld shortcuts added\n", prep, shortcuts);
+    free_dynamic_graph(g);
+
+    if (!save_index(&built, index_file)) {
+        free_index(&built);
+        free_static_graph(&base);
+        return 1;
+    }
+    free_index(&built);
+
+    // Queries run against the index as read back from disk
+    CHIndex ch;
+    if (!load_index(&ch, index_file)) {
+        free_static_graph(&base);
+        return 1;
+    }
+    long long index_bytes = 16 + 4LL * (ch.n + 2LL * (ch.n + 1)
+                            + 2LL * ch.up_start[ch.n] + 2LL * ch.down_start[ch.n]);
+    printf("Index: %s, %.2f MB (%d upward + %d downward arcs)\n", index_file,
+           index_bytes / 1048576.0, ch.up_start[ch.n], ch.down_start[ch.n]);
+
+    int mismatches = run_benchmark(&base, &ch, queries);
+    free_index(&ch);
+    free_static_graph(&base);
+
+    printf("\n");
+    mismatches += zero_weight_check(ZERO_WEIGHT_NODES, queries);
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,594 @@
+/**
+ * @file dijkstra_point_to_point.c
+ * @brief Point-to-point shortest paths: bidirectional Dijkstra and A* search.
+ *
+ * This program demonstrates:
+ * 1. Graph representation using compressed adjacency lists (CSR)
+ * 2. Binary min-heap priority queue with lazy deletion
+ * 3. Bidirectional Dijkstra with the "top_f + top_b >= best" stopping rule
+ * 4. A* search with a pluggable admissible heuristic (function pointer)
+ * 5. Counting settled nodes to compare against full single-source expansion
+ *
+ * Graph file format (plain text):
+ *   n m
+ *   x y        (n lines, coordinates of each vertex)
+ *   u v w      (m lines, directed edge u -> v with integer weight w >= 0)
+ *
+ * The Euclidean heuristic is admissible when every edge weight is at least
+ * the straight-line distance between its endpoints. The program checks this
+ * and falls back to the zero heuristic (plain Dijkstra) if it does not hold.
+ *
+ * Usage:
+ * gcc -O2 dijkstra_point_to_point.c -o dijkstra_p2p -lm
+ * ./dijkstra_p2p                   (random 300x300 grid graph)
+ * ./dijkstra_p2p graph.txt 500     (graph file, 500 random queries)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#define INF_DIST LLONG_MAX
+#define DEFAULT_GRID_SIDE 300
+#define DEFAULT_QUERIES 200
+
+// Directed graph in CSR form, with the reverse graph for backward searches
+typedef struct {
+    int n, m;
+    int *out_start, *out_to, *out_w;
+    int *in_start, *in_from, *in_w;
+    double *x, *y;
+} Graph;
+
+// Heuristic estimate of the remaining distance from v to target
+typedef long long (*heuristic_func)(const Graph *g, int v, int target);
+
+typedef struct {
+    long long key;
+    int v;
+} HeapItem;
+
+typedef struct {
+    HeapItem *items;
+    int size;
+    int capacity;
+} MinHeap;
+
+/**
+ * Per-direction search state. Labels are invalidated between queries by
+ * bumping `round` instead of clearing the arrays, so a query only pays for
+ * the vertices it actually touches.
+ */
+typedef struct {
+    long long *dist;
+    unsigned *seen;     // dist[v] is valid iff seen[v] == round
+    unsigned *done;     // v is settled iff done[v] == round
+    unsigned round;
+    MinHeap heap;
+} SearchSide;
+
+typedef struct {
+    long long settled;
+    long long relaxed;
+} QueryStats;
+
+/* ---------- Utilities ---------- */
+
+static unsigned long long rng_state = 88172645463325252ULL;
+
+unsigned long long next_random(void) {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* ---------- Min Heap ---------- */
+
+void heap_push(MinHeap *h, long long key, int v) {
+    if (h->size == h->capacity) {
+        h->capacity = h->capacity ? h->capacity * 2 : 64;
+        h->items = (HeapItem *)realloc(h->items, h->capacity * sizeof(HeapItem));
+        if (h->items == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+
+    int i = h->size++;
+    while (i > 0 && h->items[(i - 1) / 2].key > key) {
+        h->items[i] = h->items[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h->items[i].key = key;
+    h->items[i].v = v;
+}
+
+HeapItem heap_pop(MinHeap *h) {
+    HeapItem top = h->items[0];
+    HeapItem last = h->items[--h->size];
+    int i = 0;
+
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= h->size) break;
+        if (child + 1 < h->size && h->items[child + 1].key < h->items[child].key)
+            child++;
+        if (h->items[child].key >= last.key) break;
+        h->items[i] = h->items[child];
+        i = child;
+    }
+    if (h->size > 0) h->items[i] = last;
+    return top;
+}
+
+long long heap_top_key(const MinHeap *h) {
+    return h->size ? h->items[0].key : INF_DIST;
+}
+
+/* ---------- Graph construction ---------- */
+
+/**
+ * @brief Builds forward and reverse CSR arrays from an edge list.
+ *
+ * Takes ownership of the coordinate arrays x and y.
+ */
+Graph *build_graph(int n, int m, const int *eu, const int *ev, const int *ew,
+                   double *x, double *y) {
+    Graph *g = (Graph *)calloc(1, sizeof(Graph));
+    if (g == NULL) return NULL;
+    g->n = n;
+    g->m = m;
+    g->x = x;
+    g->y = y;
+    g->out_start = (int *)calloc(n + 1, sizeof(int));
+    g->in_start = (int *)calloc(n + 1, sizeof(int));
+    g->out_to = (int *)malloc((m ? m : 1) * sizeof(int));
+    g->out_w = (int *)malloc((m ? m : 1) * sizeof(int));
+    g->in_from = (int *)malloc((m ? m : 1) * sizeof(int));
+    g->in_w = (int *)malloc((m ? m : 1) * sizeof(int));
+    if (!g->out_start || !g->in_start || !g->out_to || !g->out_w || !g->in_from || !g->in_w) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    // Count degrees, prefix-sum into start offsets, then scatter edges
+    for (int e = 0; e < m; e++) {
+        g->out_start[eu[e] + 1]++;
+        g->in_start[ev[e] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        g->out_start[v + 1] += g->out_start[v];
+        g->in_start[v + 1] += g->in_start[v];
+    }
+
+    int *out_pos = (int *)malloc(n * sizeof(int));
+    int *in_pos = (int *)malloc(n * sizeof(int));
+    memcpy(out_pos, g->out_start, n * sizeof(int));
+    memcpy(in_pos, g->in_start, n * sizeof(int));
+    for (int e = 0; e < m; e++) {
+        int o = out_pos[eu[e]]++;
+        g->out_to[o] = ev[e];
+        g->out_w[o] = ew[e];
+        int i = in_pos[ev[e]]++;
+        g->in_from[i] = eu[e];
+        g->in_w[i] = ew[e];
+    }
+    free(out_pos);
+    free(in_pos);
+    return g;
+}
+
+void free_graph(Graph *g) {
+    if (g == NULL) return;
+    free(g->out_start); free(g->out_to); free(g->out_w);
+    free(g->in_start); free(g->in_from); free(g->in_w);
+    free(g->x); free(g->y);
+    free(g);
+}
+
+/**
+ * @brief Loads a graph in the text format described at the top of the file.
+ */
+Graph *load_graph(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        perror("Error opening graph file");
+        return NULL;
+    }
+
+    int n, m;
+    if (fscanf(fp, "%d %d", &n, &m) != 2 || n <= 0 || m < 0) {
+        fprintf(stderr, "Error: invalid graph header in %s\n", filename);
+        fclose(fp);
+        return NULL;
+    }
+
+    double *x = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    int *eu = (int *)malloc((m ? m : 1) * sizeof(int));
+    int *ev = (int *)malloc((m ? m : 1) * sizeof(int));
+    int *ew = (int *)malloc((m ? m : 1) * sizeof(int));
+    if (!x || !y || !eu || !ev || !ew) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    int ok = 1;
+    for (int v = 0; v < n && ok; v++)
+        ok = fscanf(fp, "%lf %lf", &x[v], &y[v]) == 2;
+    for (int e = 0; e < m && ok; e++) {
+        ok = fscanf(fp, "%d %d %d", &eu[e], &ev[e], &ew[e]) == 3
+             && eu[e] >= 0 && eu[e] < n && ev[e] >= 0 && ev[e] < n && ew[e] >= 0;
+    }
+    fclose(fp);
+
+    Graph *g = NULL;
+    if (ok) {
+        g = build_graph(n, m, eu, ev, ew, x, y);
+    } else {
+        fprintf(stderr, "Error: malformed vertex or edge line in %s\n", filename);
+        free(x);
+        free(y);
+    }
+    free(eu);
+    free(ev);
+    free(ew);
+    return g;
+}
+
+/**
+ * @brief Generates a side x side grid with jittered coordinates.
+ *
+ * Edge weights are the Euclidean length stretched by a random factor in
+ * [1, 1.5), so the Euclidean heuristic stays admissible.
+ */
+Graph *generate_grid_graph(int side) {
+    int n = side * side;
+    int max_edges = 4 * n;
+    double *x = (double *)malloc(n * sizeof(double));
+    double *y = (double *)malloc(n * sizeof(double));
+    int *eu = (int *)malloc(max_edges * sizeof(int));
+    int *ev = (int *)malloc(max_edges * sizeof(int));
+    int *ew = (int *)malloc(max_edges * sizeof(int));
+    if (!x || !y || !eu || !ev || !ew) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            x[r * side + c] = c * 100.0 + (double)(next_random() % 40);
+            y[r * side + c] = r * 100.0 + (double)(next_random() % 40);
+        }
+    }
+
+    int m = 0;
+    for (int r = 0; r < side; r++) {
+        for (int c = 0; c < side; c++) {
+            int u = r * side + c;
+            int nbr[2] = { c + 1 < side ? u + 1 : -1, r + 1 < side ? u + side : -1 };
+            for (int k = 0; k < 2; k++) {
+                int v = nbr[k];
+                if (v < 0) continue;
+                double len = hypot(x[u] - x[v], y[u] - y[v]);
+                int w = (int)ceil(len * (1.0 + (double)(next_random() % 50) / 100.0));
+                eu[m] = u; ev[m] = v; ew[m] = w; m++;
+                eu[m] = v; ev[m] = u; ew[m] = w; m++;
+            }
+        }
+    }
+
+    Graph *g = build_graph(n, m, eu, ev, ew, x, y);
+    free(eu);
+    free(ev);
+    free(ew);
+    return g;
+}
+
+/* ---------- Heuristics ---------- */
+
+long long heuristic_zero(const Graph *g, int v, int target) {
+    (void)g; (void)v; (void)target;
+    return 0;
+}
+
+long long heuristic_euclidean(const Graph *g, int v, int target) {
+    return (long long)hypot(g->x[v] - g->x[target], g->y[v] - g->y[target]);
+}
+
+/**
+ * @brief Returns 1 if no edge is shorter than the straight line between its
+ * endpoints, which makes the Euclidean heuristic admissible and consistent.
+ */
+int euclidean_is_admissible(const Graph *g) {
+    for (int u = 0; u < g->n; u++) {
+        for (int e = g->out_start[u]; e < g->out_start[u + 1]; e++) {
+            int v = g->out_to[e];
+            if ((double)g->out_w[e] < hypot(g->x[u] - g->x[v], g->y[u] - g->y[v]))
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/* ---------- Search state ---------- */
+
+void init_side(SearchSide *s, int n) {
+    s->dist = (long long *)malloc(n * sizeof(long long));
+    s->seen = (unsigned *)calloc(n, sizeof(unsigned));
+    s->done = (unsigned *)calloc(n, sizeof(unsigned));
+    s->round = 0;
+    s->heap.items = NULL;
+    s->heap.size = s->heap.capacity = 0;
+    if (!s->dist || !s->seen || !s->done) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+}
+
+void free_side(SearchSide *s) {
+    free(s->dist);
+    free(s->seen);
+    free(s->done);
+    free(s->heap.items);
+}
+
+void reset_side(SearchSide *s) {
+    s->round++;
+    s->heap.size = 0;
+}
+
+long long side_dist(const SearchSide *s, int v) {
+    return s->seen[v] == s->round ? s->dist[v] : INF_DIST;
+}
+
+/**
+ * @brief Lowers the label of v if d improves it; returns 1 on improvement.
+ */
+int side_relax(SearchSide *s, int v, long long d) {
+    if (s->seen[v] != s->round || d < s->dist[v]) {
+        s->seen[v] = s->round;
+        s->dist[v] = d;
+        return 1;
+    }
+    return 0;
+}
+
+/* ---------- Search algorithms ---------- */
+
+/**
+ * @brief Unidirectional Dijkstra from src.
+ *
+ * With stop_at_target == 0 this is the full single-source expansion that
+ * dijkstra_shortest_path.c performs; otherwise it stops once target is settled.
+ *
+ * @return Distance from src to target, or INF_DIST if unreachable.
+ */
+long long dijkstra_search(const Graph *g, SearchSide *s, int src, int target,
+                          int stop_at_target, QueryStats *stats) {
+    reset_side(s);
+    side_relax(s, src, 0);
+    heap_push(&s->heap, 0, src);
+
+    while (s->heap.size > 0) {
+        HeapItem it = heap_pop(&s->heap);
+        int u = it.v;
+        if (s->done[u] == s->round) continue; // stale heap entry
+        s->done[u] = s->round;
+        stats->settled++;
+        if (stop_at_target && u == target) break;
+
+        for (int e = g->out_start[u]; e < g->out_start[u + 1]; e++) {
+            int v = g->out_to[e];
+            stats->relaxed++;
+            if (side_relax(s, v, it.key + g->out_w[e]))
+                heap_push(&s->heap, it.key + g->out_w[e], v);
+        }
+    }
+    return side_dist(s, target);
+}
+
+/**
+ * @brief Bidirectional Dijkstra between src and target.
+ *
+ * Grows a forward search from src and a backward search (over reversed edges)
+ * from target, always advancing the side with the smaller queue head. The
+ * best meeting distance mu is updated whenever an edge reaches a vertex
+ * labelled by the opposite side; the search stops once the two queue heads
+ * sum to at least mu.
+ */
+long long bidirectional_dijkstra(const Graph *g, SearchSide *fwd, SearchSide *bwd,
+                                 int src, int target, QueryStats *stats) {
+    reset_side(fwd);
+    reset_side(bwd);
+    side_relax(fwd, src, 0);
+    side_relax(bwd, target, 0);
+    heap_push(&fwd->heap, 0, src);
+    heap_push(&bwd->heap, 0, target);
+
+    long long mu = (src == target) ? 0 : INF_DIST;
+
+    // Once either side runs dry it has explored everything it can reach,
+    // and every connecting edge has already been checked against mu.
+    while (fwd->heap.size > 0 && bwd->heap.size > 0) {
+        long long top_f = heap_top_key(&fwd->heap);
+        long long top_b = heap_top_key(&bwd->heap);
+        if (top_f + top_b >= mu) break;
+
+        int forward = top_f <= top_b;
+        SearchSide *me = forward ? fwd : bwd;
+        SearchSide *other = forward ? bwd : fwd;
+        const int *start = forward ? g->out_start : g->in_start;
+        const int *adj = forward ? g->out_to : g->in_from;
+        const int *wt = forward ? g->out_w : g->in_w;
+
+        HeapItem it = heap_pop(&me->heap);
+        int u = it.v;
+        if (me->done[u] == me->round) continue;
+        me->done[u] = me->round;
+        stats->settled++;
+
+        for (int e = start[u]; e < start[u + 1]; e++) {
+            int v = adj[e];
+            long long d = it.key + wt[e];
+            stats->relaxed++;
+            if (side_relax(me, v, d))
+                heap_push(&me->heap, d, v);
+            long long dv = side_dist(other, v);
+            if (dv != INF_DIST && d + dv < mu)
+                mu = d + dv;
+        }
+    }
+    return mu;
+}
+
+/**
+ * @brief A* search from src to target guided by heuristic h.
+ *
+ * Vertices are ordered by g(v) + h(v). With a consistent heuristic every
+ * vertex is settled at most once and the search may stop when target is
+ * popped. heuristic_zero reduces this to early-exit Dijkstra.
+ */
+long long astar_search(const Graph *g, SearchSide *s, int src, int target,
+                       heuristic_func h, QueryStats *stats) {
+    reset_side(s);
+    side_relax(s, src, 0);
+    heap_push(&s->heap, h(g, src, target), src);
+
+    while (s->heap.size > 0) {
+        HeapItem it = heap_pop(&s->heap);
+        int u = it.v;
+        if (s->done[u] == s->round) continue;
+        s->done[u] = s->round;
+        stats->settled++;
+        if (u == target) break;
+
+        long long du = s->dist[u];
+        for (int e = g->out_start[u]; e < g->out_start[u + 1]; e++) {
+            int v = g->out_to[e];
+            long long d = du + g->out_w[e];
+            stats->relaxed++;
+            if (s->done[v] != s->round && side_relax(s, v, d))
+                heap_push(&s->heap, d + h(g, v, target), v);
+        }
+    }
+    return side_dist(s, target);
+}
+
+/* ---------- Benchmark ---------- */
+
+enum { MODE_FULL, MODE_EARLY_EXIT, MODE_BIDIRECTIONAL, MODE_ASTAR, MODE_COUNT };
+
+const char *mode_names[MODE_COUNT] = {
+    "Full Dijkstra (baseline)",
+    "Early-exit Dijkstra",
+    "Bidirectional Dijkstra",
+    "A* search",
+};
+
+void run_benchmark(const Graph *g, int queries) {
+    heuristic_func h = heuristic_euclidean;
+    const char *h_name = "euclidean";
+    if (!euclidean_is_admissible(g)) {
+        printf("Note: some edges are shorter than their Euclidean length; "
+               "using the zero heuristic for A*.\n");
+        h = heuristic_zero;
+        h_name = "zero";
+    }
+
+    SearchSide fwd, bwd;
+    init_side(&fwd, g->n);
+    init_side(&bwd, g->n);
+
+    QueryStats totals[MODE_COUNT];
+    double seconds[MODE_COUNT];
+    memset(totals, 0, sizeof(totals));
+    memset(seconds, 0, sizeof(seconds));
+    int mismatches = 0;
+
+    for (int q = 0; q < queries; q++) {
+        int src = (int)(next_random() % g->n);
+        int target = (int)(next_random() % g->n);
+        long long result[MODE_COUNT] = {0};
+
+        for (int mode = 0; mode < MODE_COUNT; mode++) {
+            double t0 = now_seconds();
+            switch (mode) {
+            case MODE_FULL:
+                result[mode] = dijkstra_search(g, &fwd, src, target, 0, &totals[mode]);
+                break;
+            case MODE_EARLY_EXIT:
+                result[mode] = dijkstra_search(g, &fwd, src, target, 1, &totals[mode]);
+                break;
+            case MODE_BIDIRECTIONAL:
+                result[mode] = bidirectional_dijkstra(g, &fwd, &bwd, src, target, &totals[mode]);
+                break;
+            default:
+                result[mode] = astar_search(g, &fwd, src, target, h, &totals[mode]);
+                break;
+            }
+            seconds[mode] += now_seconds() - t0;
+        }
+
+        for (int mode = 1; mode < MODE_COUNT; mode++)
+            if (result[mode] != result[MODE_FULL]) mismatches++;
+
+        if (q == 0) {
+            if (result[MODE_FULL] == INF_DIST)
+                printf("Sample query %d -> %d: unreachable\n\n", src, target);
+            else
+                printf("Sample query %d -> %d: distance %lld\n\n", src, target, result[MODE_FULL]);
+        }
+    }
+
+    printf("%d queries, A* heuristic: %s\n", queries, h_name);
+    printf("%-26s %14s %14s %14s %10s\n",
+           "Mode", "avg settled", "avg relaxed", "avg time (us)", "settled %");
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+        double settled = (double)totals[mode].settled / queries;
+        printf("%-26s %14.1f %14.1f %14.2f %9.2f%%\n", mode_names[mode],
+               settled, (double)totals[mode].relaxed / queries,
+               seconds[mode] * 1e6 / queries,
+               100.0 * settled / ((double)totals[MODE_FULL].settled / queries));
+    }
+    printf("\nDistance mismatches against baseline: %d\n", mismatches);
+
+    free_side(&fwd);
+    free_side(&bwd);
+}
+
+int main(int argc, char *argv[]) {
+    Graph *g;
+    int queries = DEFAULT_QUERIES;
+
+    if (argc > 1) {
+        g = load_graph(argv[1]);
+        if (argc > 2) queries = atoi(argv[2]);
+    } else {
+        g = generate_grid_graph(DEFAULT_GRID_SIDE);
+    }
+
+    if (g == NULL) return 1;
+    if (queries <= 0) {
+        fprintf(stderr, "Error: number of queries must be positive.\n");
+        free_graph(g);
+        return 1;
+    }
+
+    printf("Graph: %d vertices, %d edges\n", g->n, g->m);
+    run_benchmark(g, queries);
+
+    free_graph(g);
+    return 0;
+}
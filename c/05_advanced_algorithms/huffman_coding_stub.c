@@ -8,6 +8,7 @@
  * 3. Basic structure for compression algorithms
  * 
  * Note: This is a simplified version focusing on tree construction logic.
+ * huffman_compressor.c turns it into a working file compressor.
  */
 
 #include <stdio.h>
@@ -0,0 +1,1361 @@
+/**
+ * @file huffman_compressor.c
+ * @brief Streaming Huffman file compressor and decompressor.
+ *
+ * This program demonstrates:
+ * 1. Byte-frequency counting over a stream, with four histograms so that
+ *    runs of the same byte do not serialize on one counter
+ * 2. Huffman code lengths from sorted leaves and a second queue of merged
+ *    nodes (no heap needed once the leaves are sorted), then limited to
+ *    MAX_CODE_LEN bits by clamping and repairing the Kraft sum
+ * 3. Canonical codes: only the 256 code lengths are stored, and both sides
+ *    rebuild the same codes from them
+ * 4. An encoder that gathers codes in a 64-bit bit buffer and writes whole
+ *    words, three symbols per flush
+ * 5. A table-driven decoder: the next 11 bits index a primary table whose
+ *    entry holds one or two complete symbols and the bits they use, or
+ *    links to a small secondary table for the rare codes of 12-15 bits
+ * 6. The pointer-chasing tree walk (one node per bit) as a baseline
+ * 7. A block container: the input is cut into 1 MB blocks, each coded
+ *    independently with its own code table, and an index at the end of the
+ *    file locates every block. Blocks are compressed and decompressed in
+ *    parallel on a thread pool, and any single block can be decoded
+ *    without touching the ones before it
+ * 8. Encode and decode throughput in MB/s on text, binary and random
+ *    corpora, or on files given on the command line
+ *
+ * See huffman_coding_stub.c for the pointer-based tree this grows out of.
+ *
+ * Stream format: "HUF1", the original size (8 bytes, little endian), 256
+ * code lengths packed two per byte, then the bitstream, least significant
+ * bit first.
+ *
+ * Block format: "HUFB" and the block size (8 bytes), every block as a
+ * complete HUF1 stream, the index (offset and packed size of each block,
+ * 8 bytes each), then a 32-byte trailer: index offset, block count,
+ * original size and "HUFB" padded to 8 bytes.
+ *
+ * Usage:
+ * gcc -O2 -pthread huffman_compressor.c -o huffman_compressor
+ * ./huffman_compressor                     (benchmark, 32 MB corpora)
+ * ./huffman_compressor --bench 128         (benchmark, 128 MB corpora)
+ * ./huffman_compressor --bench 32 a.txt b.bin  (also benchmark these files)
+ * ./huffman_compressor c input output      (compress a file as one stream)
+ * ./huffman_compressor b input output [threads]  (compress into blocks)
+ * ./huffman_compressor d input output [threads]  (decompress either format)
+ * ./huffman_compressor x input block output      (decompress one block)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define MAX_CODE_LEN 15                     // Longest code after length limiting
+#define TABLE_BITS 11                       // Primary decode table index width
+#define TABLE_SIZE (1u << TABLE_BITS)
+/*
+ * A prefix with a secondary table holds at least two of the 256 symbols, so
+ * there are at most 128 of them, each with at most 2^(15 - 11) entries.
+ */
+#define SUBTABLE_ENTRIES (128u << (MAX_CODE_LEN - TABLE_BITS))
+#define CHUNK_SIZE (1u << 20)               // Bytes per read in the file drivers
+#define HEADER_SIZE (4 + 8 + 128)
+#define ENCODE_BOUND(n) ((n) * MAX_CODE_LEN / 8 + 16)
+#define PACKED_BOUND(n) (HEADER_SIZE + ENCODE_BOUND(n))  // Largest HUF1 stream for n bytes
+#define BLOCK_SIZE (1u << 20)               // Input bytes per independently coded block
+#define MAX_BLOCK_SIZE (1u << 26)           // Largest block size a reader accepts
+#define BLOCKS_PER_THREAD 4                 // Blocks in flight per thread in the file drivers
+#define BLOCK_HEADER_SIZE (4 + 8)
+#define TRAILER_SIZE 32
+#define MAX_THREADS 64
+
+static const unsigned char MAGIC[4] = { 'H', 'U', 'F', '1' };
+static const unsigned char BLOCK_MAGIC[4] = { 'H', 'U', 'F', 'B' };
+
+/* ---------- Unaligned little-endian access ---------- */
+
+static inline uint64_t load64(const uint8_t *p) {
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline void store64(uint8_t *p, uint64_t v) {
+    memcpy(p, &v, 8);
+}
+
+static void put_u64(uint8_t *p, uint64_t v) {
+    for (int i = 0; i < 8; i++) p[i] = (uint8_t)(v >> (8 * i));
+}
+
+static uint64_t get_u64(const uint8_t *p) {
+    uint64_t v = 0;
+    for (int i = 7; i >= 0; i--) v = (v << 8) | p[i];
+    return v;
+}
+
+/* ---------- Code construction ---------- */
+
+/**
+ * @brief Adds the byte counts of p[0..n) to freq. Four tables let
+ * consecutive equal bytes update different counters.
+ */
+void count_bytes(const uint8_t *p, size_t n, uint64_t freq[256]) {
+    uint32_t c[4][256];
+    memset(c, 0, sizeof(c));
+    size_t i = 0;
+    while (i < n) {
+        // Flush before a 32-bit counter could overflow
+        size_t stop = n - i > (1u << 30) ? i + (1u << 30) : n;
+        for (; i + 4 <= stop; i += 4) {
+            c[0][p[i]]++;
+            c[1][p[i + 1]]++;
+            c[2][p[i + 2]]++;
+            c[3][p[i + 3]]++;
+        }
+        for (; i < stop; i++) c[0][p[i]]++;
+        for (int s = 0; s < 256; s++) {
+            freq[s] += (uint64_t)c[0][s] + c[1][s] + c[2][s] + c[3][s];
+            c[0][s] = c[1][s] = c[2][s] = c[3][s] = 0;
+        }
+    }
+}
+
+typedef struct {
+    uint64_t freq;
+    int symbol;
+} Leaf;
+
+static int compare_leaves(const void *a, const void *b) {
+    const Leaf *x = (const Leaf *)a, *y = (const Leaf *)b;
+    if (x->freq != y->freq) return x->freq < y->freq ? -1 : 1;
+    return x->symbol - y->symbol;
+}
+
+/**
+ * @brief Huffman code lengths for freq, none longer than max_len.
+ *
+ * With the leaves sorted, merged nodes come out in nondecreasing order, so
+ * a second queue replaces the min heap. Codes longer than max_len are then
+ * clamped, which overfills the Kraft sum (sum of 2^-len must be <= 1), and
+ * the rarest symbols still below max_len are lengthened one bit at a time
+ * until it fits. Finally any slack left over is given back to the most
+ * frequent symbols. Returns the number of symbols used.
+ */
+int build_code_lengths(const uint64_t freq[256], int max_len, uint8_t lengths[256]) {
+    Leaf leaves[256];
+    int n = 0;
+    memset(lengths, 0, 256);
+    for (int s = 0; s < 256; s++)
+        if (freq[s]) {
+            leaves[n].freq = freq[s];
+            leaves[n].symbol = s;
+            n++;
+        }
+    if (n == 0) return 0;
+    if (n == 1) {
+        lengths[leaves[0].symbol] = 1;
+        return 1;
+    }
+    qsort(leaves, n, sizeof(Leaf), compare_leaves);
+
+    // Nodes 0..n-1 are the leaves, n..2n-2 the merged nodes in creation order
+    uint64_t weight[511];
+    int parent[511], depth[511];
+    for (int i = 0; i < n; i++) weight[i] = leaves[i].freq;
+    int next_leaf = 0, next_node = n;
+    for (int k = n; k < 2 * n - 1; k++) {
+        int pick[2];
+        for (int j = 0; j < 2; j++) {
+            if (next_leaf < n && (next_node >= k || weight[next_leaf] <= weight[next_node]))
+                pick[j] = next_leaf++;
+            else
+                pick[j] = next_node++;
+        }
+        weight[k] = weight[pick[0]] + weight[pick[1]];
+        parent[pick[0]] = parent[pick[1]] = k;
+    }
+    depth[2 * n - 2] = 0;
+    for (int k = 2 * n - 3; k >= 0; k--) depth[k] = depth[parent[k]] + 1;
+
+    // Kraft sum in units of 2^-max_len; a complete code sums to exactly 2^max_len
+    uint32_t kraft = 0, full = 1u << max_len;
+    int len[256];
+    for (int i = 0; i < n; i++) {
+        len[i] = depth[i] > max_len ? max_len : depth[i];
+        kraft += 1u << (max_len - len[i]);
+    }
+    while (kraft > full) {
+        int i = 0;
+        while (len[i] == max_len) i++;      // Rarest symbol that can still grow
+        len[i]++;
+        kraft -= 1u << (max_len - len[i]);
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        while (len[i] > 1 && kraft + (1u << (max_len - len[i])) <= full) {
+            kraft += 1u << (max_len - len[i]);
+            len[i]--;
+        }
+    }
+    for (int i = 0; i < n; i++) lengths[leaves[i].symbol] = (uint8_t)len[i];
+    return n;
+}
+
+/* Reverses the low len bits of code: the bitstream is LSB first */
+static uint32_t reverse_bits(uint32_t code, int len) {
+    uint32_t r = 0;
+    for (int i = 0; i < len; i++) r |= ((code >> i) & 1u) << (len - 1 - i);
+    return r;
+}
+
+/**
+ * @brief Canonical codes from lengths, bit-reversed for LSB-first output.
+ * Codes of each length are consecutive and ordered by symbol, as in
+ * DEFLATE. Returns -1 if the lengths do not form a valid prefix code.
+ */
+static int canonical_codes(const uint8_t lengths[256], uint32_t codes[256]) {
+    uint32_t count[MAX_CODE_LEN + 1] = { 0 }, next[MAX_CODE_LEN + 1];
+    uint32_t kraft = 0;
+    int used = 0;
+    for (int s = 0; s < 256; s++) {
+        if (lengths[s] > MAX_CODE_LEN) return -1;
+        if (lengths[s]) {
+            count[lengths[s]]++;
+            kraft += 1u << (MAX_CODE_LEN - lengths[s]);
+            used++;
+        }
+    }
+    // A complete code, or the single-symbol code of length 1
+    if (used > 1 && kraft != 1u << MAX_CODE_LEN) return -1;
+    if (used == 1 && kraft != 1u << (MAX_CODE_LEN - 1)) return -1;
+
+    uint32_t code = 0;
+    for (int b = 1; b <= MAX_CODE_LEN; b++) {
+        code = (code + count[b - 1]) << 1;
+        next[b] = code;
+    }
+    for (int s = 0; s < 256; s++)
+        codes[s] = lengths[s] ? reverse_bits(next[lengths[s]]++, lengths[s]) : 0;
+    return used;
+}
+
+/* ---------- Encoder ---------- */
+
+typedef struct {
+    uint32_t entry[256];    // Reversed code | length << 16
+} HuffEncoder;
+
+typedef struct {
+    uint64_t bits;          // Pending bits, oldest in bit 0
+    unsigned count;         // Number of pending bits, always < 8 between calls
+} BitWriter;
+
+int build_encoder(const uint8_t lengths[256], HuffEncoder *e) {
+    uint32_t codes[256];
+    if (canonical_codes(lengths, codes) < 0) return -1;
+    for (int s = 0; s < 256; s++) e->entry[s] = codes[s] | (uint32_t)lengths[s] << 16;
+    return 0;
+}
+
+#define PUT_SYMBOL(sym)                                          \
+    do {                                                         \
+        uint32_t en = e->entry[sym];                             \
+        bits |= (uint64_t)(en & 0xFFFF) << count;                \
+        count += en >> 16;                                       \
+    } while (0)
+
+/**
+ * @brief Encodes in[0..n) after the bits already pending in w. Writes whole
+ * bytes to out (which needs ENCODE_BOUND(n) bytes of room) and keeps fewer
+ * than 8 bits pending. Returns the number of bytes written.
+ *
+ * Three codes of at most 15 bits on top of at most 7 pending bits fit in
+ * 52 bits, so one 8-byte store per three symbols is enough.
+ */
+size_t huff_encode(const HuffEncoder *e, BitWriter *w, const uint8_t *in, size_t n, uint8_t *out) {
+    uint8_t *o = out;
+    uint64_t bits = w->bits;
+    unsigned count = w->count;
+    size_t i = 0;
+    for (; i + 3 <= n; i += 3) {
+        PUT_SYMBOL(in[i]);
+        PUT_SYMBOL(in[i + 1]);
+        PUT_SYMBOL(in[i + 2]);
+        store64(o, bits);
+        o += count >> 3;
+        bits >>= count & ~7u;
+        count &= 7;
+    }
+    for (; i < n; i++) {
+        PUT_SYMBOL(in[i]);
+        store64(o, bits);
+        o += count >> 3;
+        bits >>= count & ~7u;
+        count &= 7;
+    }
+    w->bits = bits;
+    w->count = count;
+    return (size_t)(o - out);
+}
+
+/* Writes the last partial byte, if any. Returns the bytes written. */
+size_t huff_encode_finish(BitWriter *w, uint8_t *out) {
+    if (w->count == 0) return 0;
+    out[0] = (uint8_t)w->bits;
+    w->bits = 0;
+    w->count = 0;
+    return 1;
+}
+
+/* ---------- Decoder ---------- */
+
+/*
+ * Entry layout: first symbol in bits 0-7, second symbol in bits 8-15, bits
+ * used by both in bits 16-23, number of symbols (1 or 2) in bits 24-27,
+ * bits used by the first symbol alone in bits 28-31.
+ *
+ * A primary entry with 0 symbols links to a secondary table for codes
+ * longer than TABLE_BITS: its offset in entry[] is in bits 0-15 and its
+ * index width in bits 16-23. It is indexed by the bits after the first
+ * TABLE_BITS and holds single-symbol entries.
+ */
+typedef struct {
+    uint32_t entry[TABLE_SIZE + SUBTABLE_ENTRIES];
+    unsigned subtable_entries;      // Secondary entries in use
+} HuffDecoder;
+
+typedef struct {
+    const uint8_t *p, *end; // Unread input
+    uint64_t bits;          // Bit `count` is bit 0 of *p; bits above count may hold a copy of *p..
+    unsigned count;
+    unsigned padding;       // Zero bits invented past the end of the input, at the top of bits
+} BitReader;
+
+/* True once decoding has used bits past the end of the input: truncated data */
+#define BIT_READER_OVERRUN(r) ((r)->count < (r)->padding)
+
+/**
+ * @brief Fills the decode tables for lengths.
+ *
+ * Codes of up to TABLE_BITS bits are replicated over the primary table.
+ * Each TABLE_BITS index is decoded once for its first symbol; the bits
+ * left over are looked up again, and if a whole second code fits in them
+ * it is stored in the same entry. Longer codes share a primary entry per
+ * TABLE_BITS prefix, which links to a secondary table as wide as the
+ * longest code under that prefix needs.
+ */
+int build_decoder(const uint8_t lengths[256], HuffDecoder *d) {
+    uint32_t codes[256];
+    uint16_t single[TABLE_SIZE];        // Symbol | length << 8; 0 for a longer code's prefix
+    uint8_t sub_bits[TABLE_SIZE];       // Secondary index width under each prefix, or 0
+    int used = canonical_codes(lengths, codes);
+    if (used < 0) return -1;
+    memset(single, 0, sizeof(single));
+    memset(sub_bits, 0, sizeof(sub_bits));
+    for (int s = 0; s < 256; s++) {
+        if (!lengths[s]) continue;
+        if (lengths[s] > TABLE_BITS) {
+            uint32_t prefix = codes[s] & (TABLE_SIZE - 1), k = lengths[s] - TABLE_BITS;
+            if (k > sub_bits[prefix]) sub_bits[prefix] = (uint8_t)k;
+            continue;
+        }
+        uint32_t step = 1u << lengths[s];
+        for (uint32_t i = codes[s]; i < TABLE_SIZE; i += step) single[i] = (uint16_t)(s | lengths[s] << 8);
+        if (used == 1)      // The unused half of a one-symbol code decodes as that symbol too
+            for (uint32_t i = 0; i < TABLE_SIZE; i++) single[i] = (uint16_t)(s | 1 << 8);
+    }
+
+    // Secondary tables are laid out after the primary one
+    uint32_t next_free = TABLE_SIZE;
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        if (!sub_bits[i]) continue;
+        d->entry[i] = next_free | (uint32_t)sub_bits[i] << 16;
+        next_free += 1u << sub_bits[i];
+    }
+    for (int s = 0; s < 256; s++) {
+        if (lengths[s] <= TABLE_BITS) continue;
+        uint32_t link = d->entry[codes[s] & (TABLE_SIZE - 1)];
+        uint32_t base = link & 0xFFFF, width = 1u << ((link >> 16) & 0xFF);
+        uint32_t len = lengths[s];
+        for (uint32_t j = codes[s] >> TABLE_BITS; j < width; j += 1u << (len - TABLE_BITS))
+            d->entry[base + j] = (uint32_t)s | len << 16 | 1u << 24 | len << 28;
+    }
+    d->subtable_entries = next_free - TABLE_SIZE;
+
+    for (uint32_t i = 0; i < TABLE_SIZE; i++) {
+        if (sub_bits[i]) continue;
+        uint32_t s1 = single[i] & 0xFF, l1 = single[i] >> 8;
+        uint32_t next = single[i >> l1];
+        uint32_t s2 = next & 0xFF, l2 = next >> 8;
+        if (l2 && l1 + l2 <= TABLE_BITS)
+            d->entry[i] = s1 | s2 << 8 | (l1 + l2) << 16 | 2u << 24 | l1 << 28;
+        else
+            d->entry[i] = s1 | l1 << 16 | 1u << 24 | l1 << 28;
+    }
+    return 0;
+}
+
+/* The entry for the code at the bottom of bits, following a secondary link */
+static inline uint32_t lookup(const HuffDecoder *d, uint64_t bits) {
+    uint32_t en = d->entry[bits & (TABLE_SIZE - 1)];
+    if (((en >> 24) & 0xF) == 0)
+        en = d->entry[(en & 0xFFFF) + ((bits >> TABLE_BITS) & ((1u << ((en >> 16) & 0xFF)) - 1))];
+    return en;
+}
+
+/* Tops the buffer up to at least 56 bits with one unaligned load */
+#define REFILL_FAST()                            \
+    do {                                         \
+        bits |= load64(p) << count;              \
+        p += (63 - count) >> 3;                  \
+        count |= 56;                             \
+    } while (0)
+
+/*
+ * Refill near the end of the input, a byte at a time. Runs `stall` when
+ * more input is needed and final is not set; with final set the stream is
+ * padded with zero bits instead.
+ */
+#define REFILL_TAIL(stall)                               \
+    do {                                                 \
+        if (r->end - p >= 8) {                           \
+            REFILL_FAST();                               \
+        } else {                                         \
+            while (count <= 56 && p < r->end) {          \
+                bits |= (uint64_t)*p++ << count;         \
+                count += 8;                              \
+            }                                            \
+            if (count < MAX_CODE_LEN) {                  \
+                if (!final) stall;                       \
+                r->padding += 56 - count;                \
+                count = 56;                              \
+            }                                            \
+        }                                                \
+    } while (0)
+
+#define DECODE_PAIR()                            \
+    do {                                         \
+        uint32_t en = lookup(d, bits);           \
+        o[0] = (uint8_t)en;                      \
+        o[1] = (uint8_t)(en >> 8);               \
+        o += (en >> 24) & 0xF;                   \
+        bits >>= (en >> 16) & 0xFF;              \
+        count -= (en >> 16) & 0xFF;              \
+    } while (0)
+
+/**
+ * @brief Decodes up to n symbols from r into out. Stops early when fewer
+ * than 8 input bytes are left, unless final is set, in which case missing
+ * bits read as zero (BIT_READER_OVERRUN then tells whether any were used).
+ * Returns the number of symbols written.
+ *
+ * The fast loop refills once per three lookups: each uses at most
+ * MAX_CODE_LEN = 15 bits, and a refill leaves at least 56.
+ */
+size_t huff_decode(const HuffDecoder *d, BitReader *r, uint8_t *out, size_t n, int final) {
+    uint8_t *o = out, *o_end = out + n;
+    const uint8_t *p = r->p;
+    uint64_t bits = r->bits;
+    unsigned count = r->count;
+
+    while (r->end - p >= 8 && o_end - o >= 6) {
+        REFILL_FAST();
+        DECODE_PAIR();
+        DECODE_PAIR();
+        DECODE_PAIR();
+    }
+
+    // One symbol at a time near the end of the input or the output
+    while (o < o_end) {
+        if (count < MAX_CODE_LEN) REFILL_TAIL(goto stalled);
+        uint32_t en = lookup(d, bits);
+        *o++ = (uint8_t)en;
+        bits >>= en >> 28;
+        count -= en >> 28;
+    }
+
+stalled:
+    r->p = p;
+    r->bits = bits;
+    r->count = count;
+    return (size_t)(o - out);
+}
+
+/* ---------- Tree-walk decoder (for comparison) ---------- */
+
+/* The code tree of huffman_coding_stub.c, rebuilt from the canonical codes */
+typedef struct TreeNode {
+    struct TreeNode *child[2];
+    int symbol;                 // -1 for internal nodes
+} TreeNode;
+
+typedef struct {
+    TreeNode nodes[511];
+    int node_count;
+} HuffTree;
+
+int build_tree(const uint8_t lengths[256], HuffTree *t) {
+    uint32_t codes[256];
+    int used = canonical_codes(lengths, codes);
+    if (used < 0) return -1;
+    memset(t->nodes, 0, sizeof(t->nodes));
+    t->nodes[0].symbol = -1;
+    t->node_count = 1;
+    for (int s = 0; s < 256; s++) {
+        TreeNode *node = &t->nodes[0];
+        for (int b = 0; b < lengths[s]; b++) {      // Codes are stored in stream order, LSB first
+            int bit = (codes[s] >> b) & 1;
+            if (node->child[bit] == NULL) {
+                TreeNode *child = &t->nodes[t->node_count++];
+                child->symbol = -1;
+                node->child[bit] = child;
+            }
+            node = node->child[bit];
+        }
+        if (lengths[s]) node->symbol = s;
+    }
+    if (used == 1) t->nodes[0].child[1] = t->nodes[0].child[0];
+    return 0;
+}
+
+/* Same contract as huff_decode, following one child pointer per bit */
+size_t tree_decode(const HuffTree *t, BitReader *r, uint8_t *out, size_t n, int final) {
+    const uint8_t *p = r->p;
+    uint64_t bits = r->bits;
+    unsigned count = r->count;
+    size_t i = 0;
+    for (; i < n; i++) {
+        if (count < MAX_CODE_LEN) REFILL_TAIL(goto stalled);
+        const TreeNode *node = &t->nodes[0];
+        while (node->symbol < 0) {
+            node = node->child[bits & 1];
+            bits >>= 1;
+            count--;
+        }
+        out[i] = (uint8_t)node->symbol;
+    }
+stalled:
+    r->p = p;
+    r->bits = bits;
+    r->count = count;
+    return i;
+}
+
+/* ---------- Whole buffers ---------- */
+
+static void write_header(uint8_t *h, uint64_t size, const uint8_t lengths[256]) {
+    memcpy(h, MAGIC, 4);
+    put_u64(h + 4, size);
+    for (int i = 0; i < 128; i++) h[12 + i] = (uint8_t)(lengths[2 * i] | lengths[2 * i + 1] << 4);
+}
+
+static int read_header(const uint8_t *h, uint64_t *size, uint8_t lengths[256]) {
+    if (memcmp(h, MAGIC, 4) != 0) return -1;
+    *size = get_u64(h + 4);
+    for (int i = 0; i < 128; i++) {
+        lengths[2 * i] = h[12 + i] & 0xF;
+        lengths[2 * i + 1] = h[12 + i] >> 4;
+    }
+    return 0;
+}
+
+/**
+ * @brief Compresses in[0..n) into out, which needs HEADER_SIZE +
+ * ENCODE_BOUND(n) bytes. Returns the compressed size.
+ */
+size_t huff_compress(const uint8_t *in, size_t n, uint8_t *out) {
+    uint64_t freq[256] = { 0 };
+    uint8_t lengths[256];
+    HuffEncoder e;
+    BitWriter w = { 0, 0 };
+    count_bytes(in, n, freq);
+    build_code_lengths(freq, MAX_CODE_LEN, lengths);
+    if (n) build_encoder(lengths, &e);
+    write_header(out, n, lengths);
+    size_t size = HEADER_SIZE;
+    if (n) {
+        size += huff_encode(&e, &w, in, n, out + size);
+        size += huff_encode_finish(&w, out + size);
+    }
+    return size;
+}
+
+/**
+ * @brief Decompresses in[0..size) into out (capacity bytes). Returns the
+ * original size, or (size_t)-1 for a bad header or a small buffer.
+ */
+size_t huff_decompress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity) {
+    uint8_t lengths[256];
+    uint64_t n;
+    HuffDecoder d;          // On the stack: block workers decode concurrently
+    if (size < HEADER_SIZE || read_header(in, &n, lengths) != 0 || n > capacity) return (size_t)-1;
+    if (n == 0) return 0;
+    if (build_decoder(lengths, &d) != 0) return (size_t)-1;
+    BitReader r = { in + HEADER_SIZE, in + size, 0, 0, 0 };
+    size_t produced = huff_decode(&d, &r, out, (size_t)n, 1);
+    return BIT_READER_OVERRUN(&r) ? (size_t)-1 : produced;
+}
+
+/* huff_decompress with the tree-walk decoder, for the benchmark */
+size_t tree_decompress(const uint8_t *in, size_t size, uint8_t *out, size_t capacity) {
+    uint8_t lengths[256];
+    uint64_t n;
+    HuffTree t;
+    if (size < HEADER_SIZE || read_header(in, &n, lengths) != 0 || n > capacity) return (size_t)-1;
+    if (n == 0) return 0;
+    if (build_tree(lengths, &t) != 0) return (size_t)-1;
+    BitReader r = { in + HEADER_SIZE, in + size, 0, 0, 0 };
+    size_t produced = tree_decode(&t, &r, out, (size_t)n, 1);
+    return BIT_READER_OVERRUN(&r) ? (size_t)-1 : produced;
+}
+
+/* ---------- Files ---------- */
+
+/*
+ * Two passes over the input: one to count, one to encode, so the input must
+ * be seekable. Memory use is two chunk buffers regardless of file size.
+ */
+int compress_file(FILE *in, FILE *out, uint64_t *in_size, uint64_t *out_size) {
+    uint8_t *buf = (uint8_t *)malloc(CHUNK_SIZE);
+    uint8_t *obuf = (uint8_t *)malloc(ENCODE_BOUND((size_t)CHUNK_SIZE));
+    uint64_t freq[256] = { 0 }, n = 0;
+    uint8_t lengths[256], header[HEADER_SIZE];
+    HuffEncoder e;
+    BitWriter w = { 0, 0 };
+    size_t got;
+    int status = -1;
+    if (buf == NULL || obuf == NULL) goto done;
+
+    while ((got = fread(buf, 1, CHUNK_SIZE, in)) > 0) {
+        count_bytes(buf, got, freq);
+        n += got;
+    }
+    if (ferror(in) || fseek(in, 0, SEEK_SET) != 0) goto done;
+    build_code_lengths(freq, MAX_CODE_LEN, lengths);
+    if (n) build_encoder(lengths, &e);
+    write_header(header, n, lengths);
+    if (fwrite(header, 1, HEADER_SIZE, out) != HEADER_SIZE) goto done;
+    *out_size = HEADER_SIZE;
+
+    while ((got = fread(buf, 1, CHUNK_SIZE, in)) > 0) {
+        size_t bytes = huff_encode(&e, &w, buf, got, obuf);
+        if (fwrite(obuf, 1, bytes, out) != bytes) goto done;
+        *out_size += bytes;
+    }
+    got = huff_encode_finish(&w, obuf);
+    if (ferror(in) || fwrite(obuf, 1, got, out) != got) goto done;
+    *out_size += got;
+    *in_size = n;
+    status = 0;
+done:
+    free(buf);
+    free(obuf);
+    return status;
+}
+
+int decompress_file(FILE *in, FILE *out, uint64_t *out_size) {
+    uint8_t *buf = (uint8_t *)malloc(CHUNK_SIZE);
+    uint8_t *obuf = (uint8_t *)malloc(CHUNK_SIZE);
+    HuffDecoder *d = (HuffDecoder *)malloc(sizeof(HuffDecoder));
+    uint8_t lengths[256], header[HEADER_SIZE];
+    uint64_t n, remaining;
+    BitReader r = { NULL, NULL, 0, 0, 0 };
+    size_t have = 0;
+    int final = 0, status = -1;
+    if (buf == NULL || obuf == NULL || d == NULL) goto done;
+    if (fread(header, 1, HEADER_SIZE, in) != HEADER_SIZE || read_header(header, &n, lengths) != 0) goto done;
+    if (n && build_decoder(lengths, d) != 0) goto done;
+
+    for (remaining = n; remaining > 0;) {
+        // Move the unread tail to the front and top the buffer up
+        have = r.p ? (size_t)(r.end - r.p) : 0;
+        if (have) memmove(buf, r.p, have);
+        if (!final) {
+            have += fread(buf + have, 1, CHUNK_SIZE - have, in);
+            final = feof(in) || ferror(in);
+        }
+        r.p = buf;
+        r.end = buf + have;
+        size_t want = remaining < CHUNK_SIZE ? (size_t)remaining : CHUNK_SIZE;
+        size_t produced = huff_decode(d, &r, obuf, want, final);
+        if (produced == 0 && final) goto done;
+        if (fwrite(obuf, 1, produced, out) != produced) goto done;
+        remaining -= produced;
+    }
+    *out_size = n;
+    status = ferror(in) || BIT_READER_OVERRUN(&r) ? -1 : 0;
+done:
+    free(buf);
+    free(obuf);
+    free(d);
+    return status;
+}
+
+/* ---------- Thread pool ---------- */
+
+typedef void (*task_fn)(void *arg, size_t index);
+
+/*
+ * Workers start once and sleep between batches. pool_run hands out the
+ * tasks of one batch through a shared counter, as prime_sieve_segmented.c
+ * does with slabs, and the calling thread takes tasks too.
+ */
+typedef struct {
+    pthread_t threads[MAX_THREADS];
+    int worker_count;           // Threads besides the caller
+    pthread_mutex_t lock;
+    pthread_cond_t batch_ready, batch_done;
+    unsigned generation;        // Bumped once per batch
+    int busy;                   // Workers not yet finished with the current batch
+    int shutdown;
+    task_fn fn;
+    void *arg;
+    size_t task_count;
+    size_t next_task;
+} ThreadPool;
+
+static void run_tasks(ThreadPool *pool) {
+    for (;;) {
+        size_t i = __atomic_fetch_add(&pool->next_task, 1, __ATOMIC_RELAXED);
+        if (i >= pool->task_count) break;
+        pool->fn(pool->arg, i);
+    }
+}
+
+static void *pool_worker(void *arg) {
+    ThreadPool *pool = (ThreadPool *)arg;
+    unsigned seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (pool->generation == seen && !pool->shutdown) pthread_cond_wait(&pool->batch_ready, &pool->lock);
+        if (pool->shutdown) break;
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+        run_tasks(pool);
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->busy == 0) pthread_cond_signal(&pool->batch_done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+/*
+ * Starts threads - 1 workers. If some cannot be created the pool just has
+ * fewer; returns the number of threads that will run tasks, or 0 if the
+ * pool could not be set up at all.
+ */
+int pool_init(ThreadPool *pool, int threads) {
+    memset(pool, 0, sizeof(*pool));
+    if (pthread_mutex_init(&pool->lock, NULL) != 0) return 0;
+    if (pthread_cond_init(&pool->batch_ready, NULL) != 0) {
+        pthread_mutex_destroy(&pool->lock);
+        return 0;
+    }
+    if (pthread_cond_init(&pool->batch_done, NULL) != 0) {
+        pthread_cond_destroy(&pool->batch_ready);
+        pthread_mutex_destroy(&pool->lock);
+        return 0;
+    }
+    for (int t = 0; t < threads - 1 && t < MAX_THREADS; t++) {
+        if (pthread_create(&pool->threads[t], NULL, pool_worker, pool) != 0) break;
+        pool->worker_count++;
+    }
+    return pool->worker_count + 1;
+}
+
+/* Runs fn(arg, i) for i in [0, count) on the pool and waits for all of them */
+void pool_run(ThreadPool *pool, task_fn fn, void *arg, size_t count) {
+    pthread_mutex_lock(&pool->lock);
+    pool->fn = fn;
+    pool->arg = arg;
+    pool->task_count = count;
+    pool->next_task = 0;
+    pool->busy = pool->worker_count;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->batch_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_tasks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->busy > 0) pthread_cond_wait(&pool->batch_done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->batch_ready);
+    pthread_mutex_unlock(&pool->lock);
+    for (int t = 0; t < pool->worker_count; t++) pthread_join(pool->threads[t], NULL);
+    pthread_cond_destroy(&pool->batch_ready);
+    pthread_cond_destroy(&pool->batch_done);
+    pthread_mutex_destroy(&pool->lock);
+}
+
+/* ---------- Block container ---------- */
+
+typedef struct {
+    const uint8_t *in;
+    size_t in_size;
+    uint8_t *out;
+    size_t out_size;        // Compress: bytes written. Decompress: expected size
+    int status;
+} BlockJob;
+
+static void compress_task(void *arg, size_t i) {
+    BlockJob *job = (BlockJob *)arg + i;
+    job->out_size = huff_compress(job->in, job->in_size, job->out);
+    job->status = 0;
+}
+
+static void decompress_task(void *arg, size_t i) {
+    BlockJob *job = (BlockJob *)arg + i;
+    size_t n = huff_decompress(job->in, job->in_size, job->out, job->out_size);
+    job->status = n == job->out_size ? 0 : -1;
+}
+
+typedef struct {
+    uint64_t block_size;
+    uint64_t block_count;
+    uint64_t size;          // Original size
+    uint64_t *entries;      // Offset and packed size of each block
+} BlockIndex;
+
+static uint64_t block_length(const BlockIndex *bi, uint64_t b) {
+    uint64_t start = b * bi->block_size;
+    return bi->size - start < bi->block_size ? bi->size - start : bi->block_size;
+}
+
+/*
+ * Compresses in one pass, so the input may be a pipe. Each batch of
+ * BLOCKS_PER_THREAD blocks per thread is read, coded on the pool and
+ * written in order; the index is kept in memory and written at the end.
+ */
+int block_compress_file(FILE *in, FILE *out, ThreadPool *pool, int threads, uint64_t *in_size,
+                        uint64_t *out_size) {
+    size_t batch = (size_t)threads * BLOCKS_PER_THREAD;
+    uint8_t *ibuf = (uint8_t *)malloc(batch * BLOCK_SIZE);
+    uint8_t *obuf = (uint8_t *)malloc(batch * PACKED_BOUND((size_t)BLOCK_SIZE));
+    BlockJob *jobs = (BlockJob *)malloc(batch * sizeof(BlockJob));
+    uint64_t *entries = NULL, total = 0, offset = BLOCK_HEADER_SIZE;
+    size_t blocks = 0, capacity = 0;
+    uint8_t bytes[TRAILER_SIZE];
+    int status = -1;
+    if (ibuf == NULL || obuf == NULL || jobs == NULL) goto done;
+
+    memcpy(bytes, BLOCK_MAGIC, 4);
+    put_u64(bytes + 4, BLOCK_SIZE);
+    if (fwrite(bytes, 1, BLOCK_HEADER_SIZE, out) != BLOCK_HEADER_SIZE) goto done;
+
+    for (;;) {
+        size_t got = fread(ibuf, 1, batch * BLOCK_SIZE, in);
+        if (got == 0) break;
+        size_t count = (got + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        for (size_t j = 0; j < count; j++) {
+            jobs[j].in = ibuf + j * BLOCK_SIZE;
+            jobs[j].in_size = got - j * BLOCK_SIZE < BLOCK_SIZE ? got - j * BLOCK_SIZE : BLOCK_SIZE;
+            jobs[j].out = obuf + j * PACKED_BOUND((size_t)BLOCK_SIZE);
+        }
+        pool_run(pool, compress_task, jobs, count);
+
+        if (blocks + count > capacity) {
+            capacity = capacity ? capacity * 2 : 256;
+            uint64_t *bigger = (uint64_t *)realloc(entries, capacity * 2 * sizeof(uint64_t));
+            if (bigger == NULL) goto done;
+            entries = bigger;
+        }
+        for (size_t j = 0; j < count; j++) {
+            if (fwrite(jobs[j].out, 1, jobs[j].out_size, out) != jobs[j].out_size) goto done;
+            entries[2 * blocks] = offset;
+            entries[2 * blocks + 1] = jobs[j].out_size;
+            offset += jobs[j].out_size;
+            blocks++;
+        }
+        total += got;
+        if (got < batch * BLOCK_SIZE) break;
+    }
+    if (ferror(in)) goto done;
+
+    uint64_t index_offset = offset;
+    for (size_t b = 0; b < blocks; b++) {
+        put_u64(bytes, entries[2 * b]);
+        put_u64(bytes + 8, entries[2 * b + 1]);
+        if (fwrite(bytes, 1, 16, out) != 16) goto done;
+    }
+    memset(bytes, 0, TRAILER_SIZE);
+    put_u64(bytes, index_offset);
+    put_u64(bytes + 8, blocks);
+    put_u64(bytes + 16, total);
+    memcpy(bytes + 24, BLOCK_MAGIC, 4);
+    if (fwrite(bytes, 1, TRAILER_SIZE, out) != TRAILER_SIZE) goto done;
+    *in_size = total;
+    *out_size = index_offset + 16 * (uint64_t)blocks + TRAILER_SIZE;
+    status = 0;
+done:
+    free(ibuf);
+    free(obuf);
+    free(jobs);
+    free(entries);
+    return status;
+}
+
+/* Reads and checks the header, trailer and index. Returns -1 on bad input. */
+static int read_block_index(FILE *in, BlockIndex *bi) {
+    uint8_t bytes[TRAILER_SIZE];
+    bi->entries = NULL;
+    if (fseeko(in, 0, SEEK_SET) != 0 || fread(bytes, 1, BLOCK_HEADER_SIZE, in) != BLOCK_HEADER_SIZE ||
+        memcmp(bytes, BLOCK_MAGIC, 4) != 0)
+        return -1;
+    bi->block_size = get_u64(bytes + 4);
+    if (fseeko(in, -TRAILER_SIZE, SEEK_END) != 0) return -1;
+    off_t trailer_offset = ftello(in);
+    if (fread(bytes, 1, TRAILER_SIZE, in) != TRAILER_SIZE || memcmp(bytes + 24, BLOCK_MAGIC, 4) != 0) return -1;
+    uint64_t index_offset = get_u64(bytes);
+    bi->block_count = get_u64(bytes + 8);
+    bi->size = get_u64(bytes + 16);
+
+    if (bi->block_size == 0 || bi->block_size > MAX_BLOCK_SIZE) return -1;
+    if (bi->block_count != (bi->size + bi->block_size - 1) / bi->block_size) return -1;
+    if (index_offset < BLOCK_HEADER_SIZE || bi->block_count > (uint64_t)trailer_offset / 16 ||
+        index_offset + 16 * bi->block_count != (uint64_t)trailer_offset)
+        return -1;
+
+    bi->entries = (uint64_t *)malloc((bi->block_count ? bi->block_count : 1) * 2 * sizeof(uint64_t));
+    if (bi->entries == NULL || fseeko(in, (off_t)index_offset, SEEK_SET) != 0) return -1;
+    for (uint64_t b = 0; b < bi->block_count; b++) {
+        if (fread(bytes, 1, 16, in) != 16) return -1;
+        uint64_t offset = get_u64(bytes), packed = get_u64(bytes + 8);
+        if (offset < BLOCK_HEADER_SIZE || packed > PACKED_BOUND(bi->block_size) || offset + packed > index_offset)
+            return -1;
+        bi->entries[2 * b] = offset;
+        bi->entries[2 * b + 1] = packed;
+    }
+    return 0;
+}
+
+/* Reads blocks [first, first + count) into jobs, packed streams stored `stride` apart in buf */
+static int read_blocks(FILE *in, const BlockIndex *bi, uint64_t first, size_t count, uint8_t *buf,
+                       size_t stride, uint8_t *obuf, BlockJob *jobs) {
+    for (size_t j = 0; j < count; j++) {
+        uint64_t b = first + j;
+        size_t packed = (size_t)bi->entries[2 * b + 1];
+        if (fseeko(in, (off_t)bi->entries[2 * b], SEEK_SET) != 0 || fread(buf + j * stride, 1, packed, in) != packed)
+            return -1;
+        jobs[j].in = buf + j * stride;
+        jobs[j].in_size = packed;
+        jobs[j].out = obuf + j * bi->block_size;
+        jobs[j].out_size = (size_t)block_length(bi, b);
+    }
+    return 0;
+}
+
+int block_decompress_file(FILE *in, FILE *out, ThreadPool *pool, int threads, uint64_t *out_size) {
+    BlockIndex bi;
+    uint8_t *ibuf = NULL, *obuf = NULL;
+    BlockJob *jobs = NULL;
+    int status = -1;
+    if (read_block_index(in, &bi) != 0) goto done;
+
+    size_t batch = (size_t)threads * BLOCKS_PER_THREAD, stride = PACKED_BOUND((size_t)bi.block_size);
+    ibuf = (uint8_t *)malloc(batch * stride);
+    obuf = (uint8_t *)malloc(batch * bi.block_size);
+    jobs = (BlockJob *)malloc(batch * sizeof(BlockJob));
+    if (ibuf == NULL || obuf == NULL || jobs == NULL) goto done;
+
+    for (uint64_t first = 0; first < bi.block_count; first += batch) {
+        size_t count = bi.block_count - first < batch ? (size_t)(bi.block_count - first) : batch;
+        if (read_blocks(in, &bi, first, count, ibuf, stride, obuf, jobs) != 0) goto done;
+        pool_run(pool, decompress_task, jobs, count);
+        for (size_t j = 0; j < count; j++)
+            if (jobs[j].status != 0 || fwrite(jobs[j].out, 1, jobs[j].out_size, out) != jobs[j].out_size) goto done;
+    }
+    *out_size = bi.size;
+    status = 0;
+done:
+    free(bi.entries);
+    free(ibuf);
+    free(obuf);
+    free(jobs);
+    return status;
+}
+
+/* Random access: decodes block b alone, reading only the index and that block */
+int block_extract_file(FILE *in, uint64_t b, FILE *out, uint64_t *out_size) {
+    BlockIndex bi;
+    uint8_t *ibuf = NULL, *obuf = NULL;
+    BlockJob job;
+    int status = -1;
+    if (read_block_index(in, &bi) != 0 || b >= bi.block_count) goto done;
+    ibuf = (uint8_t *)malloc((size_t)bi.entries[2 * b + 1]);
+    obuf = (uint8_t *)malloc((size_t)bi.block_size);
+    if (ibuf == NULL || obuf == NULL || read_blocks(in, &bi, b, 1, ibuf, 0, obuf, &job) != 0) goto done;
+    decompress_task(&job, 0);
+    if (job.status != 0 || fwrite(job.out, 1, job.out_size, out) != job.out_size) goto done;
+    *out_size = job.out_size;
+    status = 0;
+done:
+    free(bi.entries);
+    free(ibuf);
+    free(obuf);
+    return status;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* English-like text: Zipf-ish word choice, punctuation and line breaks */
+static void make_text(uint8_t *p, size_t n, uint64_t seed) {
+    static const char *words[] = {
+        "the", "of", "and", "to", "in", "a", "is", "that", "for", "it", "as", "was", "with",
+        "be", "by", "on", "not", "he", "this", "are", "or", "his", "from", "at", "which",
+        "but", "have", "an", "had", "they", "you", "were", "their", "one", "all", "we",
+        "can", "her", "has", "there", "been", "if", "more", "when", "will", "would", "who",
+        "so", "no", "algorithm", "memory", "table", "symbol", "frequency", "compression",
+        "decoder", "stream", "buffer", "length", "canonical", "prefix", "throughput",
+    };
+    const size_t word_count = sizeof(words) / sizeof(words[0]);
+    size_t i = 0, column = 0;
+    while (i < n) {
+        uint64_t r = next_random(&seed);
+        double u = (double)(r >> 11) / 9007199254740992.0;
+        const char *w = words[(size_t)(u * u * u * word_count)];
+        for (size_t k = 0; w[k] && i < n; k++) p[i++] = (uint8_t)w[k];
+        column += strlen(w) + 1;
+        if (i >= n) break;
+        if ((r & 15) == 0) p[i++] = ',';
+        else if ((r & 31) == 1) p[i++] = '.';
+        if (i < n) p[i++] = column > 72 ? '\n' : ' ';
+        if (column > 72) column = 0;
+    }
+}
+
+/* Binary records: a counter, a random-walk sample and flag bytes */
+static void make_binary(uint8_t *p, size_t n, uint64_t seed) {
+    uint32_t counter = 0;
+    int32_t sample = 0;
+    for (size_t i = 0; i < n; i += 12) {
+        uint64_t r = next_random(&seed);
+        uint8_t record[12];
+        counter += 1 + (uint32_t)(r & 3);
+        sample += (int32_t)((r >> 8) % 201) - 100;
+        memcpy(record, &counter, 4);
+        memcpy(record + 4, &sample, 4);
+        record[8] = (uint8_t)((r >> 20) & 1);
+        record[9] = 0;
+        record[10] = (uint8_t)((r >> 24) % 3);
+        record[11] = 0xFF;
+        memcpy(p + i, record, n - i < 12 ? n - i : 12);
+    }
+}
+
+static void make_random(uint8_t *p, size_t n, uint64_t seed) {
+    for (size_t i = 0; i < n; i++) p[i] = (uint8_t)(next_random(&seed) >> 32);
+}
+
+/* Geometric byte values: unlimited Huffman codes would run past 20 bits */
+static void make_skewed(uint8_t *p, size_t n, uint64_t seed) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t r = next_random(&seed);
+        p[i] = (uint8_t)(r ? __builtin_ctzll(r) * 7 : 255);
+    }
+}
+
+static uint8_t *read_whole_file(const char *path, size_t *n) {
+    FILE *f = fopen(path, "rb");
+    if (f == NULL) return NULL;
+    size_t capacity = 1 << 20, size = 0, got;
+    uint8_t *data = (uint8_t *)malloc(capacity);
+    while (data && (got = fread(data + size, 1, capacity - size, f)) > 0) {
+        size += got;
+        if (size == capacity) {
+            uint8_t *bigger = (uint8_t *)realloc(data, capacity * 2);
+            if (bigger == NULL) free(data);
+            data = bigger;
+            capacity *= 2;
+        }
+    }
+    fclose(f);
+    *n = size;
+    return data;
+}
+
+/* Round-trips one corpus through both decoders; returns 1 on a mismatch */
+static int bench_corpus(const char *name, const uint8_t *data, size_t n) {
+    uint8_t *packed = (uint8_t *)malloc(HEADER_SIZE + ENCODE_BOUND(n));
+    uint8_t *restored = (uint8_t *)malloc(n + 1);
+    HuffDecoder d;
+    if (packed == NULL || restored == NULL) {
+        printf("%-14s: not enough memory, skipped.\n", name);
+        free(packed);
+        free(restored);
+        return 0;
+    }
+    double megabytes = n / 1048576.0;
+
+    double t0 = now_seconds();
+    size_t size = huff_compress(data, n, packed);
+    double t_encode = now_seconds() - t0;
+
+    t0 = now_seconds();
+    size_t out = huff_decompress(packed, size, restored, n);
+    double t_table = now_seconds() - t0;
+    int wrong = out != n || memcmp(data, restored, n) != 0;
+
+    memset(restored, 0, n);
+    t0 = now_seconds();
+    out = tree_decompress(packed, size, restored, n);
+    double t_tree = now_seconds() - t0;
+    wrong |= out != n || memcmp(data, restored, n) != 0;
+
+    uint8_t lengths[256];
+    uint64_t original;
+    int longest = 0;
+    read_header(packed, &original, lengths);
+    for (int s = 0; s < 256; s++) longest = lengths[s] > longest ? lengths[s] : longest;
+    d.subtable_entries = 0;
+    if (n) build_decoder(lengths, &d);
+
+    printf("%-14s %7.3f %5d %6u %12.1f %12.1f %12.1f %8.2fx %8s\n", name, n ? (double)n / size : 0.0,
+           longest, d.subtable_entries, megabytes / t_encode, megabytes / t_table, megabytes / t_tree,
+           t_tree / t_table, wrong ? "MISMATCH" : "ok");
+    free(packed);
+    free(restored);
+    return wrong;
+}
+
+/*
+ * Block-parallel round trip of one corpus for 1, 2, 4, ... threads up to
+ * max_threads, plus the latency of decoding a single block on its own.
+ * Returns 1 on a mismatch.
+ */
+static int bench_blocks(const char *name, const uint8_t *data, size_t n, int max_threads) {
+    size_t blocks = (n + BLOCK_SIZE - 1) / BLOCK_SIZE, stride = PACKED_BOUND((size_t)BLOCK_SIZE);
+    uint8_t *packed = (uint8_t *)malloc(blocks * stride);
+    uint8_t *restored = (uint8_t *)malloc(n);
+    BlockJob *jobs = (BlockJob *)malloc(blocks * sizeof(BlockJob));
+    size_t *packed_size = (size_t *)malloc(blocks * sizeof(size_t));
+    int failures = 0;
+    if (packed == NULL || restored == NULL || jobs == NULL || packed_size == NULL) {
+        printf("Block container: not enough memory, skipped.\n");
+        goto done;
+    }
+
+    printf("\nBlock container, %s corpus, %zu blocks of %u KB, %ld CPUs online\n", name, blocks,
+           BLOCK_SIZE >> 10, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%8s %8s %14s %14s %14s %8s\n", "threads", "ratio", "compress MB/s", "decomp MB/s",
+           "1 block ms", "check");
+    for (int t = 1;; t = t * 2 < max_threads ? t * 2 : max_threads) {
+        ThreadPool pool;
+        int threads = pool_init(&pool, t);
+        if (threads == 0) {
+            printf("%8d: cannot start threads, stopping.\n", t);
+            break;
+        }
+
+        for (size_t j = 0; j < blocks; j++) {
+            jobs[j].in = data + j * BLOCK_SIZE;
+            jobs[j].in_size = n - j * BLOCK_SIZE < BLOCK_SIZE ? n - j * BLOCK_SIZE : BLOCK_SIZE;
+            jobs[j].out = packed + j * stride;
+        }
+        double t0 = now_seconds();
+        pool_run(&pool, compress_task, jobs, blocks);
+        double t_compress = now_seconds() - t0;
+        uint64_t total = BLOCK_HEADER_SIZE + 16 * (uint64_t)blocks + TRAILER_SIZE;
+        for (size_t j = 0; j < blocks; j++) {
+            packed_size[j] = jobs[j].out_size;
+            total += packed_size[j];
+        }
+
+        for (size_t j = 0; j < blocks; j++) {
+            jobs[j].out_size = jobs[j].in_size;
+            jobs[j].in = packed + j * stride;
+            jobs[j].in_size = packed_size[j];
+            jobs[j].out = restored + j * BLOCK_SIZE;
+        }
+        memset(restored, 0, n);
+        t0 = now_seconds();
+        pool_run(&pool, decompress_task, jobs, blocks);
+        double t_decompress = now_seconds() - t0;
+        int wrong = memcmp(data, restored, n) != 0;
+        for (size_t j = 0; j < blocks; j++) wrong |= jobs[j].status != 0;
+
+        // Any block decodes from its own bytes alone
+        const int repeats = 16;
+        t0 = now_seconds();
+        for (int r = 0; r < repeats; r++) decompress_task(jobs, blocks / 2);
+        double t_one = (now_seconds() - t0) / repeats;
+        wrong |= jobs[blocks / 2].status != 0;
+
+        failures += wrong;
+        printf("%8d %8.3f %14.1f %14.1f %14.2f %8s\n", threads, (double)n / total,
+               n / 1048576.0 / t_compress, n / 1048576.0 / t_decompress, t_one * 1e3,
+               wrong ? "MISMATCH" : "ok");
+        pool_destroy(&pool);
+        if (t >= max_threads) break;
+    }
+done:
+    free(packed);
+    free(restored);
+    free(jobs);
+    free(packed_size);
+    return failures;
+}
+
+int run_benchmark(size_t megabytes, char **files, int file_count, int threads) {
+    static const struct {
+        const char *name;
+        void (*make)(uint8_t *, size_t, uint64_t);
+    } corpora[] = {
+        { "text", make_text }, { "binary", make_binary }, { "skewed", make_skewed }, { "random", make_random },
+    };
+    size_t n = megabytes << 20;
+    int failures = 0;
+
+    printf("Huffman, codes <= %d bits, %d-bit primary table; throughput in MB/s\n", MAX_CODE_LEN,
+           TABLE_BITS);
+    printf("%-14s %7s %5s %6s %12s %12s %12s %9s %8s\n", "corpus", "ratio", "max", "second",
+           "encode", "table dec", "tree dec", "speedup", "check");
+
+    uint8_t *data = (uint8_t *)malloc(n);
+    if (data == NULL) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return 1;
+    }
+    for (size_t c = 0; c < sizeof(corpora) / sizeof(corpora[0]); c++) {
+        corpora[c].make(data, n, 0x9E3779B97F4A7C15ULL + c);
+        failures += bench_corpus(corpora[c].name, data, n);
+    }
+    corpora[0].make(data, n, 0x9E3779B97F4A7C15ULL);
+    failures += bench_blocks(corpora[0].name, data, n, threads < 4 ? 4 : threads);   // Exercise the pool on small machines too
+    free(data);
+
+    for (int f = 0; f < file_count; f++) {
+        size_t size;
+        uint8_t *file = read_whole_file(files[f], &size);
+        if (file == NULL) {
+            printf("%-14s: cannot read, skipped.\n", files[f]);
+            continue;
+        }
+        const char *base = strrchr(files[f], '/');
+        failures += bench_corpus(base ? base + 1 : files[f], file, size);
+        free(file);
+    }
+
+    if (failures) {
+        fprintf(stderr, "Error: %d corpora did not round-trip.\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (cpus < MAX_THREADS ? (int)cpus : MAX_THREADS) : 1;
+
+    if (argc == 1 || (argc >= 3 && strcmp(argv[1], "--bench") == 0)) {
+        long megabytes = argc >= 3 ? atol(argv[2]) : 32;
+        if (megabytes <= 0) {
+            fprintf(stderr, "Error: size must be a positive number of megabytes.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)megabytes, argv + 3, argc > 3 ? argc - 3 : 0, threads);
+    }
+
+    char mode = argc >= 4 && strlen(argv[1]) == 1 ? argv[1][0] : '?';
+    int valid = (mode == 'c' && argc == 4) || ((mode == 'b' || mode == 'd') && (argc == 4 || argc == 5)) ||
+                (mode == 'x' && argc == 5);
+    if (!valid) {
+        fprintf(stderr,
+                "Usage: %s [--bench MB [files...] | c input output | b input output [threads] |\n"
+                "        d input output [threads] | x input block output]\n",
+                argv[0]);
+        return 1;
+    }
+    if ((mode == 'b' || mode == 'd') && argc == 5) {
+        threads = atoi(argv[4]);
+        if (threads < 1 || threads > MAX_THREADS) {
+            fprintf(stderr, "Error: threads must be between 1 and %d.\n", MAX_THREADS);
+            return 1;
+        }
+    }
+    const char *out_path = mode == 'x' ? argv[4] : argv[3];
+
+    FILE *in = fopen(argv[2], "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", argv[2]);
+        return 1;
+    }
+    // d handles both formats: look at the magic
+    unsigned char magic[4] = { 0 };
+    if (mode == 'd') {
+        if (fread(magic, 1, 4, in) != 4) magic[0] = 0;
+        rewind(in);
+    }
+    int blocks = mode == 'b' || mode == 'x' || (mode == 'd' && memcmp(magic, BLOCK_MAGIC, 4) == 0);
+
+    FILE *out = fopen(out_path, "wb");
+    if (out == NULL) {
+        fprintf(stderr, "Error: cannot create %s\n", out_path);
+        fclose(in);
+        return 1;
+    }
+
+    ThreadPool pool;
+    if (blocks && mode != 'x' && (threads = pool_init(&pool, threads)) == 0) {
+        fprintf(stderr, "Error: cannot set up the thread pool.\n");
+        fclose(in);
+        fclose(out);
+        return 1;
+    }
+
+    uint64_t in_size = 0, out_size = 0;
+    double t0 = now_seconds();
+    int status;
+    if (mode == 'c') {
+        status = compress_file(in, out, &in_size, &out_size);
+    } else if (mode == 'b') {
+        status = block_compress_file(in, out, &pool, threads, &in_size, &out_size);
+    } else if (mode == 'x') {
+        char *end;
+        unsigned long long b = strtoull(argv[3], &end, 10);
+        status = *end == '\0' ? block_extract_file(in, b, out, &out_size) : -1;
+        in_size = (uint64_t)ftello(in);
+    } else {
+        status = blocks ? block_decompress_file(in, out, &pool, threads, &out_size)
+                        : decompress_file(in, out, &out_size);
+        fseeko(in, 0, SEEK_END);
+        in_size = (uint64_t)ftello(in);
+    }
+    double t = now_seconds() - t0;
+    if (blocks && mode != 'x') pool_destroy(&pool);
+    if (fclose(out) != 0) status = -1;
+    fclose(in);
+    int compressing = mode == 'c' || mode == 'b';
+    if (status != 0) {
+        fprintf(stderr, "Error: %s failed (bad input, I/O error or out of memory).\n",
+                compressing ? "compression" : "decompression");
+        return 1;
+    }
+    printf("%llu -> %llu bytes in %.3f s (%.1f MB/s)\n", (unsigned long long)in_size,
+           (unsigned long long)out_size, t, (compressing ? in_size : out_size) / 1048576.0 / t);
+    return 0;
+}
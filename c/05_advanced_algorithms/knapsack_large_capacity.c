@@ -0,0 +1,972 @@
+/**
+ * @file knapsack_large_capacity.c
+ * @brief 0/1 knapsack engines for instances whose capacity is far too large
+ *        for the capacity-indexed DP in knapsack_problem.c.
+ *
+ * This program demonstrates:
+ * 1. Meet-in-the-middle: enumerate the subsets of each half of the items,
+ *    keep only the Pareto-optimal ones (no lighter subset is worth as
+ *    much), and pair the two sorted lists with one linear sweep.
+ *    O(2^(n/2)) time, practical up to about 40 items
+ * 2. A value-indexed DP: best[v] is the lightest subset worth exactly v,
+ *    so the cost is O(n * total value) whatever the capacity
+ * 3. Best-first branch-and-bound: items sorted by value density, the
+ *    fractional (LP) relaxation as the upper bound, a binary heap of open
+ *    nodes, and a greedy solution as the first incumbent
+ * 4. Picking the engine from the instance's shape (item count, capacity,
+ *    total value) with cost estimates, after a short branch-and-bound
+ *    probe that settles easy instances, and printing why
+ * 5. Recovering the chosen items from every engine; the DPs keep decision
+ *    bits, or split the budget Hirschberg style when the bits would not fit
+ *
+ * Weights, values and the capacity are 64-bit, so capacities in the
+ * billions and beyond are fine.
+ *
+ * Usage:
+ * gcc -O2 knapsack_large_capacity.c -o knapsack_large_capacity -lm
+ * ./knapsack_large_capacity           (solve the example)
+ * ./knapsack_large_capacity --bench   (compare the engines on generated instances)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#define MITM_MAX_ITEMS 40               // 2^20 subsets per half
+#define DP_MAX_STATES 50000000LL        // Largest capacity or total value a DP row may have
+#define DP_TRACE_MAX_BYTES (256LL << 20) // Decision bits kept for item recovery
+#define WORK_LIMIT 4e9                  // Estimated steps above which an engine is not picked
+#define BNB_MAX_NODES 10000000          // Node budget of branch-and-bound
+#define BNB_STEPS_PER_NODE 100          // Rough cost of one expansion, in estimate units
+
+typedef struct {
+    long long weight;
+    long long value;
+} Item;
+
+typedef struct {
+    const char *name;
+    int n;
+    long long capacity;
+    Item *items;
+} Instance;
+
+typedef struct {
+    long long value;
+    long long weight;
+    int *take;          // take[i] = 1 if item i is packed
+    int optimal;        // 0 if an engine stopped at a resource limit
+    long long work;     // Engine-specific effort: states, subsets or nodes
+    long long peak;     // Largest list, row or queue the engine held
+} Solution;
+
+/* ---------- Shared helpers ---------- */
+
+/* Sums the chosen items into s->value and s->weight */
+static void total_solution(const Instance *in, Solution *s) {
+    s->value = 0;
+    s->weight = 0;
+    for (int i = 0; i < in->n; i++) {
+        if (s->take[i]) {
+            s->value += in->items[i].value;
+            s->weight += in->items[i].weight;
+        }
+    }
+}
+
+static long long total_value(const Instance *in) {
+    long long sum = 0;
+    for (int i = 0; i < in->n; i++) sum += in->items[i].value;
+    return sum;
+}
+
+/* Items heavier than the capacity can never be packed and are skipped */
+static long long usable_weight_sum(const Instance *in) {
+    long long sum = 0;
+    for (int i = 0; i < in->n; i++)
+        if (in->items[i].weight <= in->capacity) sum += in->items[i].weight;
+    return sum;
+}
+
+/* ---------- Engine 1: meet in the middle ---------- */
+
+typedef struct {
+    long long weight;
+    long long value;
+    uint32_t mask;      // Which items of the half are in the subset
+} Subset;
+
+/*
+ * Builds the Pareto frontier of the subsets of items[0..count), sorted by
+ * weight with strictly increasing value. Adding an item maps a sorted
+ * frontier to a sorted list, so each step is one merge of the frontier with
+ * its shifted copy, dropping anything heavier than the capacity or not
+ * worth more than a lighter subset. Returns the frontier's length.
+ */
+static size_t pareto_subsets(const Item *items, int count, long long capacity, Subset *list,
+                             Subset *tmp, long long *enumerated) {
+    size_t len = 1;
+    list[0] = (Subset){ 0, 0, 0 };
+    for (int i = 0; i < count; i++) {
+        size_t a = 0, b = 0, out = 0;
+        long long w = items[i].weight, v = items[i].value;
+        while (a < len || b < len) {
+            // The frontier is sorted by weight: once a shifted entry is over
+            // the capacity, so are all the ones after it
+            if (b < len && list[b].weight + w > capacity) b = len;
+            if (a >= len && b >= len) break;
+            Subset next;
+            if (b < len && (a >= len || list[b].weight + w < list[a].weight ||
+                            (list[b].weight + w == list[a].weight && list[b].value + v > list[a].value))) {
+                next = (Subset){ list[b].weight + w, list[b].value + v, list[b].mask | (1u << i) };
+                b++;
+            } else {
+                next = list[a++];
+            }
+            if (out == 0 || next.value > tmp[out - 1].value) tmp[out++] = next;
+        }
+        *enumerated += (long long)len * 2;
+        memcpy(list, tmp, out * sizeof(Subset));
+        len = out;
+    }
+    return len;
+}
+
+static double cost_mitm(const Instance *in) {
+    if (in->n > MITM_MAX_ITEMS) return INFINITY;
+    return ldexp(1.0, (in->n + 1) / 2) * 4.0;
+}
+
+int solve_mitm(const Instance *in, Solution *s) {
+    if (in->n > MITM_MAX_ITEMS) return -1;
+    int half = in->n / 2, rest = in->n - half;
+    size_t cap = (size_t)1 << rest;
+    Subset *left = (Subset *)malloc(cap * sizeof(Subset));
+    Subset *right = (Subset *)malloc(cap * sizeof(Subset));
+    Subset *tmp = (Subset *)malloc(cap * sizeof(Subset));
+    if (!left || !right || !tmp) {
+        free(left);
+        free(right);
+        free(tmp);
+        return -1;
+    }
+
+    s->work = 0;
+    size_t nl = pareto_subsets(in->items, half, in->capacity, left, tmp, &s->work);
+    size_t nr = pareto_subsets(in->items + half, rest, in->capacity, right, tmp, &s->work);
+    s->peak = (long long)(nl > nr ? nl : nr);
+
+    // Lighter left subsets leave more room, so the best right partner only
+    // moves toward lighter entries as the sweep goes on.
+    long long best = -1;
+    size_t best_l = 0, best_r = 0, r = nr;
+    for (size_t l = 0; l < nl; l++) {
+        long long room = in->capacity - left[l].weight;
+        while (r > 0 && right[r - 1].weight > room) r--;
+        if (r == 0) break;
+        if (left[l].value + right[r - 1].value > best) {
+            best = left[l].value + right[r - 1].value;
+            best_l = l;
+            best_r = r - 1;
+        }
+    }
+
+    for (int i = 0; i < half; i++) s->take[i] = (left[best_l].mask >> i) & 1;
+    for (int i = 0; i < rest; i++) s->take[half + i] = (right[best_r].mask >> i) & 1;
+    total_solution(in, s);
+    s->optimal = 1;
+    free(left);
+    free(right);
+    free(tmp);
+    return 0;
+}
+
+/* ---------- Engines 2 and 3: capacity- and value-indexed DP ---------- */
+
+/*
+ * Decision bits: bit (i, x) records that item i improved state x. Walking
+ * the items backwards from the final state recovers the packed set.
+ */
+static unsigned char *trace_alloc(int n, long long states) {
+    long long bytes = ((long long)n * states + 7) / 8;
+    if (bytes > DP_TRACE_MAX_BYTES) return NULL;
+    return (unsigned char *)calloc((size_t)bytes, 1);
+}
+
+static inline void trace_set(unsigned char *t, long long states, int i, long long x) {
+    long long bit = (long long)i * states + x;
+    t[bit >> 3] |= (unsigned char)(1u << (bit & 7));
+}
+
+static inline int trace_get(const unsigned char *t, long long states, int i, long long x) {
+    long long bit = (long long)i * states + x;
+    return (t[bit >> 3] >> (bit & 7)) & 1;
+}
+
+/*
+ * Without room for the decision bits the items are recovered Hirschberg
+ * style, as knapsack_items() in knapsack_problem.c does: the best packing
+ * splits its budget (capacity, or value for the value DP) between the two
+ * halves of the items, and one row per half shows where. The budgets of a
+ * recursion level add up to the original, so recovery costs about one
+ * more pass over the items and a second row instead of n bits per state.
+ */
+
+/* best[c] for c = 0..W using items [lo, hi) */
+static void weight_row(const Instance *in, long long *best, long long W, int lo, int hi) {
+    memset(best, 0, ((size_t)W + 1) * sizeof(long long));
+    for (int i = lo; i < hi; i++) {
+        long long w = in->items[i].weight, v = in->items[i].value;
+        for (long long c = W; c >= w; c--)
+            if (best[c - w] + v > best[c]) best[c] = best[c - w] + v;
+    }
+}
+
+static void recover_by_weight(const Instance *in, long long W, int lo, int hi,
+                              long long *forward, long long *backward, int *take) {
+    if (hi - lo == 1) {
+        take[lo] = in->items[lo].weight <= W && in->items[lo].value > 0;
+        return;
+    }
+    if (W == 0) {
+        for (int i = lo; i < hi; i++) take[i] = in->items[i].weight == 0 && in->items[i].value > 0;
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    weight_row(in, forward, W, lo, mid);
+    weight_row(in, backward, W, mid, hi);
+    long long split = 0, best = -1;
+    for (long long c = 0; c <= W; c++) {
+        if (forward[c] + backward[W - c] > best) {
+            best = forward[c] + backward[W - c];
+            split = c;
+        }
+    }
+    recover_by_weight(in, split, lo, mid, forward, backward, take);
+    recover_by_weight(in, W - split, mid, hi, forward, backward, take);
+}
+
+#define UNREACHABLE (INT64_MAX / 2)
+
+/* lightest[v] for v = 0..V using items [lo, hi) that fit the capacity */
+static void value_row(const Instance *in, long long *lightest, long long V, int lo, int hi) {
+    lightest[0] = 0;
+    for (long long v = 1; v <= V; v++) lightest[v] = UNREACHABLE;
+    long long reached = 0;
+    for (int i = lo; i < hi; i++) {
+        long long w = in->items[i].weight, val = in->items[i].value;
+        if (w > in->capacity) continue;
+        long long top = reached + val < V ? reached + val : V;
+        for (long long v = top; v >= val; v--) {
+            long long candidate = lightest[v - val] + w;
+            if (candidate < lightest[v]) lightest[v] = candidate;
+        }
+        reached = top;
+    }
+}
+
+/* Marks a lightest subset of items [lo, hi) worth exactly `target` */
+static void recover_by_value(const Instance *in, long long target, int lo, int hi,
+                             long long *forward, long long *backward, int *take) {
+    if (target == 0) {
+        for (int i = lo; i < hi; i++) take[i] = 0;
+        return;
+    }
+    if (hi - lo == 1) {
+        take[lo] = 1;   // target > 0 is reachable, so it is this item's value
+        return;
+    }
+    int mid = lo + (hi - lo) / 2;
+    value_row(in, forward, target, lo, mid);
+    value_row(in, backward, target, mid, hi);
+    long long split = 0, lightest = UNREACHABLE;
+    for (long long v = 0; v <= target; v++) {
+        if (forward[v] + backward[target - v] < lightest) {
+            lightest = forward[v] + backward[target - v];
+            split = v;
+        }
+    }
+    recover_by_value(in, split, lo, mid, forward, backward, take);
+    recover_by_value(in, target - split, mid, hi, forward, backward, take);
+}
+
+static double cost_weight_dp(const Instance *in) {
+    long long states = in->capacity + 1;
+    if (states > DP_MAX_STATES) return INFINITY;
+    return (double)in->n * states;
+}
+
+/**
+ * @brief The knapsack_problem.c rolling row: best[c] is the most value
+ * within weight c, updated with capacity decreasing.
+ */
+int solve_weight_dp(const Instance *in, Solution *s) {
+    long long W = in->capacity;
+    if (W + 1 > DP_MAX_STATES) return -1;
+    long long *best = (long long *)calloc((size_t)W + 1, sizeof(long long));
+    if (!best) return -1;
+    unsigned char *trace = trace_alloc(in->n, W + 1);
+
+    for (int i = 0; i < in->n; i++) {
+        long long w = in->items[i].weight, v = in->items[i].value;
+        for (long long c = W; c >= w; c--) {
+            if (best[c - w] + v > best[c]) {
+                best[c] = best[c - w] + v;
+                if (trace) trace_set(trace, W + 1, i, c);
+            }
+        }
+    }
+
+    memset(s->take, 0, in->n * sizeof(int));
+    s->work = (long long)in->n * (W + 1);
+    s->peak = W + 1;
+    if (trace) {
+        long long c = W;
+        for (int i = in->n - 1; i >= 0; i--) {
+            if (trace_get(trace, W + 1, i, c)) {
+                s->take[i] = 1;
+                c -= in->items[i].weight;
+            }
+        }
+    } else if (in->n > 0) {
+        // Too many states to trace: recover with a second row
+        long long *backward = (long long *)malloc(((size_t)W + 1) * sizeof(long long));
+        if (!backward) {
+            free(best);
+            return -1;
+        }
+        recover_by_weight(in, W, 0, in->n, best, backward, s->take);
+        free(backward);
+        s->work *= 2;
+        s->peak *= 2;
+    }
+    total_solution(in, s);
+    s->optimal = 1;
+    free(best);
+    free(trace);
+    return 0;
+}
+
+static double cost_value_dp(const Instance *in) {
+    long long states = total_value(in) + 1;
+    if (states > DP_MAX_STATES) return INFINITY;
+    return (double)in->n * states;
+}
+
+/**
+ * @brief lightest[v] is the smallest weight of a subset worth exactly v;
+ * the answer is the largest v whose lightest subset fits.
+ */
+int solve_value_dp(const Instance *in, Solution *s) {
+    long long V = total_value(in);
+    if (V + 1 > DP_MAX_STATES) return -1;
+    long long *lightest = (long long *)malloc(((size_t)V + 1) * sizeof(long long));
+    if (!lightest) return -1;
+    unsigned char *trace = trace_alloc(in->n, V + 1);
+    lightest[0] = 0;
+    for (long long v = 1; v <= V; v++) lightest[v] = UNREACHABLE;
+
+    // Values above `reached` are still unreachable and are not visited
+    long long reached = 0;
+    for (int i = 0; i < in->n; i++) {
+        long long w = in->items[i].weight, val = in->items[i].value;
+        if (w > in->capacity) continue;
+        for (long long v = reached + val; v >= val; v--) {
+            long long candidate = lightest[v - val] + w;
+            if (candidate < lightest[v] && candidate <= in->capacity) {
+                lightest[v] = candidate;
+                if (trace) trace_set(trace, V + 1, i, v);
+            }
+        }
+        reached += val;
+    }
+
+    long long best = 0;
+    for (long long v = V; v > 0; v--) {
+        if (lightest[v] <= in->capacity) {
+            best = v;
+            break;
+        }
+    }
+
+    memset(s->take, 0, in->n * sizeof(int));
+    s->work = (long long)in->n * (V + 1);
+    s->peak = V + 1;
+    if (trace) {
+        long long v = best;
+        for (int i = in->n - 1; i >= 0; i--) {
+            if (trace_get(trace, V + 1, i, v)) {
+                s->take[i] = 1;
+                v -= in->items[i].value;
+            }
+        }
+    } else if (best > 0) {
+        // Too many states to trace: recover with a second row
+        long long *backward = (long long *)malloc(((size_t)best + 1) * sizeof(long long));
+        if (!backward) {
+            free(lightest);
+            return -1;
+        }
+        recover_by_value(in, best, 0, in->n, lightest, backward, s->take);
+        free(backward);
+        s->work *= 2;
+        s->peak += best + 1;
+    }
+    total_solution(in, s);
+    s->optimal = 1;
+    free(lightest);
+    free(trace);
+    return 0;
+}
+
+/* ---------- Engine 4: best-first branch-and-bound ---------- */
+
+typedef struct {
+    long long bound;    // Upper bound from the fractional relaxation, exact
+    long long value, weight;
+    int level;          // Next item (in density order) to decide
+    int node;           // Index of this node's record in the arena
+} OpenNode;
+
+typedef struct {
+    int parent;         // Record of the node it was branched from, or -1
+    int taken;          // Item (in density order) this branch packed, or -1
+} NodeRecord;
+
+typedef struct {
+    const Instance *in;
+    int *order;             // Item indices by decreasing value / weight
+    long long *prefix_w;    // prefix_w[k]: total weight of order[0..k)
+    long long *prefix_v;
+    int n;
+} BnbContext;
+
+/**
+ * @brief floor(a * b / c) for 0 <= a, b < c, without overflow.
+ *
+ * Below 2^50 the operands are exact doubles, so the estimated quotient is
+ * off by at most 2 and the remainder a*b - q*c, computed modulo 2^64, is
+ * small enough to be exact. Larger c takes b bit by bit, keeping quotient
+ * and remainder apart; both stay below c, so doubling fits in 64 bits.
+ */
+static long long mul_div_floor(long long a, long long b, long long c) {
+    if (a == 0 || b <= LLONG_MAX / a) return a * b / c;
+    if (c < (1LL << 50)) {
+        long long q = (long long)((double)a * (double)b / (double)c);
+        long long r = (long long)((unsigned long long)a * (unsigned long long)b
+                                  - (unsigned long long)q * (unsigned long long)c);
+        while (r < 0) {
+            r += c;
+            q--;
+        }
+        while (r >= c) {
+            r -= c;
+            q++;
+        }
+        return q;
+    }
+    unsigned long long q = 0, r = 0, uc = (unsigned long long)c;
+    int top = 62;
+    while (!((b >> top) & 1)) top--;   // b > 0 here, or the first test returned
+    for (int bit = top; bit >= 0; bit--) {
+        q <<= 1;
+        r <<= 1;
+        if (r >= uc) {
+            r -= uc;
+            q++;
+        }
+        if ((b >> bit) & 1) {
+            r += (unsigned long long)a;
+            if (r >= uc) {
+                r -= uc;
+                q++;
+            }
+        }
+    }
+    return (long long)q;
+}
+
+/*
+ * Dantzig bound: from `level`, pack whole items in density order while
+ * they fit, then a fraction of the first one that does not. The prefix
+ * sums make it a binary search instead of a scan. The fraction is rounded
+ * down in exact integer arithmetic: no packing is worth more than the
+ * relaxation, and values are whole numbers. A double would lose the low
+ * bits once values pass 2^53 and could cut off the optimum.
+ */
+static long long fractional_bound(const BnbContext *c, int level, long long value, long long weight) {
+    long long room = c->in->capacity - weight;
+    long long base = c->prefix_w[level];
+    int lo = level, hi = c->n;
+    while (lo < hi) {
+        int mid = lo + (hi - lo + 1) / 2;
+        if (c->prefix_w[mid] - base <= room)
+            lo = mid;
+        else
+            hi = mid - 1;
+    }
+    // At most the total value of the items, which the prefix sums hold
+    long long bound = value + c->prefix_v[lo] - c->prefix_v[level];
+    if (lo < c->n) {
+        const Item *next = &c->in->items[c->order[lo]];    // Did not fit, so its weight is > 0
+        long long left = room - (c->prefix_w[lo] - base);  // Less than next->weight
+        long long part = next->value / next->weight * left
+                       + mul_div_floor(left, next->value % next->weight, next->weight);
+        bound = part > LLONG_MAX - bound ? LLONG_MAX : bound + part;
+    }
+    return bound;
+}
+
+/**
+ * @brief Sign of a/b - c/d for a, c >= 0 and b, d > 0, exactly. When the
+ * cross products would overflow, compares the continued fractions: equal
+ * integer parts leave the remainders, and a/b < c/d, both below 1, holds
+ * exactly when d/c < b/a.
+ */
+static int compare_ratios(long long a, long long b, long long c, long long d) {
+    if ((a == 0 || d <= LLONG_MAX / a) && (c == 0 || b <= LLONG_MAX / c))
+        return (a * d > c * b) - (a * d < c * b);
+    for (;;) {
+        long long qa = a / b, qc = c / d;
+        if (qa != qc) return qa > qc ? 1 : -1;
+        a %= b;
+        c %= d;
+        if (a == 0 || c == 0) return (a != 0) - (c != 0);
+        long long t = a;
+        a = d;
+        d = t;
+        t = b;
+        b = c;
+        c = t;
+    }
+}
+
+static BnbContext *density_context;
+
+/*
+ * Decreasing value / weight, compared exactly. Zero weights come first and
+ * ties go by index, so qsort sees a strict weak order; the bound is only
+ * valid if the order is right.
+ */
+static int by_density(const void *a, const void *b) {
+    int i = *(const int *)a, j = *(const int *)b;
+    const Item *x = &density_context->in->items[i];
+    const Item *y = &density_context->in->items[j];
+    if ((x->weight == 0) != (y->weight == 0)) return x->weight == 0 ? -1 : 1;
+    if (x->weight != 0) {
+        // Each density double is within 3 * 2^-53 of the true ratio, so a
+        // wider gap settles the order and only near ties need the exact test
+        double dx = (double)x->value / x->weight, dy = (double)y->value / y->weight;
+        if (dx > dy * (1 + 1e-14)) return -1;
+        if (dy > dx * (1 + 1e-14)) return 1;
+        int cmp = compare_ratios(x->value, x->weight, y->value, y->weight);
+        if (cmp != 0) return -cmp;
+    }
+    return (i > j) - (i < j);
+}
+
+static void heap_push(OpenNode *heap, size_t *size, OpenNode node) {
+    size_t i = (*size)++;
+    while (i > 0 && heap[(i - 1) / 2].bound < node.bound) {
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    heap[i] = node;
+}
+
+static OpenNode heap_pop(OpenNode *heap, size_t *size) {
+    OpenNode top = heap[0], last = heap[--(*size)];
+    size_t i = 0;
+    for (;;) {
+        size_t child = 2 * i + 1;
+        if (child >= *size) break;
+        if (child + 1 < *size && heap[child + 1].bound > heap[child].bound) child++;
+        if (heap[child].bound <= last.bound) break;
+        heap[i] = heap[child];
+        i = child;
+    }
+    if (*size > 0) heap[i] = last;
+    return top;
+}
+
+static double cost_bnb(const Instance *in) {
+    // Unknowable in advance; O(n log n) is the best case
+    return in->n * log2(in->n + 2.0);
+}
+
+/**
+ * @brief Best-first search: always expand the open node with the highest
+ * bound. The first popped node whose bound does not beat the incumbent
+ * proves the incumbent optimal. Stops after max_nodes nodes and returns
+ * the best solution found so far, marked as not proven optimal.
+ */
+int bnb_search(const Instance *in, Solution *s, long long max_nodes) {
+    int n = in->n;
+    BnbContext c = { in, NULL, NULL, NULL, 0 };
+    c.order = (int *)malloc(n * sizeof(int));
+    c.prefix_w = (long long *)malloc((n + 1) * sizeof(long long));
+    c.prefix_v = (long long *)malloc((n + 1) * sizeof(long long));
+    size_t heap_cap = 1 << 16, arena_cap = 1 << 16;
+    OpenNode *heap = (OpenNode *)malloc(heap_cap * sizeof(OpenNode));
+    NodeRecord *arena = (NodeRecord *)malloc(arena_cap * sizeof(NodeRecord));
+    int ok = c.order && c.prefix_w && c.prefix_v && heap && arena;
+
+    if (ok) {
+        // Items that never fit or are worth nothing cannot improve a packing
+        for (int i = 0; i < n; i++)
+            if (in->items[i].weight <= in->capacity && in->items[i].value > 0) c.order[c.n++] = i;
+        density_context = &c;
+        qsort(c.order, c.n, sizeof(int), by_density);
+        c.prefix_w[0] = c.prefix_v[0] = 0;
+        for (int k = 0; k < c.n; k++) {
+            c.prefix_w[k + 1] = c.prefix_w[k] + in->items[c.order[k]].weight;
+            c.prefix_v[k + 1] = c.prefix_v[k] + in->items[c.order[k]].value;
+        }
+
+        // Incumbent: greedy by density, skipping items that do not fit
+        memset(s->take, 0, n * sizeof(int));
+        long long room = in->capacity;
+        for (int k = 0; k < c.n; k++) {
+            if (in->items[c.order[k]].weight <= room) {
+                s->take[c.order[k]] = 1;
+                room -= in->items[c.order[k]].weight;
+            }
+        }
+        total_solution(in, s);
+    }
+
+    long long best = s->value;
+    int best_node = -1;
+    size_t heap_size = 0, arena_size = 0;
+    long long expanded = 0, peak = 0;
+    s->optimal = 1;
+
+    if (ok) {
+        arena[arena_size++] = (NodeRecord){ -1, -1 };
+        heap_push(heap, &heap_size, (OpenNode){ fractional_bound(&c, 0, 0, 0), 0, 0, 0, 0 });
+    }
+    while (ok && heap_size > 0) {
+        OpenNode node = heap_pop(heap, &heap_size);
+        if (node.bound <= best) break;  // Nothing left can improve
+        if ((long long)arena_size + 2 > max_nodes) {
+            s->optimal = 0;
+            break;
+        }
+        expanded++;
+
+        // Children: pack or skip item order[level]. Grow the arrays first
+        if (heap_size + 2 > heap_cap || arena_size + 2 > arena_cap) {
+            size_t new_heap = heap_size + 2 > heap_cap ? heap_cap * 2 : heap_cap;
+            size_t new_arena = arena_size + 2 > arena_cap ? arena_cap * 2 : arena_cap;
+            OpenNode *h = (OpenNode *)realloc(heap, new_heap * sizeof(OpenNode));
+            if (h) heap = h;
+            NodeRecord *a = h ? (NodeRecord *)realloc(arena, new_arena * sizeof(NodeRecord)) : NULL;
+            if (a) arena = a;
+            if (!h || !a) {
+                s->optimal = 0;
+                break;
+            }
+            heap_cap = new_heap;
+            arena_cap = new_arena;
+        }
+
+        const Item *item = &in->items[c.order[node.level]];
+        int level = node.level + 1;
+        if (node.weight + item->weight <= in->capacity) {
+            long long value = node.value + item->value, weight = node.weight + item->weight;
+            int id = (int)arena_size;
+            arena[arena_size++] = (NodeRecord){ node.node, node.level };
+            if (value > best) {
+                best = value;
+                best_node = id;
+            }
+            long long bound = fractional_bound(&c, level, value, weight);
+            if (level < c.n && bound > best)
+                heap_push(heap, &heap_size, (OpenNode){ bound, value, weight, level, id });
+        }
+        long long bound = fractional_bound(&c, level, node.value, node.weight);
+        if (level < c.n && bound > best) {
+            int id = (int)arena_size;
+            arena[arena_size++] = (NodeRecord){ node.node, -1 };
+            heap_push(heap, &heap_size, (OpenNode){ bound, node.value, node.weight, level, id });
+        }
+        if ((long long)heap_size > peak) peak = (long long)heap_size;
+    }
+
+    if (ok && best_node >= 0) {
+        // Walk the parent records back to the root for the packed items
+        memset(s->take, 0, n * sizeof(int));
+        for (int id = best_node; id >= 0; id = arena[id].parent)
+            if (arena[id].taken >= 0) s->take[c.order[arena[id].taken]] = 1;
+        total_solution(in, s);
+    }
+    s->work = expanded;
+    s->peak = peak;
+
+    free(c.order);
+    free(c.prefix_w);
+    free(c.prefix_v);
+    free(heap);
+    free(arena);
+    return ok ? 0 : -1;
+}
+
+int solve_bnb(const Instance *in, Solution *s) {
+    return bnb_search(in, s, BNB_MAX_NODES);
+}
+
+/* ---------- Engine selection ---------- */
+
+typedef struct {
+    const char *name;
+    const char *work_name;
+    double (*cost)(const Instance *);
+    int (*solve)(const Instance *, Solution *);
+} Engine;
+
+static const Engine engines[] = {
+    { "meet-in-middle", "subsets", cost_mitm, solve_mitm },
+    { "weight DP", "cells", cost_weight_dp, solve_weight_dp },
+    { "value DP", "cells", cost_value_dp, solve_value_dp },
+    { "branch&bound", "nodes", cost_bnb, solve_bnb },
+};
+
+#define ENGINE_COUNT ((int)(sizeof(engines) / sizeof(engines[0])))
+#define ENGINE_BNB (ENGINE_COUNT - 1)
+
+/**
+ * @brief Chooses the engine with the lowest estimated work among those
+ * that are exact and bounded; branch-and-bound, whose work cannot be
+ * predicted, is used when none of them fits under WORK_LIMIT.
+ */
+int pick_engine(const Instance *in, double estimates[]) {
+    int pick = ENGINE_BNB;
+    double best = WORK_LIMIT;
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        estimates[e] = engines[e].cost(in);
+        if (e != ENGINE_BNB && estimates[e] <= best) {
+            best = estimates[e];
+            pick = e;
+        }
+    }
+    return pick;
+}
+
+/**
+ * @brief Solves with the automatically chosen engine.
+ * @return The index of the engine that produced the answer, or -1 if it
+ * ran out of memory.
+ *
+ * On easy instances branch-and-bound proves optimality after a handful of
+ * nodes, far sooner than a DP fills its row, so when a bounded engine is
+ * picked a branch-and-bound probe first gets a tenth of its budget.
+ */
+int knapsack_solve(const Instance *in, Solution *s) {
+    double estimates[ENGINE_COUNT];
+    int e = pick_engine(in, estimates);
+    if (e != ENGINE_BNB) {
+        long long budget = (long long)(estimates[e] / 10 / BNB_STEPS_PER_NODE);
+        if (budget > 0 && bnb_search(in, s, budget) == 0 && s->optimal) return ENGINE_BNB;
+    }
+    return engines[e].solve(in, s) == 0 ? e : -1;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+typedef enum { GEN_UNCORRELATED, GEN_SMALL_VALUES, GEN_CORRELATED, GEN_NEAR_TIES } Generator;
+
+/**
+ * @brief Random instance with weights in [1, max_weight] and capacity half
+ * the total weight.
+ *   uncorrelated: values in [1, max_value]
+ *   small values: values in [1, max_value], meant for a small max_value
+ *   correlated:   value = weight + max_weight / 10 (hard for bounds)
+ *   near ties:    values in [2^58, 2^58 + max_value), densities a double
+ *                 cannot tell apart
+ */
+Instance make_instance(const char *name, int n, long long max_weight, long long max_value,
+                       Generator gen, uint64_t seed) {
+    Instance in = { name, n, 0, (Item *)malloc(n * sizeof(Item)) };
+    if (!in.items) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    uint64_t r = seed;
+    long long total = 0;
+    for (int i = 0; i < n; i++) {
+        in.items[i].weight = 1 + (long long)(next_random(&r) % (uint64_t)max_weight);
+        if (gen == GEN_CORRELATED)
+            in.items[i].value = in.items[i].weight + max_weight / 10;
+        else if (gen == GEN_NEAR_TIES)
+            in.items[i].value = (1LL << 58) + (long long)(next_random(&r) % (uint64_t)max_value);
+        else
+            in.items[i].value = 1 + (long long)(next_random(&r) % (uint64_t)max_value);
+        total += in.items[i].weight;
+    }
+    in.capacity = total / 2;
+    return in;
+}
+
+/**
+ * @brief Instance with the given items, copied so it is freed like the others.
+ */
+Instance fixed_instance(const char *name, const Item *items, int n, long long capacity) {
+    Instance in = { name, n, capacity, (Item *)malloc(n * sizeof(Item)) };
+    if (!in.items) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    memcpy(in.items, items, n * sizeof(Item));
+    return in;
+}
+
+/**
+ * @brief Prints the pick and its reasoning, then runs every engine whose
+ * estimate is within reach and checks that the exact ones agree.
+ */
+int bench_instance(const Instance *in) {
+    double estimates[ENGINE_COUNT];
+    int pick = pick_engine(in, estimates);
+
+    printf("\n%s: n = %d, capacity = %lld, total value = %lld, usable weight = %lld\n", in->name,
+           in->n, in->capacity, total_value(in), usable_weight_sum(in));
+    printf("  %-16s %12s %10s %14s %16s %12s %s\n", "engine", "estimate", "time ms", "value",
+           "work", "peak", "");
+
+    int *take = (int *)malloc(in->n * sizeof(int));
+    if (!take) return -1;
+    long long reference = -1;
+    int mismatches = 0;
+    for (int e = 0; e < ENGINE_COUNT; e++) {
+        char estimate[32];
+        if (isinf(estimates[e]))
+            snprintf(estimate, sizeof(estimate), "n/a");
+        else
+            snprintf(estimate, sizeof(estimate), "%.3g", estimates[e]);
+        if (isinf(estimates[e]) || (e != ENGINE_BNB && estimates[e] > WORK_LIMIT)) {
+            printf("  %-16s %12s %10s\n", engines[e].name, estimate, "skipped");
+            continue;
+        }
+
+        Solution s = { 0, 0, take, 0, 0, 0 };
+        double t0 = now_seconds();
+        int failed = engines[e].solve(in, &s);
+        double t = now_seconds() - t0;
+        if (failed) {
+            printf("  %-16s %12s %10s\n", engines[e].name, estimate, "no memory");
+            continue;
+        }
+
+        // Exact engines must agree; a stopped branch-and-bound may be lower
+        const char *note = e == pick ? "<- lowest estimate" : "";
+        if (s.weight > in->capacity) {
+            note = "OVERWEIGHT";
+            mismatches++;
+        } else if (s.optimal) {
+            if (reference < 0) reference = s.value;
+            if (s.value != reference) {
+                note = "MISMATCH";
+                mismatches++;
+            }
+        } else {
+            note = "node limit hit";
+        }
+        char work[48];
+        snprintf(work, sizeof(work), "%lld %s", s.work, engines[e].work_name);
+        printf("  %-16s %12s %10.1f %14lld %16s %12lld %s\n", engines[e].name, estimate, t * 1e3,
+               s.value, work, s.peak, note);
+    }
+
+    Solution s = { 0, 0, take, 0, 0, 0 };
+    double t0 = now_seconds();
+    int chosen = knapsack_solve(in, &s);
+    double t = now_seconds() - t0;
+    if (chosen < 0) {
+        printf("  auto: out of memory\n");
+    } else {
+        int wrong = s.optimal && reference >= 0 && s.value != reference;
+        mismatches += wrong;
+        printf("  auto: %s in %.1f ms, value %lld%s%s\n", engines[chosen].name, t * 1e3, s.value,
+               chosen == ENGINE_BNB && pick != ENGINE_BNB ? " (probe proved optimality)" : "",
+               wrong ? "  MISMATCH" : "");
+    }
+    free(take);
+    return mismatches;
+}
+
+int run_benchmark(void) {
+    printf("Estimates are in elementary steps; engines above %.0e are not run.\n", WORK_LIMIT);
+    printf("Peak is the largest frontier, DP row or open-node queue.\n");
+
+    // Items worth nothing or weighing nothing must not upset the density order
+    static const Item zeros[] = {
+        { 2, 20 }, { 4, 0 }, { 1, 17 }, { 5, 6 }, { 0, 3 }, { 4, 2 },
+        { 3, 3 }, { 0, 0 }, { 4, 17 }, { 4, 17 }, { 2, 15 }, { 2, 5 },
+    };
+    Instance instances[] = {
+        make_instance("small capacity", 1000, 1000, 1000000, GEN_UNCORRELATED, 1),
+        make_instance("huge capacity, small values", 1000, 1000000000000LL, 100, GEN_SMALL_VALUES, 2),
+        make_instance("40 items, huge capacity", 40, 1000000000000LL, 1000000000000LL,
+                      GEN_UNCORRELATED, 3),
+        make_instance("36 correlated items", 36, 1000000000LL, 0, GEN_CORRELATED, 4),
+        make_instance("100000 items, huge capacity", 100000, 1000000000000LL, 1000000000000LL,
+                      GEN_UNCORRELATED, 5),
+        fixed_instance("zero weights and values", zeros, 12, 22),
+        make_instance("values near 2^58", 16, 1000, 1000, GEN_NEAR_TIES, 6),
+    };
+    int count = sizeof(instances) / sizeof(instances[0]);
+
+    int failures = 0;
+    for (int i = 0; i < count; i++) {
+        int result = bench_instance(&instances[i]);
+        if (result < 0) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            return 1;
+        }
+        failures += result;
+        free(instances[i].items);
+    }
+
+    if (failures) {
+        fprintf(stderr, "\nError: some engines disagreed.\n");
+        return 1;
+    }
+    printf("\nAll exact engines agree.\n");
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) return run_benchmark();
+
+    int val[] = {60, 100, 120};
+    int wt[] = {10, 20, 30};
+    Item demo_items[3];
+    for (int i = 0; i < 3; i++) demo_items[i] = (Item){ wt[i], val[i] };
+    Instance demo = { "example", 3, 50, demo_items };
+    int take[3];
+    Solution s = { 0, 0, take, 0, 0, 0 };
+    int e = knapsack_solve(&demo, &s);
+    printf("Example (capacity 50): value %lld using %s, items", s.value, engines[e].name);
+    for (int i = 0; i < 3; i++)
+        if (take[i]) printf(" %d", i);
+    printf("\n");
+    return 0;
+}
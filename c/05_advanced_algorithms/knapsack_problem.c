@@ -4,20 +4,58 @@
  *
  * This program demonstrates:
  * 1. Dynamic Programming approach
- * 2. 2D Array for memoization
- * 3. Optimization problem solving
+ * 2. A single rolling row instead of the full (n + 1) x (W + 1) table:
+ *    iterating capacity downward means row[c - w] still holds the previous
+ *    item's value when row[c] is updated, so O(W) memory suffices
+ * 3. Hirschberg-style divide and conquer to recover the chosen items in
+ *    O(W) memory: solve each half of the items forward, find the best split
+ *    of the capacity, and recurse on both halves
+ * 4. An AVX2 inner max loop (8 capacities per instruction) chosen at
+ *    runtime, with a scalar fallback
+ * 5. A multi-threaded row sweep: threads own slices of the capacity range,
+ *    read the previous row and write the next, and meet at a barrier
+ *    after every item
+ * 6. Optimization problem solving
+ *
+ * Item values must be non-negative and their total must fit in an int.
+ *
+ * Usage:
+ * gcc -O2 -pthread knapsack_problem.c -o knapsack_problem
+ * ./knapsack_problem                         (solve the example instance)
+ * ./knapsack_problem --bench [W] [n] [threads]
+ *                                            (random instances with capacity
+ *                                             up to W, default 10^6 and 1000 items)
  */
 
+#define _POSIX_C_SOURCE 200112L
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+#define MAX_THREADS 64
+#define LEGACY_MAX_CELLS (1 << 20)  // The original table lives on the stack: 4 MB at most
 
 int max(int a, int b) {
     return (a > b) ? a : b;
 }
 
 /**
- * @brief Returns the maximum value that can be put in a knapsack of capacity W.
+ * @brief The original solver, kept for comparison. Its table is a VLA on
+ * the stack, so it overflows the stack once (n + 1) * (W + 1) ints exceed
+ * the stack limit (8 MB by default on Linux).
  */
-int knapSack(int W, int wt[], int val[], int n) {
+int legacy_knapSack(int W, int wt[], int val[], int n) {
     int i, w;
     int K[n + 1][W + 1];
 
@@ -36,12 +74,383 @@ int knapSack(int W, int wt[], int val[], int n) {
     return K[n][W];
 }
 
-int main() {
+/* ---------- Row updates ---------- */
+
+/*
+ * In place, capacity downward: row[c] = max(row[c], row[c - w] + v) for
+ * c = W .. w. Every read is at or below the current capacity and nothing
+ * there has been written yet for this item.
+ */
+static void row_update_scalar(int *row, int W, int w, int v) {
+    for (int c = W; c >= w; c--) {
+        int take = row[c - w] + v;
+        if (take > row[c]) row[c] = take;
+    }
+}
+
+/*
+ * Out of place for capacities [from, to): next[c] = max(prev[c], prev[c - w] + v).
+ * Used by the threaded sweep, where another thread may be rewriting
+ * prev[c - w]'s slice of the row in place.
+ */
+static void row_step_scalar(const int *prev, int *next, int from, int to, int w, int v) {
+    int c = from;
+    for (; c < to && c < w; c++) next[c] = prev[c];
+    for (; c < to; c++) next[c] = max(prev[c], prev[c - w] + v);
+}
+
+#if HAVE_X86_KERNELS
+/*
+ * The vector version loads row[c - 7 .. c] and row[c - w - 7 .. c - w]
+ * before storing, so it stays correct even when w < 8 and the two
+ * windows overlap.
+ */
+__attribute__((target("avx2")))
+static void row_update_avx2(int *row, int W, int w, int v) {
+    __m256i add = _mm256_set1_epi32(v);
+    int c = W;
+    for (; c - 7 >= w; c -= 8) {
+        __m256i keep = _mm256_loadu_si256((const __m256i *)(row + c - 7));
+        __m256i take = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(row + c - 7 - w)), add);
+        _mm256_storeu_si256((__m256i *)(row + c - 7), _mm256_max_epi32(keep, take));
+    }
+    for (; c >= w; c--) row[c] = max(row[c], row[c - w] + v);
+}
+
+__attribute__((target("avx2")))
+static void row_step_avx2(const int *prev, int *next, int from, int to, int w, int v) {
+    int c = from;
+    for (; c < to && c < w; c++) next[c] = prev[c];
+    __m256i add = _mm256_set1_epi32(v);
+    for (; c + 8 <= to; c += 8) {
+        __m256i keep = _mm256_loadu_si256((const __m256i *)(prev + c));
+        __m256i take = _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)(prev + c - w)), add);
+        _mm256_storeu_si256((__m256i *)(next + c), _mm256_max_epi32(keep, take));
+    }
+    for (; c < to; c++) next[c] = max(prev[c], prev[c - w] + v);
+}
+#endif
+
+static void (*row_update)(int *, int, int, int) = row_update_scalar;
+static void (*row_step)(const int *, int *, int, int, int, int) = row_step_scalar;
+
+/**
+ * @brief Selects the AVX2 row kernels when the CPU supports them.
+ * @return Name of the selected kernels.
+ */
+const char *knapsack_init(void) {
+#if HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        row_update = row_update_avx2;
+        row_step = row_step_avx2;
+        return "avx2";
+    }
+#endif
+    row_update = row_update_scalar;
+    row_step = row_step_scalar;
+    return "scalar";
+}
+
+/* Best value for every capacity 0..W using items [lo, hi) */
+static void fill_row(int *row, int W, const int wt[], const int val[], int lo, int hi) {
+    memset(row, 0, ((size_t)W + 1) * sizeof(int));
+    for (int i = lo; i < hi; i++)
+        if (wt[i] <= W) row_update(row, W, wt[i], val[i]);
+}
+
+/* ---------- Solvers ---------- */
+
+/**
+ * @brief Returns the maximum value that can be put in a knapsack of capacity W.
+ *
+ * Uses one rolling row of W + 1 ints on the heap. Returns -1 if that row
+ * cannot be allocated.
+ */
+int knapSack(int W, int wt[], int val[], int n) {
+    if (W < 0) return 0;
+    int *row = (int *)malloc(((size_t)W + 1) * sizeof(int));
+    if (row == NULL) return -1;
+    fill_row(row, W, wt, val, 0, n);
+    int best = row[W];
+    free(row);
+    return best;
+}
+
+/* Hirschberg recursion over items [lo, hi) with capacity W */
+static void recover_items(int W, const int wt[], const int val[], int lo, int hi,
+                          int *forward, int *backward, int take[]) {
+    if (hi - lo == 1) {
+        take[lo] = wt[lo] <= W && val[lo] > 0;
+        return;
+    }
+    if (W == 0) {
+        for (int i = lo; i < hi; i++) take[i] = wt[i] == 0 && val[i] > 0;
+        return;
+    }
+
+    // The best solution gives some capacity c to the first half and the
+    // rest to the second; both rows together reveal which c that is.
+    int mid = lo + (hi - lo) / 2;
+    fill_row(forward, W, wt, val, lo, mid);
+    fill_row(backward, W, wt, val, mid, hi);
+    int split = 0, best = -1;
+    for (int c = 0; c <= W; c++) {
+        int total = forward[c] + backward[W - c];
+        if (total > best) {
+            best = total;
+            split = c;
+        }
+    }
+
+    recover_items(split, wt, val, lo, mid, forward, backward, take);
+    recover_items(W - split, wt, val, mid, hi, forward, backward, take);
+}
+
+/**
+ * @brief Solves the instance and marks the chosen items in take[] (1 = in
+ * the knapsack), using O(W) memory.
+ * @return The maximum value, or -1 if memory allocation failed.
+ *
+ * Each level of the recursion costs at most one pass over the items with
+ * the full capacity, and the capacities of a level's subproblems add up to
+ * W, so the total work is at most about twice that of knapSack().
+ */
+int knapsack_items(int W, const int wt[], const int val[], int n, int take[]) {
+    if (n <= 0 || W < 0) return 0;
+    int *forward = (int *)malloc(((size_t)W + 1) * sizeof(int));
+    int *backward = (int *)malloc(((size_t)W + 1) * sizeof(int));
+    if (forward == NULL || backward == NULL) {
+        free(forward);
+        free(backward);
+        return -1;
+    }
+    recover_items(W, wt, val, 0, n, forward, backward, take);
+    free(forward);
+    free(backward);
+
+    int best = 0;
+    for (int i = 0; i < n; i++)
+        if (take[i]) best += val[i];
+    return best;
+}
+
+/* ---------- Threaded row sweep ---------- */
+
+typedef struct {
+    const int *wt, *val;
+    int n, W;
+    int *rows[2];               // Previous and next row, swapped every item
+    int threads;
+    pthread_barrier_t barrier;
+} SweepShared;
+
+typedef struct {
+    SweepShared *shared;
+    int from, to;               // Capacity slice [from, to)
+} SweepTask;
+
+void *sweep_worker(void *p) {
+    SweepTask *task = (SweepTask *)p;
+    SweepShared *s = task->shared;
+    for (int i = 0; i < s->n; i++) {
+        const int *prev = s->rows[i & 1];
+        int *next = s->rows[(i + 1) & 1];
+        int w = s->wt[i] <= s->W ? s->wt[i] : s->W + 1;
+        row_step(prev, next, task->from, task->to, w, s->val[i]);
+        // Nobody may start item i + 1 until every slice of item i is written
+        pthread_barrier_wait(&s->barrier);
+    }
+    return NULL;
+}
+
+/**
+ * @brief knapSack() with the capacity range split across `threads` threads.
+ * @return The maximum value, or -1 if memory or threads are unavailable.
+ */
+int knapsack_parallel(int W, const int wt[], const int val[], int n, int threads) {
+    if (W < 0) return 0;
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (threads > W + 1) threads = W + 1;
+
+    SweepShared s;
+    s.wt = wt;
+    s.val = val;
+    s.n = n;
+    s.W = W;
+    s.threads = threads;
+    s.rows[0] = (int *)calloc((size_t)W + 1, sizeof(int));
+    s.rows[1] = (int *)malloc(((size_t)W + 1) * sizeof(int));
+    if (s.rows[0] == NULL || s.rows[1] == NULL || pthread_barrier_init(&s.barrier, NULL, threads) != 0) {
+        free(s.rows[0]);
+        free(s.rows[1]);
+        return -1;
+    }
+
+    // Slices are multiples of 16 ints so neighbouring threads never write
+    // the same cache line
+    SweepTask tasks[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    long long slice = ((long long)W + 1 + threads - 1) / threads;
+    slice = (slice + 15) / 16 * 16;
+    for (int t = 0; t < threads; t++) {
+        long long from = t * slice, to = from + slice;
+        tasks[t].shared = &s;
+        tasks[t].from = (int)(from < W + 1 ? from : W + 1);
+        tasks[t].to = (int)(to < W + 1 ? to : W + 1);
+    }
+
+    for (int t = 1; t < threads; t++) {
+        if (pthread_create(&tid[t], NULL, sweep_worker, &tasks[t]) != 0) {
+            // Threads already started would wait at the barrier forever
+            fprintf(stderr, "Error: could not start %d threads.\n", threads);
+            exit(1);
+        }
+    }
+    sweep_worker(&tasks[0]);
+    for (int t = 1; t < threads; t++) pthread_join(tid[t], NULL);
+
+    int best = s.rows[n & 1][W];
+    pthread_barrier_destroy(&s.barrier);
+    free(s.rows[0]);
+    free(s.rows[1]);
+    return best;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/**
+ * @brief Solves one random instance with every solver.
+ * @return The number of solvers that disagreed, or -1 if memory ran out.
+ */
+int bench_instance(int W, int n, int threads) {
+    int *wt = (int *)malloc(n * sizeof(int));
+    int *val = (int *)malloc(n * sizeof(int));
+    int *take = (int *)malloc(n * sizeof(int));
+    if (wt == NULL || val == NULL || take == NULL) {
+        free(wt);
+        free(val);
+        free(take);
+        return -1;
+    }
+    // Weights up to W / 10, so the best packing holds a few dozen items
+    uint64_t r = 88172645463325252ull + W;
+    int max_weight = W / 10 > 1 ? W / 10 : 1;
+    for (int i = 0; i < n; i++) {
+        wt[i] = 1 + (int)(next_random(&r) % max_weight);
+        val[i] = 1 + (int)(next_random(&r) % 1000);
+    }
+
+    double t_legacy = -1, t0;
+    int legacy = -1;
+    if ((double)(n + 1) * (W + 1) <= LEGACY_MAX_CELLS) {
+        t0 = now_seconds();
+        legacy = legacy_knapSack(W, wt, val, n);
+        t_legacy = now_seconds() - t0;
+    }
+
+    row_update = row_update_scalar;
+    t0 = now_seconds();
+    int scalar = knapSack(W, wt, val, n);
+    double t_scalar = now_seconds() - t0;
+
+    knapsack_init();
+    t0 = now_seconds();
+    int simd = knapSack(W, wt, val, n);
+    double t_simd = now_seconds() - t0;
+
+    t0 = now_seconds();
+    int parallel = knapsack_parallel(W, wt, val, n, threads);
+    double t_parallel = now_seconds() - t0;
+
+    t0 = now_seconds();
+    int items = knapsack_items(W, wt, val, n, take);
+    double t_items = now_seconds() - t0;
+
+    if (scalar < 0 || simd < 0 || parallel < 0 || items < 0) {
+        free(wt);
+        free(val);
+        free(take);
+        return -1;
+    }
+
+    long long weight = 0;
+    for (int i = 0; i < n; i++)
+        if (take[i]) weight += wt[i];
+    int mismatches = (legacy >= 0 && legacy != scalar) + (simd != scalar) + (parallel != scalar) +
+                     (items != scalar || weight > W);
+
+    char legacy_text[32];
+    if (legacy >= 0)
+        snprintf(legacy_text, sizeof(legacy_text), "%.1f", t_legacy * 1e3);
+    else
+        snprintf(legacy_text, sizeof(legacy_text), "too big");
+    double cells = (double)n * (W + 1);
+    printf("%10d %6d %10d %10s %10.1f %10.1f %10.1f %10.1f %8.2f%s\n", W, n, scalar, legacy_text,
+           t_scalar * 1e3, t_simd * 1e3, t_parallel * 1e3, t_items * 1e3, cells / t_simd / 1e9,
+           mismatches ? "  MISMATCH" : "");
+
+    free(wt);
+    free(val);
+    free(take);
+    return mismatches;
+}
+
+int run_benchmark(int max_W, int n, int threads) {
+    printf("Row kernels: %s, threads: %d\n", knapsack_init(), threads);
+    printf("Times in ms; the original table solver only runs while it fits on the stack.\n\n");
+    printf("%10s %6s %10s %10s %10s %10s %10s %10s %8s\n", "W", "items", "best", "original",
+           "row", "row simd", "threaded", "items", "Gcell/s");
+
+    int failures = 0;
+    for (long long W = 1000; W <= max_W; W *= 10) {
+        int result = bench_instance((int)W, n, threads);
+        if (result < 0) {
+            printf("\nW = %lld: not enough memory, stopping.\n", W);
+            break;
+        }
+        failures += result;
+    }
+    if (failures) {
+        fprintf(stderr, "Error: some solvers disagreed.\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        long W = argc > 2 ? atol(argv[2]) : 1000000;
+        long n = argc > 3 ? atol(argv[3]) : 1000;
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        long threads = argc > 4 ? atol(argv[4]) : (cpus > 0 ? cpus : 1);
+        if (W < 1000 || W > 1000000000 || n <= 0 || n > 1000000 || threads <= 0) {
+            fprintf(stderr, "Error: need 1000 <= W <= 10^9, 1 <= n <= 10^6 and threads >= 1.\n");
+            return 1;
+        }
+        return run_benchmark((int)W, (int)n, (int)threads);
+    }
+
+    knapsack_init();
     int val[] = {60, 100, 120};
     int wt[] = {10, 20, 30};
     int W = 50;
     int n = sizeof(val) / sizeof(val[0]);
-    
+
     printf("Value array: ");
     for(int i=0; i<n; i++) printf("%d ", val[i]);
     printf("\nWeight array: ");
@@ -49,5 +458,12 @@ int main() {
     printf("\nKnapsack Capacity: %d\n", W);
 
     printf("\nMaximum value that can be obtained is %d\n", knapSack(W, wt, val, n));
+
+    int take[3];
+    knapsack_items(W, wt, val, n, take);
+    printf("Items chosen (by index):");
+    for (int i = 0; i < n; i++)
+        if (take[i]) printf(" %d", i);
+    printf("\n");
     return 0;
 }
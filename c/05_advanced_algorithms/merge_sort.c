@@ -6,10 +6,462 @@
  * 1. Divide and Conquer strategy
  * 2. Recursive sorting
  * 3. Merging sorted subarrays
+ * 4. Bottom-up merging with a single scratch buffer: each pass merges from
+ *    one buffer into the other ("ping-pong"), so nothing is allocated per merge
+ * 5. TimSort-style adaptivity: natural runs (ascending, or strictly
+ *    descending and reversed) are detected, short runs are extended with
+ *    insertion sort, and merges switch to galloping (exponential search)
+ *    when one side keeps winning
+ * 6. Parallel sorting with pthreads: halves are sorted as separate tasks and
+ *    merged in parallel, splitting the output by binary search (co-ranking)
+ * 7. Short runs sorted by an AVX2 bitonic sorting network instead of
+ *    insertion sort when the CPU supports it
+ *
+ * Usage:
+ * gcc -O2 -pthread merge_sort.c -o merge_sort
+ * ./merge_sort                          (sort the example array)
+ * ./merge_sort --bench [n] [threads]    (compare with the original version and qsort)
  */
 
+#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+#include <unistd.h>
+#include <pthread.h>
+
+#define MIN_RUN 32              // Runs shorter than this are extended to it and sorted
+#define GALLOP_TRIGGER 7        // Consecutive wins by one side before galloping
+#define PARALLEL_MIN_SIZE 65536 // Below this a task sorts sequentially
+#define MAX_THREADS 64
+
+/* ---------- Run detection ---------- */
+
+static void insertion_sort(int *arr, size_t start, size_t n) {
+    // arr[0..start) is already sorted
+    for (size_t i = start < 1 ? 1 : start; i < n; i++) {
+        int key = arr[i];
+        size_t j = i;
+        while (j > 0 && arr[j - 1] > key) {
+            arr[j] = arr[j - 1];
+            j--;
+        }
+        arr[j] = key;
+    }
+}
+
+/**
+ * @brief Returns the length of the natural run starting at arr[0], reversing
+ * it in place if it is descending. Only strictly descending runs are
+ * reversed so that equal elements keep their order (stability).
+ */
+static size_t count_run(int *arr, size_t n) {
+    if (n < 2) return n;
+    size_t len = 2;
+    if (arr[1] < arr[0]) {
+        while (len < n && arr[len] < arr[len - 1]) len++;
+        for (size_t i = 0, j = len - 1; i < j; i++, j--) {
+            int t = arr[i];
+            arr[i] = arr[j];
+            arr[j] = t;
+        }
+    } else {
+        while (len < n && arr[len] >= arr[len - 1]) len++;
+    }
+    return len;
+}
+
+/* ---------- AVX2 sorting network base case ---------- */
+
+/*
+ * Ranges of up to 32 ints are sorted by the 32-element bitonic network of
+ * sorting_network_simd.c, held in four AVX2 registers and padded with
+ * INT_MAX: a fixed sequence of min/max steps with no data-dependent
+ * branches. Without AVX2 the insertion sorts are used instead.
+ */
+#if HAVE_X86_KERNELS
+
+// Compare-exchange inside a register: p holds each lane's partner, and the
+// lanes set in `upper` keep the maximum
+#define EXCHANGE(v, p, upper) \
+    _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), upper)
+#define REVERSE(v) _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+#define FLIP2(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0xB1), 0xAA)            // lane ^ 1
+#define FLIP4(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0x1B), 0xCC)            // lane ^ 3
+#define FLIP8(v) EXCHANGE(v, REVERSE(v), 0xF0)                               // lane ^ 7
+#define HALF2(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0x4E), 0xCC)            // lane ^ 2
+#define HALF4(v) EXCHANGE(v, _mm256_permute2x128_si256(v, v, 1), 0xF0)       // lane ^ 4
+
+// Element i of x against its mirror in y (the reversed partner register)
+#define MIRROR(x, y) do {                                                    \
+        __m256i b_ = REVERSE(y);                                             \
+        y = REVERSE(_mm256_max_epi32(x, b_));                                \
+        x = _mm256_min_epi32(x, b_);                                         \
+    } while (0)
+#define MINMAX(x, y) do {                                                    \
+        __m256i lo_ = _mm256_min_epi32(x, y);                                \
+        y = _mm256_max_epi32(x, y);                                          \
+        x = lo_;                                                             \
+    } while (0)
+
+/**
+ * @brief Sorts a[0..n), n <= 32. Each merge stage k compares element i
+ * with its mirror i ^ (k - 1), then runs half-cleaners at k/4 .. 1.
+ */
+__attribute__((target("avx2")))
+static void network_sort(int *a, size_t n) {
+    int buf[32];
+    memcpy(buf, a, n * sizeof(int));
+    for (size_t i = n; i < 32; i++) buf[i] = INT_MAX;   // Sorts to the end
+    __m256i v[4];
+    for (int r = 0; r < 4; r++) v[r] = _mm256_loadu_si256((const __m256i *)(buf + 8 * r));
+
+    for (int r = 0; r < 4; r++) {
+        v[r] = FLIP2(v[r]);                                 // k = 2
+        v[r] = FLIP2(FLIP4(v[r]));                          // k = 4
+        v[r] = FLIP2(HALF2(FLIP8(v[r])));                   // k = 8
+    }
+    MIRROR(v[0], v[1]);                                     // k = 16
+    MIRROR(v[2], v[3]);
+    for (int r = 0; r < 4; r++) v[r] = FLIP2(HALF2(HALF4(v[r])));
+    MIRROR(v[0], v[3]);                                     // k = 32
+    MIRROR(v[1], v[2]);
+    MINMAX(v[0], v[1]);
+    MINMAX(v[2], v[3]);
+    for (int r = 0; r < 4; r++) v[r] = FLIP2(HALF2(HALF4(v[r])));
+
+    for (int r = 0; r < 4; r++) _mm256_storeu_si256((__m256i *)(buf + 8 * r), v[r]);
+    memcpy(a, buf, n * sizeof(int));
+}
+
+#else
+
+static void network_sort(int *a, size_t n) { insertion_sort(a, 0, n); }
+
+#endif
+
+// -1 until the CPU has been checked; set_network_base_case() overrides it
+static int use_network = -1;
+
+static int network_enabled(void) {
+    if (use_network < 0) {
+#if HAVE_X86_KERNELS
+        __builtin_cpu_init();
+        use_network = __builtin_cpu_supports("avx2");
+#else
+        use_network = 0;
+#endif
+    }
+    return use_network;
+}
+
+/**
+ * @brief Turns the network base case off (0) or back on where AVX2 exists (1).
+ * @return 1 if the network is in use afterwards.
+ */
+int set_network_base_case(int enable) {
+    use_network = -1;
+    if (!enable) use_network = 0;
+    return network_enabled();
+}
+
+/* ---------- Merging ---------- */
+
+/**
+ * @brief Index of the first element of a[0..n) that is >= key, searching
+ * outward from the start in steps 1, 3, 7, ... before a binary search.
+ * Costs O(log i) for answer i, which is what makes galloping cheap.
+ */
+static size_t gallop_lower(const int *a, size_t n, int key) {
+    size_t lo = 0, hi = 1;
+    while (hi < n && a[hi - 1] < key) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    if (hi > n) hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Index of the first element of a[0..n) that is > key.
+ */
+static size_t gallop_upper(const int *a, size_t n, int key) {
+    size_t lo = 0, hi = 1;
+    while (hi < n && a[hi - 1] <= key) {
+        lo = hi;
+        hi = 2 * hi + 1;
+    }
+    if (hi > n) hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] <= key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * @brief Stable merge of sorted a[0..na) and b[0..nb) into out.
+ *
+ * Elements are taken one at a time until one side wins GALLOP_TRIGGER times
+ * in a row; then whole blocks are located with gallop_* and copied with
+ * memcpy, for as long as the blocks stay long. Already-ordered inputs
+ * become a pair of memcpy calls.
+ */
+static void merge_runs(const int *a, size_t na, const int *b, size_t nb, int *out) {
+    size_t i = 0, j = 0, k = 0;
+
+    while (i < na && j < nb) {
+        // Written without branches on the comparison (the compiler emits
+        // conditional moves), since on random data it is a coin flip
+        size_t wins_a = 0, wins_b = 0;
+        while (i < na && j < nb && wins_a < GALLOP_TRIGGER && wins_b < GALLOP_TRIGGER) {
+            int x = a[i], y = b[j];
+            size_t take_b = y < x;
+            out[k++] = take_b ? y : x;
+            j += take_b;
+            i += take_b ^ 1;
+            wins_b = (wins_b + 1) & (0 - take_b);
+            wins_a = (wins_a + 1) & (take_b - 1);
+        }
+
+        while (i < na && j < nb) {
+            // Elements of a that are <= b[j] precede it (a wins ties)
+            size_t run_a = gallop_upper(a + i, na - i, b[j]);
+            memcpy(out + k, a + i, run_a * sizeof(int));
+            k += run_a;
+            i += run_a;
+            if (i == na) break;
+
+            // Elements of b that are < a[i] precede it
+            size_t run_b = gallop_lower(b + j, nb - j, a[i]);
+            memcpy(out + k, b + j, run_b * sizeof(int));
+            k += run_b;
+            j += run_b;
+
+            if (run_a < GALLOP_TRIGGER && run_b < GALLOP_TRIGGER) break;
+        }
+    }
+
+    memcpy(out + k, a + i, (na - i) * sizeof(int));
+    k += na - i;
+    memcpy(out + k, b + j, (nb - j) * sizeof(int));
+}
+
+/* ---------- Sequential sort ---------- */
+
+/**
+ * @brief Stable sort of arr[0..n) using `scratch` (n ints) as the only
+ * element buffer.
+ *
+ * Run boundaries are collected first; each bottom-up pass then merges
+ * neighbouring runs from the current buffer into the other one.
+ */
+void merge_sort_buffered(int *arr, size_t n, int *scratch) {
+    if (n < 2) return;
+
+    size_t max_runs = n / MIN_RUN + 2;
+    size_t *bounds = (size_t *)malloc((max_runs + 1) * sizeof(size_t));
+    if (bounds == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    size_t runs = 0, pos = 0;
+    while (pos < n) {
+        size_t remaining = n - pos;
+        size_t len = count_run(arr + pos, remaining);
+        if (len < MIN_RUN) {
+            size_t forced = remaining < MIN_RUN ? remaining : MIN_RUN;
+            // Equal ints are indistinguishable, so the unstable network is safe here
+            if (network_enabled()) network_sort(arr + pos, forced);
+            else insertion_sort(arr + pos, len, forced);
+            len = forced;
+        }
+        bounds[runs++] = pos;
+        pos += len;
+    }
+    bounds[runs] = n;
+
+    int *src = arr, *dst = scratch;
+    while (runs > 1) {
+        size_t r = 0, kept = 0;
+        for (; r + 1 < runs; r += 2) {
+            size_t lo = bounds[r], mid = bounds[r + 1], hi = bounds[r + 2];
+            merge_runs(src + lo, mid - lo, src + mid, hi - mid, dst + lo);
+            bounds[kept++] = lo;
+        }
+        if (r < runs) {
+            // Odd run out: carry it to the other buffer unchanged
+            memcpy(dst + bounds[r], src + bounds[r], (n - bounds[r]) * sizeof(int));
+            bounds[kept++] = bounds[r];
+        }
+        bounds[kept] = n;
+        runs = kept;
+
+        int *t = src;
+        src = dst;
+        dst = t;
+    }
+    if (src != arr) memcpy(arr, src, n * sizeof(int));
+    free(bounds);
+}
+
+/**
+ * @brief Main function that sorts arr[l..r] using merge_sort_buffered().
+ * Allocates one scratch buffer for the whole sort.
+ */
+void merge_sort(int arr[], int l, int r) {
+    if (l >= r) return;
+    size_t n = (size_t)(r - l) + 1;
+    int *scratch = (int *)malloc(n * sizeof(int));
+    if (scratch == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    merge_sort_buffered(arr + l, n, scratch);
+    free(scratch);
+}
+
+/* ---------- Parallel sort ---------- */
+
+/**
+ * @brief Splits the first k outputs of a stable merge of a and b: returns
+ * how many of them come from a (the rest, k - i, come from b).
+ */
+static size_t co_rank(size_t k, const int *a, size_t na, const int *b, size_t nb) {
+    size_t lo = k > nb ? k - nb : 0;
+    size_t hi = k < na ? k : na;
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        size_t j = k - i;
+        // a[i] must be taken before b[j - 1]: take more from a
+        if (j > 0 && a[i] <= b[j - 1]) lo = i + 1;
+        else hi = i;
+    }
+    return lo;
+}
+
+typedef struct {
+    const int *a, *b;
+    size_t na, nb;
+    int *out;
+} MergeTask;
+
+static void *merge_task(void *arg) {
+    MergeTask *t = (MergeTask *)arg;
+    merge_runs(t->a, t->na, t->b, t->nb, t->out);
+    return NULL;
+}
+
+/**
+ * @brief Merges a and b into out using `threads` threads. Output slice t
+ * starts at k_t = total * t / threads; co_rank finds the matching split of
+ * each input, so the slices are independent merges of equal length.
+ */
+static void parallel_merge(const int *a, size_t na, const int *b, size_t nb, int *out,
+                           int threads) {
+    pthread_t tid[MAX_THREADS];
+    MergeTask tasks[MAX_THREADS];
+    size_t total = na + nb;
+
+    size_t prev_i = 0, prev_k = 0;
+    for (int t = 0; t < threads; t++) {
+        size_t k = total * (t + 1) / threads;
+        size_t i = co_rank(k, a, na, b, nb);
+        tasks[t].a = a + prev_i;
+        tasks[t].na = i - prev_i;
+        tasks[t].b = b + (prev_k - prev_i);
+        tasks[t].nb = (k - i) - (prev_k - prev_i);
+        tasks[t].out = out + prev_k;
+        prev_i = i;
+        prev_k = k;
+    }
+
+    for (int t = 1; t < threads; t++)
+        if (pthread_create(&tid[t], NULL, merge_task, &tasks[t]) != 0) {
+            merge_task(&tasks[t]);
+            tid[t] = 0;
+        }
+    merge_task(&tasks[0]);
+    for (int t = 1; t < threads; t++)
+        if (tid[t]) pthread_join(tid[t], NULL);
+}
+
+typedef struct {
+    int *a;          // Data to sort
+    int *b;          // Scratch of the same length
+    size_t n;
+    int threads;     // Threads available to this task
+    int result_in_b; // 1 if the sorted output must end up in b
+} SortTask;
+
+/**
+ * Each task sorts its range with `threads` threads: it runs the left half
+ * in a new thread and the right half itself, then merges both halves with
+ * all of its threads. Children leave their output in the buffer the merge
+ * reads from, so every level merges straight from one buffer to the other.
+ */
+static void *sort_task(void *arg) {
+    SortTask *t = (SortTask *)arg;
+
+    if (t->threads <= 1 || t->n < PARALLEL_MIN_SIZE) {
+        merge_sort_buffered(t->a, t->n, t->b);
+        if (t->result_in_b) memcpy(t->b, t->a, t->n * sizeof(int));
+        return NULL;
+    }
+
+    size_t half = t->n / 2;
+    int left_threads = t->threads / 2;
+    SortTask left = { t->a, t->b, half, left_threads, !t->result_in_b };
+    SortTask right = { t->a + half, t->b + half, t->n - half, t->threads - left_threads,
+                       !t->result_in_b };
+
+    pthread_t tid;
+    int spawned = pthread_create(&tid, NULL, sort_task, &left) == 0;
+    if (!spawned) sort_task(&left);
+    sort_task(&right);
+    if (spawned) pthread_join(tid, NULL);
+
+    const int *src = t->result_in_b ? t->a : t->b;
+    int *dst = t->result_in_b ? t->b : t->a;
+    parallel_merge(src, half, src + half, t->n - half, dst, t->threads);
+    return NULL;
+}
+
+/**
+ * @brief Stable parallel sort of arr[0..n) with up to `threads` threads.
+ */
+void parallel_merge_sort(int *arr, size_t n, int threads) {
+    if (n < 2) return;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+    if (threads < 1) threads = 1;
+
+    int *scratch = (int *)malloc(n * sizeof(int));
+    if (scratch == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    SortTask root = { arr, scratch, n, threads, 0 };
+    sort_task(&root);
+    free(scratch);
+}
+
+/* ---------- Original version, kept for comparison ---------- */
 
 /**
  * @brief Merges two subarrays of arr[].
@@ -64,17 +516,13 @@ void merge(int arr[], int l, int m, int r) {
     free(R);
 }
 
-/**
- * @brief Main function that sorts arr[l..r] using merge().
- */
-void merge_sort(int arr[], int l, int r) {
+void legacy_merge_sort(int arr[], int l, int r) {
     if (l < r) {
         // Same as (l+r)/2, but avoids overflow for large l and h
         int m = l + (r - l) / 2;
 
-        // Sort first and second halves
-        merge_sort(arr, l, m);
-        merge_sort(arr, m + 1, r);
+        legacy_merge_sort(arr, l, m);
+        legacy_merge_sort(arr, m + 1, r);
 
         merge(arr, l, m, r);
     }
@@ -87,7 +535,115 @@ void print_array(int A[], int size) {
     printf("\n");
 }
 
-int main() {
+/* ---------- Benchmark ---------- */
+
+typedef enum { INPUT_RANDOM, INPUT_SORTED, INPUT_REVERSED, INPUT_NEARLY_SORTED,
+               INPUT_FEW_UNIQUE, INPUT_COUNT } InputKind;
+
+const char *input_names[INPUT_COUNT] = { "random", "sorted", "reversed", "nearly sorted",
+                                         "few unique" };
+
+void fill_input(int *arr, size_t n, InputKind kind) {
+    unsigned long long s = 88172645463325252ULL;
+    for (size_t i = 0; i < n; i++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        switch (kind) {
+        case INPUT_RANDOM:     arr[i] = (int)(s >> 32); break;
+        case INPUT_REVERSED:   arr[i] = (int)(n - i); break;
+        case INPUT_FEW_UNIQUE: arr[i] = (int)(s % 16); break;
+        default:               arr[i] = (int)i; break;
+        }
+    }
+    if (kind == INPUT_NEARLY_SORTED) {
+        // Swap 1% of the elements with a random partner
+        for (size_t k = 0; k < n / 100; k++) {
+            s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+            size_t i = s % n, j = (s >> 32) % n;
+            int t = arr[i];
+            arr[i] = arr[j];
+            arr[j] = t;
+        }
+    }
+}
+
+int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+int run_benchmark(size_t n, int threads) {
+    int *input = (int *)malloc(n * sizeof(int));
+    int *work = (int *)malloc(n * sizeof(int));
+    int *expected = (int *)malloc(n * sizeof(int));
+    int *scratch = (int *)malloc(n * sizeof(int));
+    if (!input || !work || !expected || !scratch) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 1;
+    }
+
+    int network = set_network_base_case(1);
+    printf("n = %zu, %d threads, times in ms (+network: buffered with the AVX2 network "
+           "sorting short runs%s)\n", n, threads, network ? "" : ", skipped without AVX2");
+    printf("%-14s %12s %12s %12s %12s %12s\n", "input", "original", "qsort", "buffered",
+           "+network", "parallel");
+
+    int mismatch = 0;
+    for (int kind = 0; kind < INPUT_COUNT; kind++) {
+        fill_input(input, n, (InputKind)kind);
+        memcpy(expected, input, n * sizeof(int));
+        qsort(expected, n, sizeof(int), compare_ints);
+        printf("%-14s", input_names[kind]);
+
+        for (int s = 0; s < 5; s++) {
+            // Only the buffered column runs without the network
+            set_network_base_case(s != 2);
+            if (s == 3 && !network) {
+                printf(" %12s", "(skipped)");
+                continue;
+            }
+            memcpy(work, input, n * sizeof(int));
+            double t0 = now_seconds();
+            switch (s) {
+            case 0: legacy_merge_sort(work, 0, (int)n - 1); break;
+            case 1: qsort(work, n, sizeof(int), compare_ints); break;
+            case 2: case 3: merge_sort_buffered(work, n, scratch); break;
+            default: parallel_merge_sort(work, n, threads); break;
+            }
+            printf(" %12.2f", (now_seconds() - t0) * 1e3);
+            if (memcmp(work, expected, n * sizeof(int)) != 0) mismatch = 1;
+        }
+        printf("\n");
+    }
+
+    free(input);
+    free(work);
+    free(expected);
+    free(scratch);
+    if (mismatch) {
+        fprintf(stderr, "Error: a sorter produced output different from qsort.\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        long n = argc > 2 ? atol(argv[2]) : 4000000;
+        int threads = argc > 3 ? atoi(argv[3]) : (cpus > 0 ? (int)cpus : 1);
+        if (n <= 0 || threads <= 0) {
+            fprintf(stderr, "Error: size and thread count must be positive.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)n, threads);
+    }
+
     int arr[] = {12, 11, 13, 5, 6, 7};
     int arr_size = sizeof(arr) / sizeof(arr[0]);
 
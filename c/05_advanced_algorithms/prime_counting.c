@@ -0,0 +1,428 @@
+/**
+ * @file prime_counting.c
+ * @brief Prime queries without listing every prime: range counts, pi(x)
+ *        and the n-th prime.
+ *
+ * This program demonstrates:
+ * 1. Segmented range sieving of an arbitrary window [a, b]: only the primes
+ *    up to sqrt(b) and one L1-sized bit buffer are needed, wherever the
+ *    window lies
+ * 2. Lucy_Hedgehog's algorithm for pi(x) in O(x^(3/4)) time and
+ *    O(sqrt(x)) memory. It only tracks pi at the values floor(x / i), which
+ *    is all the recurrence S(v, p) = S(v, p - 1) - (S(v / p, p - 1) -
+ *    S(p - 1, p - 1)) ever asks for
+ * 3. Indexing the large values by i instead of by x / i, so that
+ *    x / (i * p) is found by multiplying i * p instead of dividing
+ * 4. The n-th prime: estimate it from the prime number theorem, count the
+ *    primes up to the estimate with Lucy_Hedgehog, then range-sieve from
+ *    there to the exact answer
+ * 5. Latency measurements for x up to 10^13
+ *
+ * prime_sieve_segmented.c lists or counts every prime up to a limit; this
+ * file answers single queries.
+ *
+ * Usage:
+ * gcc -O2 prime_counting.c -o prime_counting -lm
+ * ./prime_counting                 (latency benchmark, x up to 10^13)
+ * ./prime_counting pi x            (number of primes <= x)
+ * ./prime_counting range a b       (number of primes in [a, b])
+ * ./prime_counting nth n           (the n-th prime, 2 being the first)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#define SEGMENT_BYTES 32768                         // One L1-sized window
+#define SEGMENT_BITS ((uint64_t)SEGMENT_BYTES * 8)  // Odd numbers per segment
+#define NTH_WINDOW (1ULL << 24)                     // Most numbers sieved per step of the n-th prime walk
+#define NTH_VISIT 4096                              // Primes this close are visited without counting first
+#define MAX_QUERY 1000000000000000000ULL            // 10^18; keeps sqrt and products in range
+
+typedef int (*prime_visitor)(uint64_t prime, void *arg);  // Return nonzero to stop
+
+static uint64_t isqrt64(uint64_t x) {
+    uint64_t r = (uint64_t)sqrtl((long double)x);
+    while (r * r > x) r--;
+    while ((r + 1) * (r + 1) <= x) r++;
+    return r;
+}
+
+/* ---------- Range sieve ---------- */
+
+/* Odd primes up to limit, from a byte-per-odd-number sieve */
+static uint32_t *odd_primes_up_to(uint64_t limit, size_t *count) {
+    size_t odd = (size_t)(limit / 2 + 1);
+    unsigned char *composite = (unsigned char *)calloc(odd, 1);
+    uint32_t *primes = (uint32_t *)malloc(odd * sizeof(uint32_t));
+    *count = 0;
+    if (composite == NULL || primes == NULL) {
+        free(composite);
+        free(primes);
+        return NULL;
+    }
+    for (uint64_t j = 1; j < odd; j++) {
+        if (composite[j]) continue;
+        uint64_t p = 2 * j + 1;
+        primes[(*count)++] = (uint32_t)p;
+        for (uint64_t k = (p * p) / 2; k < odd; k += p) composite[k] = 1;
+    }
+    free(composite);
+    return primes;
+}
+
+/*
+ * Sieves the odd numbers of [a, b], one segment of SEGMENT_BITS odd
+ * numbers at a time; bit j of a segment stands for 2 * (first + j) + 1.
+ * With a visitor, primes are passed to it in increasing order until it
+ * returns nonzero; without one they are only counted. Returns the number
+ * of primes seen, or (uint64_t)-1 if memory allocation failed.
+ */
+static uint64_t sieve_window(uint64_t a, uint64_t b, prime_visitor visit, void *arg) {
+    if (b > MAX_QUERY) b = MAX_QUERY;
+    if (a < 2) a = 2;
+    if (a > b) return 0;
+
+    uint64_t count = 0;
+    if (a == 2) {
+        count++;
+        if (visit && visit(2, arg)) return count;
+        a = 3;
+        if (a > b) return count;
+    }
+
+    size_t prime_count;
+    uint32_t *primes = odd_primes_up_to(isqrt64(b), &prime_count);
+    unsigned char *seg = (unsigned char *)malloc(SEGMENT_BYTES + 8);
+    if (primes == NULL || seg == NULL) {
+        free(primes);
+        free(seg);
+        return (uint64_t)-1;
+    }
+
+    uint64_t first = a / 2, last = (b - 1) / 2;     // Odd numbers 2j + 1 with j in [first, last]
+    int stop = 0;
+    for (uint64_t lo = first; lo <= last && !stop; lo += SEGMENT_BITS) {
+        uint64_t bits = last - lo + 1 < SEGMENT_BITS ? last - lo + 1 : SEGMENT_BITS;
+        size_t bytes = (size_t)((bits + 7) / 8), words = (size_t)((bits + 63) / 64);
+        memset(seg, 0xFF, bytes);
+        memset(seg + bytes, 0, words * 8 - bytes);
+        if (bits & 7) seg[bytes - 1] &= (unsigned char)((1u << (bits & 7)) - 1);
+        if (lo == 0) seg[0] &= (unsigned char)~1u;     // 1 is not prime
+
+        uint64_t hi_value = 2 * (lo + bits - 1) + 1;
+        for (size_t i = 0; i < prime_count; i++) {
+            uint64_t p = primes[i];
+            if (p * p > hi_value) break;
+            // First odd multiple of p inside the segment, but not below p * p
+            uint64_t start = (p * p) / 2;
+            if (start < lo) start += (lo - start + p - 1) / p * p;
+            for (uint64_t k = start - lo; k < bits; k += p) seg[k >> 3] &= (unsigned char)~(1u << (k & 7));
+        }
+
+        for (size_t w = 0; w < words && !stop; w++) {
+            uint64_t word;
+            memcpy(&word, seg + w * 8, 8);
+            if (!visit) {
+                count += (uint64_t)__builtin_popcountll(word);
+                continue;
+            }
+            while (word) {
+                uint64_t j = lo + w * 64 + (uint64_t)__builtin_ctzll(word);
+                count++;
+                if (visit(2 * j + 1, arg)) {
+                    stop = 1;
+                    break;
+                }
+                word &= word - 1;
+            }
+        }
+    }
+    free(primes);
+    free(seg);
+    return count;
+}
+
+/**
+ * @brief Number of primes in [a, b], or (uint64_t)-1 if memory ran out.
+ * Costs about (b - a) / 2 bit operations plus pi(sqrt(b)) per 256K odd
+ * numbers, so it suits windows up to a few billion wide.
+ */
+uint64_t count_primes_range(uint64_t a, uint64_t b) {
+    return sieve_window(a, b, NULL, NULL);
+}
+
+/**
+ * @brief Passes every prime in [a, b] to visit, in increasing order, until
+ * it returns nonzero. Returns the number of primes visited.
+ */
+uint64_t for_each_prime_range(uint64_t a, uint64_t b, prime_visitor visit, void *arg) {
+    return sieve_window(a, b, visit, arg);
+}
+
+/* ---------- pi(x): Lucy_Hedgehog ---------- */
+
+/**
+ * @brief Number of primes <= x, or (uint64_t)-1 if memory ran out.
+ *
+ * small[v] = S(v) for v <= r = sqrt(x) and large[i] = S(x / i) for
+ * i <= x / (r + 1), where S(v) starts as v - 1 (every number in 2..v) and,
+ * after sieving with each prime p, has the multiples of p with no smaller
+ * factor removed. At the end S(v) = pi(v).
+ */
+uint64_t prime_pi(uint64_t x) {
+    if (x < 2) return 0;
+    if (x > MAX_QUERY) return (uint64_t)-1;
+    uint64_t r = isqrt64(x);
+    uint64_t large_count = x / (r + 1);        // Values x / i > r have i <= x / (r + 1)
+    uint64_t *small = (uint64_t *)malloc((r + 1) * sizeof(uint64_t));
+    uint64_t *large = (uint64_t *)malloc((large_count + 2) * sizeof(uint64_t));
+    if (small == NULL || large == NULL) {
+        free(small);
+        free(large);
+        return (uint64_t)-1;
+    }
+    for (uint64_t v = 0; v <= r; v++) small[v] = v ? v - 1 : 0;
+    for (uint64_t i = 1; i <= large_count; i++) large[i] = x / i - 1;
+
+    for (uint64_t p = 2; p <= r; p++) {
+        if (small[p] == small[p - 1]) continue;     // p is composite
+        uint64_t below = small[p - 1];              // Primes smaller than p
+        uint64_t p2 = p * p;
+
+        // Large values x / i >= p^2, i.e. i <= x / p^2. x / (i * p) is
+        // itself a large value when i * p <= large_count, otherwise small.
+        uint64_t end = x / p2 < large_count ? x / p2 : large_count;
+        uint64_t direct = large_count / p < end ? large_count / p : end;
+        for (uint64_t i = 1; i <= direct; i++) large[i] -= large[i * p] - below;
+        for (uint64_t i = direct + 1; i <= end; i++) large[i] -= small[x / (i * p)] - below;
+
+        // Small values v >= p^2, from the top so small[v / p] is still old
+        for (uint64_t v = r; v >= p2; v--) small[v] -= small[v / p] - below;
+    }
+
+    uint64_t result = large_count >= 1 ? large[1] : small[x];
+    free(small);
+    free(large);
+    return result;
+}
+
+/* ---------- n-th prime ---------- */
+
+typedef struct {
+    uint64_t remaining;
+    uint64_t found;
+} NthState;
+
+/* Enough numbers near x to hold about k primes, within [2^16, NTH_WINDOW] */
+static uint64_t nth_window(uint64_t k, uint64_t x) {
+    double width = (double)k * log((double)x + 3) * 1.25 + 65536;
+    return width < (double)NTH_WINDOW ? (uint64_t)width : NTH_WINDOW;
+}
+
+static int take_nth(uint64_t prime, void *arg) {
+    NthState *s = (NthState *)arg;
+    if (--s->remaining == 0) {
+        s->found = prime;
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * @brief The n-th prime (nth_prime(1) = 2), or 0 if memory ran out or the
+ * answer would exceed MAX_QUERY.
+ *
+ * The estimate n (ln n + ln ln n - 1 + (ln ln n - 2) / ln n) is within a
+ * few thousandths of the answer for large n. pi(estimate) says how many
+ * primes lie before it; windows sized to the remaining distance are then
+ * counted (backwards if the estimate overshot) until the window holding
+ * the answer is found, and that window is walked prime by prime.
+ */
+uint64_t nth_prime(uint64_t n) {
+    if (n == 0) return 0;
+    uint64_t start = 0, below = 0;              // below = pi(start)
+    if (n >= 100) {
+        double ln = log((double)n), lnln = log(ln);
+        double estimate = n * (ln + lnln - 1 + (lnln - 2) / ln);
+        if (estimate >= (double)MAX_QUERY) return 0;
+        start = (uint64_t)estimate;
+        below = prime_pi(start);
+        if (below == (uint64_t)-1) return 0;
+        while (below >= n) {                    // Overshot: step back one window at a time
+            uint64_t width = nth_window(below - n + 1, start);
+            uint64_t lo = start > width ? start - width + 1 : 1;
+            uint64_t seen = count_primes_range(lo, start);
+            if (seen == (uint64_t)-1) return 0;
+            start = lo - 1;
+            below -= seen;
+        }
+    }
+
+    NthState state = { n - below, 0 };
+    for (uint64_t lo = start + 1, hi; state.found == 0 && lo <= MAX_QUERY; lo = hi + 1) {
+        hi = lo + nth_window(state.remaining, lo) - 1;
+        if (state.remaining > NTH_VISIT) {      // Counting a window is cheaper than visiting it
+            uint64_t seen = count_primes_range(lo, hi);
+            if (seen == (uint64_t)-1) return 0;
+            if (seen < state.remaining) {
+                state.remaining -= seen;
+                continue;
+            }
+        }
+        if (for_each_prime_range(lo, hi, take_nth, &state) == (uint64_t)-1) return 0;
+    }
+    return state.found;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* pi(10^k) and the 10^k-th prime for k = 0 .. 13 */
+static const uint64_t known_pi[] = {
+    0, 4, 25, 168, 1229, 9592, 78498, 664579, 5761455, 50847534, 455052511,
+    4118054813ULL, 37607912018ULL, 346065536839ULL,
+};
+static const uint64_t known_nth[] = {
+    2, 29, 541, 7919, 104729, 1299709, 15485863, 179424673, 2038074743ULL,
+    22801763489ULL, 252097800623ULL, 2760727302517ULL, 29996224275833ULL,
+    323780508946331ULL,
+};
+
+#define RANGE_SIEVE_MAX 1000000000ULL   // Largest x for which pi(x) is also range-sieved
+
+int run_benchmark(uint64_t max_x) {
+    int failures = 0;
+
+    printf("pi(x) latency (ms)\n");
+    printf("%16s %16s %12s %12s %8s\n", "x", "pi(x)", "Lucy", "range sieve", "check");
+    uint64_t x = 1;
+    for (int k = 0; k <= 13 && x <= max_x; k++, x *= 10) {
+        if (k < 3) continue;
+        double t0 = now_seconds();
+        uint64_t pi = prime_pi(x);
+        double t_lucy = now_seconds() - t0;
+        if (pi == (uint64_t)-1) {
+            printf("%16llu: not enough memory, stopping.\n", (unsigned long long)x);
+            break;
+        }
+
+        char sieve_text[32] = "-";
+        int wrong = pi != known_pi[k];
+        if (x <= RANGE_SIEVE_MAX) {
+            t0 = now_seconds();
+            uint64_t sieved = count_primes_range(0, x);
+            snprintf(sieve_text, sizeof(sieve_text), "%.1f", (now_seconds() - t0) * 1e3);
+            wrong |= sieved != pi;
+        }
+        failures += wrong;
+        printf("%16llu %16llu %12.1f %12s %8s\n", (unsigned long long)x, (unsigned long long)pi,
+               t_lucy * 1e3, sieve_text, wrong ? "WRONG" : "ok");
+    }
+
+    // Windows far from the origin: the sieve cost depends on the width only
+    printf("\nRange queries [a, a + width]: range sieve against pi(b) - pi(a - 1)\n");
+    printf("%16s %12s %12s %12s %12s %8s\n", "a", "width", "primes", "sieve ms", "2x Lucy ms", "check");
+    for (uint64_t a = 1000000000ULL; a <= max_x; a *= 100) {
+        uint64_t width = 100000000ULL;
+        double t0 = now_seconds();
+        uint64_t sieved = count_primes_range(a, a + width);
+        double t_sieve = now_seconds() - t0;
+        t0 = now_seconds();
+        uint64_t lucy = prime_pi(a + width) - prime_pi(a - 1);
+        double t_lucy = now_seconds() - t0;
+        int wrong = sieved != lucy;
+        failures += wrong;
+        printf("%16llu %12llu %12llu %12.1f %12.1f %8s\n", (unsigned long long)a,
+               (unsigned long long)width, (unsigned long long)sieved, t_sieve * 1e3, t_lucy * 1e3,
+               wrong ? "WRONG" : "ok");
+    }
+
+    printf("\nn-th prime latency (ms)\n");
+    printf("%16s %18s %12s %8s\n", "n", "p(n)", "time", "check");
+    uint64_t n = 1;
+    for (int k = 0; k <= 13; k++, n *= 10) {
+        if ((double)known_nth[k] > (double)max_x * 1.0001) break;
+        double t0 = now_seconds();
+        uint64_t p = nth_prime(n);
+        double t = now_seconds() - t0;
+        int wrong = p != known_nth[k];
+        failures += wrong;
+        printf("%16llu %18llu %12.1f %8s\n", (unsigned long long)n, (unsigned long long)p, t * 1e3,
+               wrong ? "WRONG" : "ok");
+    }
+
+    if (failures) {
+        fprintf(stderr, "Error: %d results were wrong.\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+static int parse_u64(const char *text, uint64_t *out) {
+    // Digits are parsed exactly; 1e12-style input is accepted if it is whole
+    char *end;
+    unsigned long long exact = strtoull(text, &end, 10);
+    if (end != text && *end == '\0' && !strchr(text, '-')) {
+        if (exact > MAX_QUERY) return -1;
+        *out = (uint64_t)exact;
+        return 0;
+    }
+    double value = strtod(text, &end);
+    if (end == text || *end != '\0') return -1;
+    if (!(value >= 0 && value <= (double)MAX_QUERY) || value != (double)(uint64_t)value) return -1;
+    *out = (uint64_t)value;
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc == 1 || (argc == 3 && strcmp(argv[1], "--bench") == 0)) {
+        uint64_t max_x = 10000000000000ULL;
+        if (argc == 3 && parse_u64(argv[2], &max_x) != 0) {
+            fprintf(stderr, "Error: limit out of range.\n");
+            return 1;
+        }
+        return run_benchmark(max_x);
+    }
+
+    uint64_t a, b;
+    double t0 = now_seconds();
+    if (argc == 3 && strcmp(argv[1], "pi") == 0 && parse_u64(argv[2], &a) == 0) {
+        uint64_t pi = prime_pi(a);
+        if (pi == (uint64_t)-1) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return 1;
+        }
+        printf("pi(%llu) = %llu", (unsigned long long)a, (unsigned long long)pi);
+    } else if (argc == 4 && strcmp(argv[1], "range") == 0 && parse_u64(argv[2], &a) == 0 &&
+               parse_u64(argv[3], &b) == 0) {
+        uint64_t count = count_primes_range(a, b);
+        if (count == (uint64_t)-1) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return 1;
+        }
+        printf("primes in [%llu, %llu] = %llu", (unsigned long long)a, (unsigned long long)b,
+               (unsigned long long)count);
+    } else if (argc == 3 && strcmp(argv[1], "nth") == 0 && parse_u64(argv[2], &a) == 0) {
+        uint64_t p = nth_prime(a);
+        if (p == 0) {
+            fprintf(stderr, "Error: no answer (n = 0, out of range or out of memory).\n");
+            return 1;
+        }
+        printf("prime #%llu = %llu", (unsigned long long)a, (unsigned long long)p);
+    } else {
+        fprintf(stderr, "Usage: %s [--bench max_x | pi x | range a b | nth n]\n", argv[0]);
+        return 1;
+    }
+    printf(" (%.1f ms)\n", (now_seconds() - t0) * 1e3);
+    return 0;
+}
@@ -0,0 +1,518 @@
+/**
+ * @file prime_sieve_segmented.c
+ * @brief Segmented, bit-packed, multi-threaded Sieve of Eratosthenes.
+ *
+ * This program demonstrates:
+ * 1. Odd-only bit packing: bit j stands for the odd number 2j + 1, so one
+ *    byte covers 16 integers instead of 1
+ * 2. A pre-sieved wheel: the pattern left by 3, 5, 7, 11 and 13 repeats
+ *    every 15015 odd numbers, so it is copied into each segment instead of
+ *    being sieved; crossing off starts at 17
+ * 3. Segments of 32 KB (the size of a typical L1 data cache) so every
+ *    crossing-off write hits L1
+ * 4. Threads that claim slabs of consecutive segments from a shared
+ *    counter, remembering each sieving prime's next multiple from one
+ *    segment to the next
+ * 5. Counting or emitting (in order) every prime up to 10^12 and beyond in
+ *    bounded memory: the sieving primes up to sqrt(limit) plus one buffer
+ *    per thread
+ *
+ * See 01_basics_revision/prime_generator.c for the one-byte-per-number
+ * version this replaces.
+ *
+ * Usage:
+ * gcc -O2 -pthread prime_sieve_segmented.c -o prime_sieve_segmented -lm
+ * ./prime_sieve_segmented                       (benchmark, counts up to 10^10)
+ * ./prime_sieve_segmented --bench 1e12          (benchmark up to 10^12)
+ * ./prime_sieve_segmented count 1e12 [threads]  (pi(limit))
+ * ./prime_sieve_segmented print 1000 [threads]  (every prime up to limit)
+ */
+
+#define _POSIX_C_SOURCE 200112L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SEGMENT_BYTES 32768                         // One L1-sized window
+#define SEGMENT_BITS ((uint64_t)SEGMENT_BYTES * 8)  // Odd numbers per segment
+#define SLAB_SEGMENTS 64                            // Segments claimed by a thread at once
+#define SLAB_BITS (SEGMENT_BITS * SLAB_SEGMENTS)
+#define SLAB_BYTES (SEGMENT_BYTES * SLAB_SEGMENTS)
+#define PRESIEVE_BYTES 15015                        // 3 * 5 * 7 * 11 * 13 bytes = 8 periods of bits
+#define FIRST_SIEVING_PRIME 17
+#define MAX_THREADS 64
+#define SIMPLE_SIEVE_MAX 100000000ULL               // Largest limit for the byte-per-number baseline
+
+typedef void (*prime_callback)(uint64_t prime, void *arg);
+
+typedef struct {
+    uint64_t limit;
+    uint64_t total_bits;    // Odd numbers 1, 3, ..., limit are bits [0, total_bits)
+    uint32_t *primes;       // Sieving primes FIRST_SIEVING_PRIME .. sqrt(limit)
+    size_t prime_count;
+} Sieve;
+
+static unsigned char presieve[PRESIEVE_BYTES];
+
+/*
+ * 15015 is odd, so a pattern of 15015 bits would not start on a byte
+ * boundary the second time round. Eight periods (15015 bytes) do, which
+ * lets every segment, whose first bit is a multiple of 8, copy bytes.
+ * The primes 3..13 clear their own bits too; they are restored in the
+ * first segment.
+ */
+static void build_presieve(void) {
+    static const int wheel[] = { 3, 5, 7, 11, 13 };
+    memset(presieve, 0xFF, sizeof(presieve));
+    for (int w = 0; w < 5; w++) {
+        int p = wheel[w];
+        for (uint64_t j = (p - 1) / 2; j < PRESIEVE_BYTES * 8ULL; j += p)
+            presieve[j >> 3] &= (unsigned char)~(1u << (j & 7));
+    }
+}
+
+static uint64_t isqrt64(uint64_t x) {
+    uint64_t r = (uint64_t)sqrtl((long double)x);
+    while (r * r > x) r--;
+    while ((r + 1) * (r + 1) <= x) r++;
+    return r;
+}
+
+/**
+ * @brief Prepares a sieve up to limit: the odd primes from 17 to
+ * sqrt(limit), found with a small byte-per-odd-number sieve.
+ * @return 0 on success, -1 if memory allocation failed.
+ */
+int sieve_init(Sieve *s, uint64_t limit) {
+    static int presieve_ready = 0;
+    if (!presieve_ready) {
+        build_presieve();
+        presieve_ready = 1;
+    }
+
+    s->limit = limit;
+    s->total_bits = (limit + 1) / 2;
+    s->primes = NULL;
+    s->prime_count = 0;
+
+    uint64_t root = isqrt64(limit);
+    size_t odd = (size_t)(root / 2 + 1);
+    unsigned char *composite = (unsigned char *)calloc(odd, 1);
+    s->primes = (uint32_t *)malloc((odd + 1) * sizeof(uint32_t));
+    if (composite == NULL || s->primes == NULL) {
+        free(composite);
+        free(s->primes);
+        s->primes = NULL;
+        return -1;
+    }
+    for (uint64_t j = 1; j < odd; j++) {
+        if (composite[j]) continue;
+        uint64_t p = 2 * j + 1;
+        if (p >= FIRST_SIEVING_PRIME) s->primes[s->prime_count++] = (uint32_t)p;
+        for (uint64_t k = (p * p) / 2; k < odd; k += p) composite[k] = 1;
+    }
+    free(composite);
+    return 0;
+}
+
+void sieve_free(Sieve *s) {
+    free(s->primes);
+    s->primes = NULL;
+}
+
+/*
+ * Bit index of the first odd multiple of p at or after bit `lo`, starting
+ * from p * p (smaller multiples have a smaller prime factor). Odd
+ * multiples of p are p bits apart.
+ */
+static inline uint64_t first_multiple(uint64_t p, uint64_t lo) {
+    uint64_t start = (p * p) / 2;
+    if (start >= lo) return start;
+    return start + (lo - start + p - 1) / p * p;
+}
+
+/**
+ * Sieves bits [lo, hi) one segment at a time. With keep set, segment k is
+ * written to out + k * SEGMENT_BYTES so the whole range stays available;
+ * otherwise every segment reuses out[0 .. SEGMENT_BYTES). Returns the
+ * number of primes found, including 2 when the range starts at bit 0.
+ */
+static uint64_t sieve_range(const Sieve *s, uint64_t lo, uint64_t hi, uint64_t *next,
+                            unsigned char *out, int keep) {
+    uint64_t count = 0;
+    for (size_t i = 0; i < s->prime_count; i++) next[i] = first_multiple(s->primes[i], lo);
+
+    for (uint64_t seg_lo = lo; seg_lo < hi; seg_lo += SEGMENT_BITS) {
+        uint64_t bits = hi - seg_lo < SEGMENT_BITS ? hi - seg_lo : SEGMENT_BITS;
+        size_t bytes = (size_t)((bits + 7) / 8);
+        unsigned char *seg = keep ? out + (seg_lo - lo) / 8 : out;
+
+        // Wheel: copy the pre-sieved pattern, wrapping around its end
+        size_t offset = (size_t)((seg_lo / 8) % PRESIEVE_BYTES), done = 0;
+        while (done < bytes) {
+            size_t chunk = PRESIEVE_BYTES - offset;
+            if (chunk > bytes - done) chunk = bytes - done;
+            memcpy(seg + done, presieve + offset, chunk);
+            done += chunk;
+            offset = 0;
+        }
+
+        for (size_t i = 0; i < s->prime_count; i++) {
+            uint32_t p = s->primes[i];
+            uint64_t k = next[i] - seg_lo;
+            for (; k < bits; k += p) seg[k >> 3] &= (unsigned char)~(1u << (k & 7));
+            next[i] = seg_lo + k;
+        }
+
+        if (seg_lo == 0) {
+            seg[0] &= (unsigned char)~1u;                   // 1 is not prime
+            static const int small[] = { 3, 5, 7, 11, 13 };
+            for (int w = 0; w < 5; w++) {
+                uint64_t j = small[w] / 2;
+                if (j < bits) seg[j >> 3] |= (unsigned char)(1u << (j & 7));
+            }
+            if (s->limit >= 2) count++;                     // 2, the only even prime
+        }
+
+        // Clear the bits past the limit up to a whole word, then count
+        size_t words = (size_t)((bits + 63) / 64);
+        memset(seg + bytes, 0, words * 8 - bytes);
+        if (bits & 7) seg[bytes - 1] &= (unsigned char)((1u << (bits & 7)) - 1);
+        for (size_t w = 0; w < words; w++) {
+            uint64_t word;
+            memcpy(&word, seg + w * 8, 8);
+            count += (uint64_t)__builtin_popcountll(word);
+        }
+    }
+    return count;
+}
+
+/* Calls emit for every prime in bits [lo, hi), in increasing order.
+ * Reading bytes as 64-bit words keeps bit order on little-endian CPUs. */
+static void emit_range(const Sieve *s, uint64_t lo, uint64_t hi, const unsigned char *bits,
+                       prime_callback emit, void *arg) {
+    if (lo == 0 && s->limit >= 2) emit(2, arg);
+    size_t words = (size_t)((hi - lo + 63) / 64);
+    for (size_t w = 0; w < words; w++) {
+        uint64_t word;
+        memcpy(&word, bits + w * 8, 8);
+        while (word) {
+            uint64_t j = lo + w * 64 + (uint64_t)__builtin_ctzll(word);
+            emit(2 * j + 1, arg);
+            word &= word - 1;
+        }
+    }
+}
+
+/* ---------- Threads ---------- */
+
+typedef struct {
+    const Sieve *sieve;
+    uint64_t slab_count;
+    uint64_t next_slab;         // Counting: next unclaimed slab (atomic)
+    uint64_t round;             // Emitting: thread t sieves slab round * threads + t
+    int threads;
+    int finished;
+    pthread_barrier_t start, done;
+    unsigned char *buffers[MAX_THREADS];
+} SieveShared;
+
+typedef struct {
+    SieveShared *shared;
+    int id;
+    uint64_t count;
+    uint64_t *next;             // Next multiple of every sieving prime
+} SieveWorker;
+
+static void slab_bounds(const SieveShared *sh, uint64_t slab, uint64_t *lo, uint64_t *hi) {
+    *lo = slab * SLAB_BITS;
+    *hi = *lo + SLAB_BITS < sh->sieve->total_bits ? *lo + SLAB_BITS : sh->sieve->total_bits;
+}
+
+void *count_worker(void *p) {
+    SieveWorker *w = (SieveWorker *)p;
+    SieveShared *sh = w->shared;
+    for (;;) {
+        uint64_t slab = __atomic_fetch_add(&sh->next_slab, 1, __ATOMIC_RELAXED);
+        if (slab >= sh->slab_count) break;
+        uint64_t lo, hi;
+        slab_bounds(sh, slab, &lo, &hi);
+        w->count += sieve_range(sh->sieve, lo, hi, w->next, sh->buffers[w->id], 0);
+    }
+    return NULL;
+}
+
+/*
+ * Emitting must stay in order, so it runs in rounds: every worker sieves
+ * one slab into its own buffer, then the calling thread emits the slabs in
+ * order while the workers wait at the start barrier.
+ */
+void *emit_worker(void *p) {
+    SieveWorker *w = (SieveWorker *)p;
+    SieveShared *sh = w->shared;
+    for (;;) {
+        pthread_barrier_wait(&sh->start);
+        if (sh->finished) break;
+        uint64_t slab = sh->round * sh->threads + w->id;
+        if (slab < sh->slab_count) {
+            uint64_t lo, hi;
+            slab_bounds(sh, slab, &lo, &hi);
+            sieve_range(sh->sieve, lo, hi, w->next, sh->buffers[w->id], 1);
+        }
+        pthread_barrier_wait(&sh->done);
+    }
+    return NULL;
+}
+
+/*
+ * Shared driver for counting (emit == NULL) and emitting. Returns pi(limit),
+ * or -1 cast to uint64_t if memory or threads are unavailable.
+ */
+static uint64_t run_sieve(uint64_t limit, int threads, prime_callback emit, void *arg) {
+    if (limit < 2) return 0;
+    if (threads < 1) threads = 1;
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    Sieve sieve;
+    if (sieve_init(&sieve, limit) != 0) return (uint64_t)-1;
+
+    SieveShared sh;
+    memset(&sh, 0, sizeof(sh));
+    sh.sieve = &sieve;
+    sh.slab_count = (sieve.total_bits + SLAB_BITS - 1) / SLAB_BITS;
+    if ((uint64_t)threads > sh.slab_count) threads = (int)sh.slab_count;
+    sh.threads = threads;
+
+    SieveWorker workers[MAX_THREADS];
+    pthread_t tid[MAX_THREADS];
+    int ok = 1;
+    size_t buffer_bytes = (emit ? SLAB_BYTES : SEGMENT_BYTES) + 8;
+    for (int t = 0; t < threads; t++) {
+        workers[t] = (SieveWorker){ &sh, t, 0, (uint64_t *)malloc((sieve.prime_count + 1) * sizeof(uint64_t)) };
+        sh.buffers[t] = (unsigned char *)aligned_alloc(64, (buffer_bytes + 63) / 64 * 64);
+        ok = ok && workers[t].next && sh.buffers[t];
+    }
+
+    uint64_t total = 0;
+    if (ok && !emit) {
+        // Slabs are claimed dynamically, so if a thread fails to start the
+        // others simply take its share
+        int started = 1;
+        while (started < threads &&
+               pthread_create(&tid[started], NULL, count_worker, &workers[started]) == 0)
+            started++;
+        count_worker(&workers[0]);
+        for (int t = 1; t < started; t++) pthread_join(tid[t], NULL);
+        for (int t = 0; t < started; t++) total += workers[t].count;
+    } else if (ok) {
+        ok = pthread_barrier_init(&sh.start, NULL, threads + 1) == 0 &&
+             pthread_barrier_init(&sh.done, NULL, threads + 1) == 0;
+        for (int t = 0; t < threads && ok; t++) {
+            if (pthread_create(&tid[t], NULL, emit_worker, &workers[t]) != 0) {
+                // Started workers would wait at the barrier forever
+                fprintf(stderr, "Error: could not start %d threads.\n", threads);
+                exit(1);
+            }
+        }
+        for (sh.round = 0; ok && sh.round * threads < sh.slab_count; sh.round++) {
+            pthread_barrier_wait(&sh.start);
+            pthread_barrier_wait(&sh.done);
+            for (int t = 0; t < threads; t++) {
+                uint64_t slab = sh.round * threads + t, lo, hi;
+                if (slab >= sh.slab_count) break;
+                slab_bounds(&sh, slab, &lo, &hi);
+                emit_range(&sieve, lo, hi, sh.buffers[t], emit, arg);
+            }
+        }
+        if (ok) {
+            sh.finished = 1;
+            pthread_barrier_wait(&sh.start);
+            for (int t = 0; t < threads; t++) pthread_join(tid[t], NULL);
+            pthread_barrier_destroy(&sh.start);
+            pthread_barrier_destroy(&sh.done);
+        }
+    }
+
+    for (int t = 0; t < threads; t++) {
+        free(workers[t].next);
+        free(sh.buffers[t]);
+    }
+    sieve_free(&sieve);
+    return ok ? total : (uint64_t)-1;
+}
+
+/**
+ * @brief Number of primes <= limit, or (uint64_t)-1 if memory or threads
+ * are unavailable.
+ */
+uint64_t count_primes(uint64_t limit, int threads) {
+    return run_sieve(limit, threads, NULL, NULL);
+}
+
+/**
+ * @brief Calls emit(p, arg) for every prime p <= limit in increasing order.
+ * Sieving runs on `threads` threads; emit is only called from the calling
+ * thread. Returns 0, or -1 if memory or threads are unavailable.
+ */
+int emit_primes(uint64_t limit, int threads, prime_callback emit, void *arg) {
+    return run_sieve(limit, threads, emit, arg) == (uint64_t)-1 ? -1 : 0;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/* The prime_generator.c approach: one byte per integer, no blocking */
+uint64_t simple_sieve_count(uint64_t limit) {
+    unsigned char *is_prime = (unsigned char *)malloc(limit + 1);
+    if (is_prime == NULL) return (uint64_t)-1;
+    memset(is_prime, 1, limit + 1);
+    is_prime[0] = 0;
+    if (limit >= 1) is_prime[1] = 0;
+    for (uint64_t p = 2; p <= limit / p; p++)
+        if (is_prime[p])
+            for (uint64_t i = p * p; i <= limit; i += p) is_prime[i] = 0;
+    uint64_t count = 0;
+    for (uint64_t i = 2; i <= limit; i++) count += is_prime[i];
+    free(is_prime);
+    return count;
+}
+
+/* pi(10^k) for k = 1 .. 13 */
+static const uint64_t known_pi[] = {
+    0, 4, 25, 168, 1229, 9592, 78498, 664579, 5761455, 50847534, 455052511,
+    4118054813ULL, 37607912018ULL, 346065536839ULL,
+};
+
+static void sum_prime(uint64_t p, void *arg) {
+    uint64_t *acc = (uint64_t *)arg;
+    acc[0]++;
+    acc[1] += p;
+}
+
+int run_benchmark(uint64_t max_limit, int threads) {
+    printf("Segments: %d KB, threads: %d\n\n", SEGMENT_BYTES / 1024, threads);
+    printf("%16s %14s %12s %12s %12s %10s\n", "limit", "pi(limit)", "byte ms", "1 thread ms",
+           "threads ms", "expected");
+
+    int failures = 0;
+    uint64_t limit = 10;
+    for (int k = 1; k <= 13 && limit <= max_limit; k++, limit *= 10) {
+        if (k < 6) continue;
+        char simple_text[32] = "-";
+        if (limit <= SIMPLE_SIEVE_MAX) {
+            double t0 = now_seconds();
+            uint64_t simple = simple_sieve_count(limit);
+            snprintf(simple_text, sizeof(simple_text), "%.1f", (now_seconds() - t0) * 1e3);
+            failures += simple != known_pi[k];
+        }
+
+        char single_text[32] = "-";
+        if (threads > 1 && limit <= max_limit / 10) {
+            double t0 = now_seconds();
+            uint64_t single = count_primes(limit, 1);
+            snprintf(single_text, sizeof(single_text), "%.1f", (now_seconds() - t0) * 1e3);
+            failures += single != known_pi[k];
+        }
+
+        double t0 = now_seconds();
+        uint64_t count = count_primes(limit, threads);
+        double t = now_seconds() - t0;
+        if (count == (uint64_t)-1) {
+            printf("%16llu: out of memory or threads, stopping.\n", (unsigned long long)limit);
+            return 1;
+        }
+        int wrong = count != known_pi[k];
+        failures += wrong;
+        printf("%16llu %14llu %12s %12s %12.1f %10s\n", (unsigned long long)limit,
+               (unsigned long long)count, simple_text, single_text, t * 1e3, wrong ? "WRONG" : "ok");
+    }
+
+    // Emitting must produce the same primes in order
+    uint64_t acc[2] = { 0, 0 };
+    double t0 = now_seconds();
+    emit_primes(100000000, threads, sum_prime, acc);
+    printf("\nEmitted the %llu primes up to 10^8 in %.1f ms (sum %llu)\n",
+           (unsigned long long)acc[0], (now_seconds() - t0) * 1e3, (unsigned long long)acc[1]);
+    failures += acc[0] != known_pi[8] || acc[1] != 279209790387276ULL;
+
+    if (failures) {
+        fprintf(stderr, "Error: %d counts were wrong.\n", failures);
+        return 1;
+    }
+    return 0;
+}
+
+/* Buffered printing, ten primes per line as in prime_generator.c */
+typedef struct {
+    uint64_t count;
+} PrintState;
+
+static void print_prime(uint64_t p, void *arg) {
+    PrintState *state = (PrintState *)arg;
+    printf("%llu ", (unsigned long long)p);
+    if (++state->count % 10 == 0) printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+    if (argc > 3) threads = atoi(argv[3]);
+    if (threads < 1 || threads > MAX_THREADS) {
+        fprintf(stderr, "Error: threads must be between 1 and %d.\n", MAX_THREADS);
+        return 1;
+    }
+
+    if (argc == 1 || strcmp(argv[1], "--bench") == 0) {
+        double max_limit = argc > 2 ? atof(argv[2]) : 1e10;
+        if (argc > 2 && (max_limit < 1e6 || max_limit > 1e13)) {
+            fprintf(stderr, "Error: benchmark limit must be between 10^6 and 10^13.\n");
+            return 1;
+        }
+        return run_benchmark((uint64_t)max_limit, threads);
+    }
+
+    if (argc < 3 || (strcmp(argv[1], "count") != 0 && strcmp(argv[1], "print") != 0)) {
+        fprintf(stderr, "Usage: %s [--bench [limit] | count limit [threads] | print limit [threads]]\n",
+                argv[0]);
+        return 1;
+    }
+    double value = atof(argv[2]);
+    if (value < 0 || value > 1.8e19) {
+        fprintf(stderr, "Error: limit out of range.\n");
+        return 1;
+    }
+    uint64_t limit = (uint64_t)value;
+
+    if (strcmp(argv[1], "count") == 0) {
+        double t0 = now_seconds();
+        uint64_t count = count_primes(limit, threads);
+        if (count == (uint64_t)-1) {
+            fprintf(stderr, "Memory allocation failed!\n");
+            return 1;
+        }
+        printf("pi(%llu) = %llu (%.3f s, %d threads)\n", (unsigned long long)limit,
+               (unsigned long long)count, now_seconds() - t0, threads);
+        return 0;
+    }
+
+    static char out_buffer[1 << 16];
+    setvbuf(stdout, out_buffer, _IOFBF, sizeof(out_buffer));
+    printf("Prime numbers up to %llu are:\n", (unsigned long long)limit);
+    PrintState state = { 0 };
+    if (emit_primes(limit, threads, print_prime, &state) != 0) {
+        fprintf(stderr, "Memory allocation failed!\n");
+        return 1;
+    }
+    printf("\n");
+    return 0;
+}
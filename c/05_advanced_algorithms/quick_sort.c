@@ -6,9 +6,45 @@
  * 1. Divide and Conquer strategy
  * 2. Partitioning logic
  * 3. Recursive sorting
+ * 4. Introsort / pattern-defeating quicksort (pdqsort) hardening:
+ *    - median-of-3 pivots, and Tukey's ninther for large ranges
+ *    - three-way handling of duplicates: when the pivot equals the element
+ *      just left of the range, everything equal to it is split off at once
+ *    - insertion sort below a size cutoff
+ *    - heapsort fallback once too many unbalanced partitions were seen,
+ *      which bounds the worst case at O(n log n) and the stack at O(log n)
+ *    - detection of already-partitioned (sorted) ranges
+ * 5. Branchless block partitioning (BlockQuicksort) versus a classic Hoare
+ *    partition
+ * 6. An AVX2 bitonic sorting network as the base case for ranges of up to
+ *    32 elements, chosen at run time (insertion sort without AVX2)
+ *
+ * Usage:
+ * gcc -O2 quick_sort.c -o quick_sort
+ * ./quick_sort                  (sort the example array)
+ * ./quick_sort --bench [n]      (compare with the original version and qsort)
  */
 
+#define _POSIX_C_SOURCE 199309L
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+#define INSERTION_SORT_THRESHOLD 24  // Ranges smaller than this use insertion sort
+#define NETWORK_CUTOFF 32            // With AVX2, ranges up to this use the sorting network
+#define NINTHER_THRESHOLD 128        // Ranges larger than this use the ninther pivot
+#define PARTIAL_INSERTION_LIMIT 8    // Moves allowed before giving up on a sorted run
+#define BLOCK_SIZE 64                // Elements scanned per block in the branchless partition
+#define LEGACY_ADVERSARIAL_MAX 20000 // The original sort is O(n^2) on these inputs
 
 void swap(int* a, int* b) {
     int t = *a;
@@ -16,11 +52,491 @@ void swap(int* a, int* b) {
     *b = t;
 }
 
+/* ---------- Small-range helpers ---------- */
+
+/**
+ * @brief Sorts [begin, end) by insertion.
+ */
+static void insertion_sort(int *begin, int *end) {
+    if (begin == end) return;
+    for (int *cur = begin + 1; cur != end; cur++) {
+        int tmp = *cur;
+        int *sift = cur;
+        while (sift != begin && tmp < sift[-1]) {
+            *sift = sift[-1];
+            sift--;
+        }
+        *sift = tmp;
+    }
+}
+
+/**
+ * @brief Insertion sort without the lower bound check. Only valid when
+ * begin[-1] is no greater than any element in the range, which holds for
+ * every range except the leftmost one.
+ */
+static void unguarded_insertion_sort(int *begin, int *end) {
+    if (begin == end) return;
+    for (int *cur = begin + 1; cur != end; cur++) {
+        int tmp = *cur;
+        int *sift = cur;
+        while (tmp < sift[-1]) {
+            *sift = sift[-1];
+            sift--;
+        }
+        *sift = tmp;
+    }
+}
+
+/**
+ * @brief Attempts an insertion sort but gives up after a few moves.
+ *
+ * @return 1 if the range is now sorted, 0 if it was abandoned
+ */
+static int partial_insertion_sort(int *begin, int *end) {
+    if (begin == end) return 1;
+    size_t moves = 0;
+    for (int *cur = begin + 1; cur != end; cur++) {
+        if (moves > PARTIAL_INSERTION_LIMIT) return 0;
+        int tmp = *cur;
+        int *sift = cur;
+        if (tmp < sift[-1]) {
+            do {
+                *sift = sift[-1];
+                sift--;
+            } while (sift != begin && tmp < sift[-1]);
+            *sift = tmp;
+            moves += cur - sift;
+        }
+    }
+    return 1;
+}
+
+static inline void sort2(int *a, int *b) {
+    if (*b < *a) swap(a, b);
+}
+
+static inline void sort3(int *a, int *b, int *c) {
+    sort2(a, b);
+    sort2(b, c);
+    sort2(a, b);
+}
+
+/* ---------- AVX2 sorting network base case ---------- */
+
+/*
+ * Ranges of up to 32 ints are sorted by the 32-element bitonic network of
+ * sorting_network_simd.c, held in four AVX2 registers and padded with
+ * INT_MAX: a fixed sequence of min/max steps with no data-dependent
+ * branches. Without AVX2 the insertion sorts are used instead.
+ */
+#if HAVE_X86_KERNELS
+
+// Compare-exchange inside a register: p holds each lane's partner, and the
+// lanes set in `upper` keep the maximum
+#define EXCHANGE(v, p, upper) \
+    _mm256_blend_epi32(_mm256_min_epi32(v, p), _mm256_max_epi32(v, p), upper)
+#define REVERSE(v) _mm256_permutevar8x32_epi32(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0))
+#define FLIP2(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0xB1), 0xAA)            // lane ^ 1
+#define FLIP4(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0x1B), 0xCC)            // lane ^ 3
+#define FLIP8(v) EXCHANGE(v, REVERSE(v), 0xF0)                               // lane ^ 7
+#define HALF2(v) EXCHANGE(v, _mm256_shuffle_epi32(v, 0x4E), 0xCC)            // lane ^ 2
+#define HALF4(v) EXCHANGE(v, _mm256_permute2x128_si256(v, v, 1), 0xF0)       // lane ^ 4
+
+// Element i of x against its mirror in y (the reversed partner register)
+#define MIRROR(x, y) do {                                                    \
+        __m256i b_ = REVERSE(y);                                             \
+        y = REVERSE(_mm256_max_epi32(x, b_));                                \
+        x = _mm256_min_epi32(x, b_);                                         \
+    } while (0)
+#define MINMAX(x, y) do {                                                    \
+        __m256i lo_ = _mm256_min_epi32(x, y);                                \
+        y = _mm256_max_epi32(x, y);                                          \
+        x = lo_;                                                             \
+    } while (0)
+
+/**
+ * @brief Sorts a[0..n), n <= 32. Each merge stage k compares element i
+ * with its mirror i ^ (k - 1), then runs half-cleaners at k/4 .. 1.
+ */
+__attribute__((target("avx2")))
+static void network_sort(int *a, size_t n) {
+    int buf[32];
+    memcpy(buf, a, n * sizeof(int));
+    for (size_t i = n; i < 32; i++) buf[i] = INT_MAX;   // Sorts to the end
+    __m256i v[4];
+    for (int r = 0; r < 4; r++) v[r] = _mm256_loadu_si256((const __m256i *)(buf + 8 * r));
+
+    for (int r = 0; r < 4; r++) {
+        v[r] = FLIP2(v[r]);                                 // k = 2
+        v[r] = FLIP2(FLIP4(v[r]));                          // k = 4
+        v[r] = FLIP2(HALF2(FLIP8(v[r])));                   // k = 8
+    }
+    MIRROR(v[0], v[1]);                                     // k = 16
+    MIRROR(v[2], v[3]);
+    for (int r = 0; r < 4; r++) v[r] = FLIP2(HALF2(HALF4(v[r])));
+    MIRROR(v[0], v[3]);                                     // k = 32
+    MIRROR(v[1], v[2]);
+    MINMAX(v[0], v[1]);
+    MINMAX(v[2], v[3]);
+    for (int r = 0; r < 4; r++) v[r] = FLIP2(HALF2(HALF4(v[r])));
+
+    for (int r = 0; r < 4; r++) _mm256_storeu_si256((__m256i *)(buf + 8 * r), v[r]);
+    memcpy(a, buf, n * sizeof(int));
+}
+
+#else
+
+static void network_sort(int *a, size_t n) { insertion_sort(a, a + n); }
+
+#endif
+
+// -1 until the CPU has been checked; set_network_base_case() overrides it
+static int use_network = -1;
+
+static int network_enabled(void) {
+    if (use_network < 0) {
+#if HAVE_X86_KERNELS
+        __builtin_cpu_init();
+        use_network = __builtin_cpu_supports("avx2");
+#else
+        use_network = 0;
+#endif
+    }
+    return use_network;
+}
+
+/**
+ * @brief Turns the network base case off (0) or back on where AVX2 exists (1).
+ * @return 1 if the network is in use afterwards.
+ */
+int set_network_base_case(int enable) {
+    use_network = -1;
+    if (!enable) use_network = 0;
+    return network_enabled();
+}
+
+/* ---------- Heapsort fallback ---------- */
+
+static void sift_down(int *heap, size_t size, size_t root) {
+    int value = heap[root];
+    for (size_t child; (child = 2 * root + 1) < size; root = child) {
+        if (child + 1 < size && heap[child] < heap[child + 1]) child++;
+        if (!(value < heap[child])) break;
+        heap[root] = heap[child];
+    }
+    heap[root] = value;
+}
+
+static void heap_sort(int *begin, int *end) {
+    size_t size = end - begin;
+    for (size_t i = size / 2; i-- > 0;) sift_down(begin, size, i);
+    for (size_t last = size; last-- > 1;) {
+        swap(&begin[0], &begin[last]);
+        sift_down(begin, last, 0);
+    }
+}
+
+/* ---------- Partitioning ---------- */
+
+/**
+ * @brief Partitions [begin, end) around the pivot *begin so that elements
+ * smaller than the pivot come first. Elements equal to it go right.
+ *
+ * @param already_partitioned Set to 1 if no element had to be moved
+ * @return Final position of the pivot
+ */
+static int *partition_right(int *begin, int *end, int *already_partitioned) {
+    int pivot = *begin;
+    int *first = begin, *last = end;
+
+    // The median-of-3 guarantees an element >= pivot on the right and one
+    // <= pivot on the left, so these scans need no bounds checks
+    while (*++first < pivot);
+    if (first - 1 == begin)
+        while (first < last && !(*--last < pivot));
+    else
+        while (!(*--last < pivot));
+
+    *already_partitioned = first >= last;
+    while (first < last) {
+        swap(first, last);
+        while (*++first < pivot);
+        while (!(*--last < pivot));
+    }
+
+    int *pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+/**
+ * @brief Swaps the elements named by two offset buffers.
+ *
+ * When the counts are unequal a cyclic permutation (one temporary, two
+ * moves per pair) replaces the swaps. Equal counts keep real swaps, which
+ * descending inputs need to stay O(n) per pass.
+ */
+static void swap_offsets(int *first, int *last, const unsigned char *offsets_l,
+                         const unsigned char *offsets_r, size_t num, int use_swaps) {
+    if (use_swaps) {
+        for (size_t i = 0; i < num; i++)
+            swap(first + offsets_l[i], last - offsets_r[i]);
+    } else if (num > 0) {
+        int *l = first + offsets_l[0], *r = last - offsets_r[0];
+        int tmp = *l;
+        *l = *r;
+        for (size_t i = 1; i < num; i++) {
+            l = first + offsets_l[i];
+            *r = *l;
+            r = last - offsets_r[i];
+            *l = *r;
+        }
+        *r = tmp;
+    }
+}
+
+/**
+ * @brief Same contract as partition_right, without data-dependent branches
+ * in the scan.
+ *
+ * Following BlockQuicksort (Edelkamp and Weiss), each side scans a block of
+ * BLOCK_SIZE elements and records the offsets of misplaced ones: the
+ * comparison result is added to the counter instead of being branched on.
+ * Recorded pairs are then swapped. On random data this removes the ~50%
+ * misprediction rate of the Hoare scans.
+ */
+static int *partition_right_branchless(int *begin, int *end, int *already_partitioned) {
+    int pivot = *begin;
+    int *first = begin, *last = end;
+
+    while (*++first < pivot);
+    if (first - 1 == begin)
+        while (first < last && !(*--last < pivot));
+    else
+        while (!(*--last < pivot));
+
+    *already_partitioned = first >= last;
+    if (!*already_partitioned) {
+        swap(first, last);
+        first++;
+
+        unsigned char offsets_l[BLOCK_SIZE], offsets_r[BLOCK_SIZE];
+        int *offsets_l_base = first, *offsets_r_base = last;
+        size_t num_l = 0, num_r = 0, start_l = 0, start_r = 0;
+
+        while (first < last) {
+            // Refill whichever offset buffer is empty; split the unknown
+            // middle between them when both are
+            size_t num_unknown = last - first;
+            size_t left_split = num_l == 0 ? (num_r == 0 ? num_unknown / 2 : num_unknown) : 0;
+            size_t right_split = num_r == 0 ? num_unknown - left_split : 0;
+
+            if (left_split > BLOCK_SIZE) left_split = BLOCK_SIZE;
+            if (right_split > BLOCK_SIZE) right_split = BLOCK_SIZE;
+
+            for (size_t i = 0; i < left_split; i++) {
+                offsets_l[num_l] = (unsigned char)i;
+                num_l += !(*first < pivot);
+                first++;
+            }
+            for (size_t i = 0; i < right_split;) {
+                offsets_r[num_r] = (unsigned char)++i;
+                num_r += *--last < pivot;
+            }
+
+            size_t num = num_l < num_r ? num_l : num_r;
+            swap_offsets(offsets_l_base, offsets_r_base, offsets_l + start_l,
+                         offsets_r + start_r, num, num_l == num_r);
+            num_l -= num;
+            num_r -= num;
+            start_l += num;
+            start_r += num;
+
+            if (num_l == 0) {
+                start_l = 0;
+                offsets_l_base = first;
+            }
+            if (num_r == 0) {
+                start_r = 0;
+                offsets_r_base = last;
+            }
+        }
+
+        // At most one buffer still holds misplaced elements; move them to
+        // the boundary
+        if (num_l) {
+            while (num_l--) swap(offsets_l_base + offsets_l[start_l + num_l], --last);
+            first = last;
+        }
+        if (num_r) {
+            while (num_r--) {
+                swap(offsets_r_base - offsets_r[start_r + num_r], first);
+                first++;
+            }
+        }
+    }
+
+    int *pivot_pos = first - 1;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+/**
+ * @brief Partitions [begin, end) so that elements equal to the pivot *begin
+ * come first. Used when the caller knows no element is smaller than the
+ * pivot, so the left part is exactly the run of pivot-equal elements.
+ *
+ * @return Final position of the pivot (the last equal element)
+ */
+static int *partition_left(int *begin, int *end) {
+    int pivot = *begin;
+    int *first = begin, *last = end;
+
+    while (pivot < *--last);
+    if (last + 1 == end)
+        while (first < last && !(pivot < *++first));
+    else
+        while (!(pivot < *++first));
+
+    while (first < last) {
+        swap(first, last);
+        while (pivot < *--last);
+        while (!(pivot < *++first));
+    }
+
+    int *pivot_pos = last;
+    *begin = *pivot_pos;
+    *pivot_pos = pivot;
+    return pivot_pos;
+}
+
+/* ---------- Sort engine ---------- */
+
+/**
+ * @brief Sorts [begin, end).
+ *
+ * @param bad_allowed Unbalanced partitions tolerated before switching to heapsort
+ * @param leftmost 1 if begin is the start of the whole array (no sentinel at begin[-1])
+ * @param branchless 1 to use the block partition, 0 for the Hoare partition
+ */
+static void introsort_loop(int *begin, int *end, int bad_allowed, int leftmost, int branchless) {
+    while (1) {
+        size_t size = end - begin;
+        if (size <= NETWORK_CUTOFF && network_enabled()) {
+            network_sort(begin, size);
+            return;
+        }
+        if (size < INSERTION_SORT_THRESHOLD) {
+            if (leftmost) insertion_sort(begin, end);
+            else unguarded_insertion_sort(begin, end);
+            return;
+        }
+
+        // Move the pivot candidate to *begin
+        size_t s2 = size / 2;
+        if (size > NINTHER_THRESHOLD) {
+            sort3(begin, begin + s2, end - 1);
+            sort3(begin + 1, begin + (s2 - 1), end - 2);
+            sort3(begin + 2, begin + (s2 + 1), end - 3);
+            sort3(begin + (s2 - 1), begin + s2, begin + (s2 + 1));
+            swap(begin, begin + s2);
+        } else {
+            sort3(begin + s2, begin, end - 1);
+        }
+
+        // begin[-1] is the pivot of an earlier partition and so no larger
+        // than anything here. If it equals this pivot, the range has many
+        // copies of it: split them all off and keep sorting the rest
+        if (!leftmost && !(begin[-1] < *begin)) {
+            begin = partition_left(begin, end) + 1;
+            continue;
+        }
+
+        int already_partitioned;
+        int *pivot_pos = branchless ? partition_right_branchless(begin, end, &already_partitioned)
+                                    : partition_right(begin, end, &already_partitioned);
+
+        size_t l_size = pivot_pos - begin;
+        size_t r_size = end - (pivot_pos + 1);
+        int highly_unbalanced = l_size < size / 8 || r_size < size / 8;
+
+        if (highly_unbalanced) {
+            if (--bad_allowed == 0) {
+                heap_sort(begin, end);
+                return;
+            }
+
+            // Shuffle a few elements to break patterns that defeat the pivot rule
+            if (l_size >= INSERTION_SORT_THRESHOLD) {
+                swap(begin, begin + l_size / 4);
+                swap(pivot_pos - 1, pivot_pos - l_size / 4);
+                if (l_size > NINTHER_THRESHOLD) {
+                    swap(begin + 1, begin + (l_size / 4 + 1));
+                    swap(begin + 2, begin + (l_size / 4 + 2));
+                    swap(pivot_pos - 2, pivot_pos - (l_size / 4 + 1));
+                    swap(pivot_pos - 3, pivot_pos - (l_size / 4 + 2));
+                }
+            }
+            if (r_size >= INSERTION_SORT_THRESHOLD) {
+                swap(pivot_pos + 1, pivot_pos + (1 + r_size / 4));
+                swap(end - 1, end - r_size / 4);
+                if (r_size > NINTHER_THRESHOLD) {
+                    swap(pivot_pos + 2, pivot_pos + (2 + r_size / 4));
+                    swap(pivot_pos + 3, pivot_pos + (3 + r_size / 4));
+                    swap(end - 2, end - (1 + r_size / 4));
+                    swap(end - 3, end - (2 + r_size / 4));
+                }
+            }
+        } else if (already_partitioned
+                   && partial_insertion_sort(begin, pivot_pos)
+                   && partial_insertion_sort(pivot_pos + 1, end)) {
+            // A balanced partition that moved nothing usually means the
+            // range was sorted already
+            return;
+        }
+
+        // Recurse into the left part, loop on the right part
+        introsort_loop(begin, pivot_pos, bad_allowed, leftmost, branchless);
+        begin = pivot_pos + 1;
+        leftmost = 0;
+    }
+}
+
+static int floor_log2(size_t n) {
+    int log = 0;
+    while (n >>= 1) log++;
+    return log;
+}
+
+/**
+ * @brief Sorts n ints in ascending order.
+ *
+ * @param branchless 1 for the block partition, 0 for the Hoare partition
+ */
+void introsort(int *arr, size_t n, int branchless) {
+    if (n < 2) return;
+    introsort_loop(arr, arr + n, floor_log2(n), 1, branchless);
+}
+
+/**
+ * @brief The main function that implements QuickSort.
+ * Sorts arr[low..high] (inclusive bounds).
+ */
+void quick_sort(int arr[], int low, int high) {
+    if (low < high)
+        introsort(arr + low, (size_t)(high - low) + 1, 1);
+}
+
+/* ---------- Original version, kept for comparison ---------- */
+
 /**
  * @brief Partitions the array around a pivot.
  * This implementation takes last element as pivot.
  */
-int partition(int arr[], int low, int high) {
+int legacy_partition(int arr[], int low, int high) {
     int pivot = arr[high]; // pivot
     int i = (low - 1); // Index of smaller element
 
@@ -35,19 +551,11 @@ int partition(int arr[], int low, int high) {
     return (i + 1);
 }
 
-/**
- * @brief The main function that implements QuickSort.
- */
-void quick_sort(int arr[], int low, int high) {
+void legacy_quick_sort(int arr[], int low, int high) {
     if (low < high) {
-        /* pi is partitioning index, arr[p] is now
-           at right place */
-        int pi = partition(arr, low, high);
-
-        // Separately sort elements before
-        // partition and after partition
-        quick_sort(arr, low, pi - 1);
-        quick_sort(arr, pi + 1, high);
+        int pi = legacy_partition(arr, low, high);
+        legacy_quick_sort(arr, low, pi - 1);
+        legacy_quick_sort(arr, pi + 1, high);
     }
 }
 
@@ -58,15 +566,133 @@ void print_array(int arr[], int size) {
     printf("\n");
 }
 
-int main() {
+/* ---------- Benchmark ---------- */
+
+typedef enum { INPUT_RANDOM, INPUT_SORTED, INPUT_REVERSED, INPUT_FEW_UNIQUE,
+               INPUT_ORGAN_PIPE, INPUT_COUNT } InputKind;
+
+const char *input_names[INPUT_COUNT] = { "random", "sorted", "reversed", "few unique",
+                                         "organ pipe" };
+
+void fill_input(int *arr, size_t n, InputKind kind) {
+    unsigned long long s = 88172645463325252ULL;
+    for (size_t i = 0; i < n; i++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        switch (kind) {
+        case INPUT_RANDOM:     arr[i] = (int)(s >> 32); break;
+        case INPUT_SORTED:     arr[i] = (int)i; break;
+        case INPUT_REVERSED:   arr[i] = (int)(n - i); break;
+        case INPUT_FEW_UNIQUE: arr[i] = (int)(s % 16); break;
+        default:               arr[i] = (int)(i < n / 2 ? i : n - i); break;
+        }
+    }
+}
+
+int compare_ints(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef enum {
+    SORTER_LEGACY, SORTER_QSORT, SORTER_HOARE, SORTER_BLOCK, SORTER_NETWORK, SORTER_COUNT
+} Sorter;
+
+const char *sorter_names[SORTER_COUNT] = { "original", "qsort", "introsort", "branchless",
+                                           "+network" };
+
+/**
+ * @brief Sorts a copy of `input` with one sorter and returns milliseconds,
+ * or a negative value if the sorter was skipped. The result must equal
+ * `expected`.
+ */
+double time_sorter(Sorter sorter, const int *input, int *work, const int *expected,
+                   size_t n, InputKind kind, int *mismatch) {
+    if (sorter == SORTER_LEGACY && kind != INPUT_RANDOM && n > LEGACY_ADVERSARIAL_MAX)
+        return -1.0;
+
+    // Only the last column uses the network base case
+    if (!set_network_base_case(sorter == SORTER_NETWORK) && sorter == SORTER_NETWORK)
+        return -1.0;
+
+    memcpy(work, input, n * sizeof(int));
+    double t0 = now_seconds();
+    switch (sorter) {
+    case SORTER_LEGACY: legacy_quick_sort(work, 0, (int)n - 1); break;
+    case SORTER_QSORT:  qsort(work, n, sizeof(int), compare_ints); break;
+    case SORTER_HOARE:  introsort(work, n, 0); break;
+    default:            introsort(work, n, 1); break;
+    }
+    double ms = (now_seconds() - t0) * 1e3;
+
+    if (expected && memcmp(work, expected, n * sizeof(int)) != 0) *mismatch = 1;
+    return ms;
+}
+
+int run_benchmark(size_t n) {
+    int *input = (int *)malloc(n * sizeof(int));
+    int *work = (int *)malloc(n * sizeof(int));
+    int *expected = (int *)malloc(n * sizeof(int));
+    if (!input || !work || !expected) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 1;
+    }
+
+    printf("n = %zu, times in ms (original skipped on ordered inputs above %d;\n"
+           "+network is branchless with the AVX2 network base case, skipped without AVX2)\n",
+           n, LEGACY_ADVERSARIAL_MAX);
+    printf("%-12s", "input");
+    for (int s = 0; s < SORTER_COUNT; s++) printf(" %12s", sorter_names[s]);
+    printf("\n");
+
+    int mismatch = 0;
+    for (int kind = 0; kind < INPUT_COUNT; kind++) {
+        fill_input(input, n, (InputKind)kind);
+        memcpy(expected, input, n * sizeof(int));
+        qsort(expected, n, sizeof(int), compare_ints);
+
+        printf("%-12s", input_names[kind]);
+        for (int s = 0; s < SORTER_COUNT; s++) {
+            double ms = time_sorter((Sorter)s, input, work, expected, n, (InputKind)kind, &mismatch);
+            if (ms < 0) printf(" %12s", "(skipped)");
+            else printf(" %12.2f", ms);
+        }
+        printf("\n");
+    }
+
+    free(input);
+    free(work);
+    free(expected);
+    if (mismatch) {
+        fprintf(stderr, "Error: a sorter produced output different from qsort.\n");
+        return 1;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc > 1 && strcmp(argv[1], "--bench") == 0) {
+        long n = argc > 2 ? atol(argv[2]) : 1000000;
+        if (n <= 0) {
+            fprintf(stderr, "Error: size must be positive.\n");
+            return 1;
+        }
+        return run_benchmark((size_t)n);
+    }
+
     int arr[] = {10, 7, 8, 9, 1, 5};
     int n = sizeof(arr) / sizeof(arr[0]);
-    
+
     printf("Original array: \n");
     print_array(arr, n);
-    
+
     quick_sort(arr, 0, n - 1);
-    
+
     printf("Sorted array: \n");
     print_array(arr, n);
     return 0;
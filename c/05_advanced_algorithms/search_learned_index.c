@@ -0,0 +1,500 @@
+/**
+ * @file search_learned_index.c
+ * @brief Learned index: a radix spline predicts where a key lies in a
+ *        sorted array, and a short bounded search finishes the lookup.
+ *
+ * This program demonstrates:
+ * 1. Fitting a piecewise-linear model of the key -> position function (the
+ *    CDF of the keys) with a guaranteed maximum error, using the greedy
+ *    spline corridor algorithm in a single pass over the keys
+ * 2. A radix table over the top bits of the key that narrows the search
+ *    for the right spline segment to a few entries
+ * 3. Replacing a full log2(n) binary search with interpolation plus a
+ *    branchless search inside a window of 2 * error + 3 positions
+ * 4. How the model size depends on the key distribution: uniform,
+ *    lognormal and clustered keys
+ * 5. Comparing lookups per second with a plain branchy binary search and a
+ *    prefetching Eytzinger-layout search (see search_eytzinger.c)
+ *
+ * With distinct keys every lower_bound lies inside the window. Long runs
+ * of duplicates can push the answer outside it; the lookup detects that
+ * and falls back to a galloping search, counted in the "fallback" column.
+ *
+ * Usage:
+ * gcc -O2 search_learned_index.c -o search_learned_index -lm
+ * ./search_learned_index               (benchmark n = 10^6 .. 10^7)
+ * ./search_learned_index 100000000     (go up to 10^8 keys; needs about 3 GB of RAM)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <time.h>
+
+#define SPLINE_ERROR 32         // Maximum distance between predicted and true position
+#define RADIX_TABLE_BITS 18     // Top key bits indexed by the radix table
+#define QUERY_COUNT 2000000     // Lookups timed per method
+
+/* ---------- Baselines ---------- */
+
+/**
+ * @brief Plain binary search: index of the first key >= x, or n.
+ */
+size_t plain_lower_bound(const uint64_t *a, size_t n, uint64_t x) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (a[mid] < x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* Branchless lower_bound, used both as the reference and inside the window */
+static inline size_t branchless_lower_bound(const uint64_t *a, size_t n, uint64_t x) {
+    if (n == 0) return 0;
+    const uint64_t *base = a;
+    while (n > 1) {
+        size_t half = n / 2;
+        base += half & -(size_t)(base[half - 1] < x);
+        n -= half;
+    }
+    return (size_t)(base - a) + (*base < x);
+}
+
+typedef struct {
+    uint64_t *keys;     // keys[1..n] in BFS order
+    size_t n;
+    int levels;
+} Eytzinger;
+
+static size_t eytzinger_fill(const uint64_t *sorted, uint64_t *keys, size_t i, size_t k, size_t n) {
+    if (k <= n) {
+        i = eytzinger_fill(sorted, keys, i, 2 * k, n);
+        keys[k] = sorted[i++];
+        i = eytzinger_fill(sorted, keys, i, 2 * k + 1, n);
+    }
+    return i;
+}
+
+int eytzinger_build(Eytzinger *e, const uint64_t *sorted, size_t n) {
+    size_t bytes = ((n + 1) * sizeof(uint64_t) + 63) / 64 * 64;
+    e->keys = (uint64_t *)aligned_alloc(64, bytes);
+    if (!e->keys) return -1;
+    e->keys[0] = 0;
+    e->n = n;
+    e->levels = n ? 64 - __builtin_clzll(n) : 0;
+    eytzinger_fill(sorted, e->keys, 0, 1, n);
+    return 0;
+}
+
+/* Slot of the first key >= x, or 0; eight 8-byte keys per line, so the
+ * prefetch reaches three levels ahead. */
+size_t eytzinger_lower_bound(const Eytzinger *e, uint64_t x) {
+    const uint64_t *keys = e->keys;
+    size_t k = 1;
+    if (e->levels == 0) return 0;
+    for (int level = 1; level < e->levels; level++) {
+        __builtin_prefetch(keys + k * 8);
+        k = 2 * k + (keys[k] < x);
+    }
+    size_t safe = k <= e->n ? k : 0;
+    k = 2 * k + ((k > e->n) | (keys[safe] < x));
+    return k >> __builtin_ffsll(~(long long)k);
+}
+
+/* ---------- Radix spline ---------- */
+
+typedef struct {
+    uint64_t key;
+    double pos;
+} SplinePoint;
+
+typedef struct {
+    const uint64_t *keys;   // The indexed sorted array (not owned)
+    size_t n;
+    SplinePoint *points;
+    size_t point_count;
+    uint32_t *radix;        // radix[b] = first spline point whose prefix is >= b
+    int shift;              // prefix = (key - min_key) >> shift
+    uint64_t min_key, max_key;
+    long long fallbacks;    // Lookups whose answer was outside the window
+} RadixSpline;
+
+/* Orientation of (b - a) x (c - a): > 0 when c is left of the line a -> b */
+static inline double cross(uint64_t ax, double ay, uint64_t bx, double by, uint64_t cx, double cy) {
+    return (double)(bx - ax) * (cy - ay) - (by - ay) * (double)(cx - ax);
+}
+
+/**
+ * @brief Fits the spline and builds the radix table.
+ * @return 0 on success, -1 if memory allocation failed.
+ *
+ * Greedy spline corridor: from the last spline point, keep the narrowest
+ * cone of slopes that passes within SPLINE_ERROR of every point seen so
+ * far. When the next point leaves the cone, the previous point becomes a
+ * spline point and a new cone starts there. Each key contributes the
+ * position of its first occurrence, which is what lower_bound returns.
+ */
+int spline_build(RadixSpline *s, const uint64_t *keys, size_t n) {
+    memset(s, 0, sizeof(*s));
+    s->keys = keys;
+    s->n = n;
+    if (n == 0) return 0;
+    s->min_key = keys[0];
+    s->max_key = keys[n - 1];
+
+    size_t capacity = 1024;
+    s->points = (SplinePoint *)malloc(capacity * sizeof(SplinePoint));
+    if (!s->points) return -1;
+
+    SplinePoint base = { keys[0], 0.0 }, prev = base;
+    uint64_t upper_x = 0, lower_x = 0;
+    double upper_y = 0, lower_y = 0;
+    int have_cone = 0;
+    s->points[s->point_count++] = base;
+
+    for (size_t i = 1; i <= n; i++) {
+        if (i < n && keys[i] == keys[i - 1]) continue;
+        // After the last key, the point (max_key + 1, n) lets queries past the
+        // last distinct key predict the end of its run of duplicates.
+        SplinePoint p = i < n ? (SplinePoint){ keys[i], (double)i }
+                              : (SplinePoint){ keys[n - 1] + 1, (double)n };
+        if (i == n && keys[n - 1] == UINT64_MAX) break;
+
+        if (!have_cone) {
+            upper_x = lower_x = p.key;
+            upper_y = p.pos + SPLINE_ERROR;
+            lower_y = p.pos - SPLINE_ERROR;
+            have_cone = 1;
+        } else if (cross(base.key, base.pos, upper_x, upper_y, p.key, p.pos) > 0 ||
+                   cross(base.key, base.pos, lower_x, lower_y, p.key, p.pos) < 0) {
+            // p is outside the cone: close the segment at prev
+            if (s->point_count == capacity) {
+                capacity *= 2;
+                SplinePoint *grown = (SplinePoint *)realloc(s->points, capacity * sizeof(SplinePoint));
+                if (!grown) return -1;
+                s->points = grown;
+            }
+            s->points[s->point_count++] = prev;
+            base = prev;
+            upper_x = lower_x = p.key;
+            upper_y = p.pos + SPLINE_ERROR;
+            lower_y = p.pos - SPLINE_ERROR;
+        } else {
+            // Narrow the cone to the tighter of the old and new limits
+            if (cross(base.key, base.pos, upper_x, upper_y, p.key, p.pos + SPLINE_ERROR) < 0) {
+                upper_x = p.key;
+                upper_y = p.pos + SPLINE_ERROR;
+            }
+            if (cross(base.key, base.pos, lower_x, lower_y, p.key, p.pos - SPLINE_ERROR) > 0) {
+                lower_x = p.key;
+                lower_y = p.pos - SPLINE_ERROR;
+            }
+        }
+        prev = p;
+    }
+    if (prev.key != base.key) {
+        if (s->point_count == capacity) {
+            SplinePoint *grown = (SplinePoint *)realloc(s->points, (capacity + 1) * sizeof(SplinePoint));
+            if (!grown) return -1;
+            s->points = grown;
+        }
+        s->points[s->point_count++] = prev;
+    }
+
+    // Radix table over the top bits of (key - min_key): about two slots per
+    // spline point, at most RADIX_TABLE_BITS, so the table stays cache-sized
+    uint64_t range = s->points[s->point_count - 1].key - s->min_key;
+    int bits = range ? 64 - __builtin_clzll(range) : 1;
+    int table_bits = 66 - __builtin_clzll(s->point_count);
+    if (table_bits > RADIX_TABLE_BITS) table_bits = RADIX_TABLE_BITS;
+    s->shift = bits > table_bits ? bits - table_bits : 0;
+    size_t slots = (size_t)(range >> s->shift) + 2;
+    s->radix = (uint32_t *)malloc(slots * sizeof(uint32_t));
+    if (!s->radix) return -1;
+    size_t b = 0;
+    for (size_t i = 0; i < s->point_count; i++) {
+        size_t prefix = (size_t)((s->points[i].key - s->min_key) >> s->shift);
+        while (b <= prefix) s->radix[b++] = (uint32_t)i;
+    }
+    while (b < slots) s->radix[b++] = (uint32_t)s->point_count;
+    return 0;
+}
+
+void spline_free(RadixSpline *s) {
+    free(s->points);
+    free(s->radix);
+    s->points = NULL;
+    s->radix = NULL;
+}
+
+size_t spline_bytes(const RadixSpline *s) {
+    uint64_t range = s->n ? s->points[s->point_count - 1].key - s->min_key : 0;
+    return s->point_count * sizeof(SplinePoint) + ((range >> s->shift) + 2) * sizeof(uint32_t);
+}
+
+/**
+ * @brief Predicted position of x; within SPLINE_ERROR of the position of
+ * any stored key.
+ */
+static inline double spline_predict(const RadixSpline *s, uint64_t x) {
+    size_t prefix = (size_t)((x - s->min_key) >> s->shift);
+    // Segment [i - 1, i] with points[i - 1].key <= x < points[i].key;
+    // the radix table bounds i to the points sharing x's prefix
+    size_t lo = s->radix[prefix], hi = s->radix[prefix + 1];
+    const SplinePoint *p = s->points;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (p[mid].key <= x)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    if (lo == 0) return 0.0;
+    if (lo >= s->point_count) return p[s->point_count - 1].pos;
+    const SplinePoint *a = &p[lo - 1], *b = &p[lo];
+    return a->pos + (double)(x - a->key) * (b->pos - a->pos) / (double)(b->key - a->key);
+}
+
+/**
+ * @brief Index of the first key >= x, or n if there is none.
+ */
+size_t spline_lower_bound(RadixSpline *s, uint64_t x) {
+    const uint64_t *keys = s->keys;
+    size_t n = s->n;
+    if (n == 0 || x <= s->min_key) return 0;
+    if (x > s->max_key) return n;
+
+    double predicted = spline_predict(s, x);
+    size_t lo = predicted > SPLINE_ERROR + 1 ? (size_t)(predicted - SPLINE_ERROR - 1) : 0;
+    size_t hi = (size_t)(predicted + SPLINE_ERROR + 2);
+    if (hi > n) hi = n;
+    if (lo > hi) lo = hi;
+    // The window spans about nine cache lines; requesting them all up front
+    // overlaps their misses instead of taking one per search step
+    for (size_t i = lo; i < hi; i += 8) __builtin_prefetch(keys + i);
+    size_t index = lo + branchless_lower_bound(keys + lo, hi - lo, x);
+
+    // The window missed: gallop outwards, then search the bracketed range
+    if ((index == lo && lo > 0 && keys[lo - 1] >= x) || (index == hi && hi < n && keys[hi] < x)) {
+        s->fallbacks++;
+        size_t step = 2 * SPLINE_ERROR;
+        if (index == lo) {
+            while (lo > 0 && keys[lo - 1] >= x) {
+                hi = lo;
+                lo = lo > step ? lo - step : 0;
+                step *= 2;
+            }
+        } else {
+            while (hi < n && keys[hi] < x) {
+                lo = hi;
+                hi = n - hi > step ? hi + step : n;
+                step *= 2;
+            }
+        }
+        index = lo + branchless_lower_bound(keys + lo, hi - lo, x);
+    }
+    return index;
+}
+
+/* ---------- Key distributions ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+/* Uniform in (0, 1) */
+static inline double random_unit(uint64_t *s) {
+    return ((next_random(s) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+/* Standard normal via Box-Muller */
+static inline double random_normal(uint64_t *s) {
+    return sqrt(-2.0 * log(random_unit(s))) * cos(6.283185307179586 * random_unit(s));
+}
+
+/* LSD radix sort with 16-bit digits, to sort generated keys quickly */
+int sort_keys(uint64_t *a, size_t n) {
+    uint64_t *tmp = (uint64_t *)malloc(n * sizeof(uint64_t));
+    size_t *count = (size_t *)malloc(65536 * sizeof(size_t));
+    if (!tmp || !count) {
+        free(tmp);
+        free(count);
+        return -1;
+    }
+    uint64_t *src = a, *dst = tmp;
+    for (int shift = 0; shift < 64; shift += 16) {
+        memset(count, 0, 65536 * sizeof(size_t));
+        for (size_t i = 0; i < n; i++) count[(src[i] >> shift) & 0xFFFF]++;
+        size_t sum = 0;
+        for (int d = 0; d < 65536; d++) {
+            size_t c = count[d];
+            count[d] = sum;
+            sum += c;
+        }
+        for (size_t i = 0; i < n; i++) dst[count[(src[i] >> shift) & 0xFFFF]++] = src[i];
+        uint64_t *t = src;
+        src = dst;
+        dst = t;
+    }
+    // Four passes leave the result back in a
+    free(tmp);
+    free(count);
+    return 0;
+}
+
+typedef enum { DIST_UNIFORM, DIST_LOGNORMAL, DIST_CLUSTERED, DIST_COUNT } Distribution;
+
+static const char *dist_names[DIST_COUNT] = { "uniform", "lognormal", "clustered" };
+
+#define CLUSTER_COUNT 1000
+
+void generate_keys(uint64_t *keys, size_t n, Distribution dist, uint64_t seed) {
+    uint64_t r = seed;
+    uint64_t centers[CLUSTER_COUNT];
+    for (int c = 0; c < CLUSTER_COUNT; c++) centers[c] = next_random(&r) >> 16;
+
+    for (size_t i = 0; i < n; i++) {
+        switch (dist) {
+        case DIST_UNIFORM:
+            keys[i] = next_random(&r) >> 16;                        // [0, 2^48)
+            break;
+        case DIST_LOGNORMAL:
+            keys[i] = (uint64_t)(1e6 * exp(2.0 * random_normal(&r))); // mu = 0, sigma = 2
+            break;
+        default: {
+            // Tight normal clusters around random centres
+            double offset = 1e5 * random_normal(&r);
+            uint64_t c = centers[next_random(&r) % CLUSTER_COUNT];
+            keys[i] = offset < 0 && (double)c < -offset ? 0 : (uint64_t)((double)c + offset);
+            break;
+        }
+        }
+    }
+}
+
+/* ---------- Benchmark ---------- */
+
+/**
+ * @brief Times the three searches on one distribution.
+ * @return -1 if memory ran out, otherwise the number of methods whose
+ * answers disagreed with the reference search.
+ */
+int bench(size_t n, Distribution dist) {
+    uint64_t *keys = (uint64_t *)malloc(n * sizeof(uint64_t));
+    uint64_t *queries = (uint64_t *)malloc(QUERY_COUNT * sizeof(uint64_t));
+    if (!keys || !queries) {
+        free(keys);
+        free(queries);
+        return -1;
+    }
+    generate_keys(keys, n, dist, 88172645463325252ull + dist);
+    if (sort_keys(keys, n) != 0) {
+        free(keys);
+        free(queries);
+        return -1;
+    }
+
+    // Half the queries are stored keys, half are uniform over the key range
+    uint64_t r = 1234567;
+    uint64_t span = keys[n - 1] - keys[0] + 1;
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        uint64_t v = next_random(&r);
+        queries[i] = (i & 1) ? keys[v % n] : keys[0] + (span ? v % span : 0);
+    }
+
+    Eytzinger e;
+    RadixSpline s;
+    double t0 = now_seconds();
+    int failed = spline_build(&s, keys, n);
+    double t_build = now_seconds() - t0;
+    if (failed || eytzinger_build(&e, keys, n) != 0) {
+        spline_free(&s);
+        free(keys);
+        free(queries);
+        return -1;
+    }
+
+    size_t sum_ref = 0, sum_plain = 0, sum_eytz = 0, sum_spline = 0;
+    for (size_t i = 0; i < QUERY_COUNT; i++) sum_ref += branchless_lower_bound(keys, n, queries[i]);
+
+    t0 = now_seconds();
+    for (size_t i = 0; i < QUERY_COUNT; i++) sum_plain += plain_lower_bound(keys, n, queries[i]);
+    double t_plain = now_seconds() - t0;
+
+    // Compare keys rather than slots: the Eytzinger slot is not an index
+    uint64_t key_ref = 0, key_eytz = 0;
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        size_t p = branchless_lower_bound(keys, n, queries[i]);
+        key_ref += p < n ? keys[p] : UINT64_MAX;
+    }
+    t0 = now_seconds();
+    for (size_t i = 0; i < QUERY_COUNT; i++) {
+        size_t k = eytzinger_lower_bound(&e, queries[i]);
+        key_eytz += k ? e.keys[k] : UINT64_MAX;
+    }
+    double t_eytz = now_seconds() - t0;
+    sum_eytz = key_eytz == key_ref ? sum_ref : 0;
+
+    t0 = now_seconds();
+    for (size_t i = 0; i < QUERY_COUNT; i++) sum_spline += spline_lower_bound(&s, queries[i]);
+    double t_spline = now_seconds() - t0;
+
+    int mismatches = (sum_plain != sum_ref) + (sum_eytz != sum_ref) + (sum_spline != sum_ref);
+    printf("%10zu %-10s %9zu %9.1f %8.1f %10.1f %10.1f %10.1f %8.2fx %9lld%s\n", n,
+           dist_names[dist], s.point_count, spline_bytes(&s) / 1024.0, t_build * 1e3,
+           QUERY_COUNT / t_plain / 1e6, QUERY_COUNT / t_eytz / 1e6, QUERY_COUNT / t_spline / 1e6,
+           t_plain / t_spline, s.fallbacks, mismatches ? "  MISMATCH" : "");
+
+    spline_free(&s);
+    free(e.keys);
+    free(keys);
+    free(queries);
+    return mismatches;
+}
+
+int main(int argc, char *argv[]) {
+    double max_n = argc > 1 ? atof(argv[1]) : 1e7;
+    if (max_n < 1e6) {
+        fprintf(stderr, "Error: size must be at least 1000000.\n");
+        return 1;
+    }
+
+    printf("Spline error bound: %d positions, radix table: %d bits\n", SPLINE_ERROR, RADIX_TABLE_BITS);
+    printf("Million lookups per second (%d queries, half of them stored keys)\n\n", QUERY_COUNT);
+    printf("%10s %-10s %9s %9s %8s %10s %10s %10s %9s %9s\n", "n", "keys", "points", "model KB",
+           "build ms", "binary", "eytzinger", "learned", "vs binary", "fallback");
+
+    int failures = 0;
+    for (double n = 1e6; n <= max_n * 1.0001; n *= 10) {
+        for (int d = 0; d < DIST_COUNT; d++) {
+            int result = bench((size_t)n, (Distribution)d);
+            if (result < 0) {
+                printf("\nn = %.0f: not enough memory, stopping.\n", n);
+                return failures ? 1 : 0;
+            }
+            failures += result;
+        }
+    }
+
+    if (failures) {
+        fprintf(stderr, "Error: some searches disagreed with binary search.\n");
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,444 @@
+/**
+ * @file sorting_network_simd.c
+ * @brief AVX2 bitonic sorting networks for 8..64 int32 or float elements.
+ *
+ * This program demonstrates:
+ * 1. Bitonic sorting networks: a fixed sequence of compare-exchange steps
+ *    that sorts any input without data-dependent branches
+ * 2. Executing a network in SIMD registers: 8 lanes per __m256, exchanges
+ *    between registers are plain min/max, exchanges inside a register use a
+ *    lane permute, min/max and a blend
+ * 3. Batch sorting of many tiny arrays, padding sizes that are not a power
+ *    of two with +infinity
+ * 4. Using the network as the base case of a quicksort instead of
+ *    insertion sort
+ * 5. Runtime AVX2 detection with a scalar insertion-sort fallback
+ *
+ * The network uses the variant of bitonic sort in which every
+ * compare-exchange puts the minimum at the lower index: each merge stage
+ * first compares element i with its mirror in the block (i ^ (k - 1)), then
+ * runs half-cleaners at distances k/4, k/8, ..., 1.
+ *
+ * Float inputs must not contain NaN.
+ *
+ * quick_sort.c and merge_sort.c carry the 32-element int32 network as the
+ * base case of their sorts (ranges of up to 32 elements and short runs).
+ *
+ * Usage:
+ * gcc -O2 sorting_network_simd.c -o sorting_network_simd
+ * ./sorting_network_simd
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+#define LANES 8                 // 32-bit elements per AVX2 register
+#define NETWORK_MAX 64          // Largest array the networks sort (8 registers)
+#define QUICKSORT_CUTOFF 64     // Quicksort hands ranges up to this size to the base case
+#define INSERTION_CUTOFF 16     // Cutoff of the insertion-sort baseline
+#define ELEMENTS_PER_TEST (1 << 22)
+
+/**
+ * @brief Returns 1 if the running CPU supports AVX2.
+ */
+int have_avx2(void) {
+#if HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return 0;
+#endif
+}
+
+/* ---------- Scalar insertion sort (fallback and baseline) ---------- */
+
+#define DEFINE_INSERTION_SORT(suffix, T)                                           \
+void insertion_sort_##suffix(T *a, int n) {                                        \
+    for (int i = 1; i < n; i++) {                                                  \
+        T key = a[i];                                                              \
+        int j = i;                                                                 \
+        while (j > 0 && a[j - 1] > key) {                                          \
+            a[j] = a[j - 1];                                                       \
+            j--;                                                                   \
+        }                                                                          \
+        a[j] = key;                                                                \
+    }                                                                              \
+}
+
+DEFINE_INSERTION_SORT(i32, int32_t)
+DEFINE_INSERTION_SORT(f32, float)
+
+/* ---------- In-register networks ---------- */
+
+#if HAVE_X86_KERNELS
+
+/*
+ * Lane permutations and "take the maximum" masks for exchanges inside one
+ * register. Row s handles partner distance pattern:
+ *   0: flip within pairs (l ^ 1)    1: flip within quads (l ^ 3)
+ *   2: flip within 8 (l ^ 7)        3: half-cleaner l ^ 2
+ *   4: half-cleaner l ^ 4           (half-cleaner l ^ 1 equals row 0)
+ * A lane takes the max when it is the upper element of its pair.
+ */
+enum { STEP_FLIP2, STEP_FLIP4, STEP_FLIP8, STEP_HALF2, STEP_HALF4, STEP_COUNT };
+
+static const int32_t step_perm[STEP_COUNT][LANES] = {
+    { 1, 0, 3, 2, 5, 4, 7, 6 },
+    { 3, 2, 1, 0, 7, 6, 5, 4 },
+    { 7, 6, 5, 4, 3, 2, 1, 0 },
+    { 2, 3, 0, 1, 6, 7, 4, 5 },
+    { 4, 5, 6, 7, 0, 1, 2, 3 },
+};
+
+static const int32_t step_upper[STEP_COUNT][LANES] = {
+    { 0, -1, 0, -1, 0, -1, 0, -1 },
+    { 0, 0, -1, -1, 0, 0, -1, -1 },
+    { 0, 0, 0, 0, -1, -1, -1, -1 },
+    { 0, 0, -1, -1, 0, 0, -1, -1 },
+    { 0, 0, 0, 0, -1, -1, -1, -1 },
+};
+
+/**
+ * Generates the network for one element type:
+ *   exchange_<s>(v, step)          in-register compare-exchange
+ *   bitonic_<s>(v, regs)           sorts regs * 8 values held in v[0..regs)
+ *   network_sort_<s>(a, n)         sorts a[0..n), n <= 64
+ */
+#define DEFINE_NETWORK(s, T, VEC, LOADU, STOREU, SET1, MIN, MAX, PERMUTE, BLEND, PAD)  \
+__attribute__((target("avx2"), always_inline))                                     \
+static inline VEC exchange_##s(VEC v, int step) {                                  \
+    __m256i perm = _mm256_loadu_si256((const __m256i *)step_perm[step]);           \
+    __m256i upper = _mm256_loadu_si256((const __m256i *)step_upper[step]);         \
+    VEC p = PERMUTE(v, perm);                                                      \
+    return BLEND(MIN(v, p), MAX(v, p), upper);                                     \
+}                                                                                  \
+                                                                                   \
+__attribute__((target("avx2"), always_inline))                                     \
+static inline VEC reverse_##s(VEC v) {                                             \
+    return PERMUTE(v, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0));                  \
+}                                                                                  \
+                                                                                   \
+__attribute__((target("avx2"), always_inline))                                     \
+static inline void bitonic_##s(VEC *v, int regs) {                                 \
+    int n = regs * LANES;                                                          \
+    for (int k = 2; k <= n; k *= 2) {                                              \
+        /* Mirror step: i against i ^ (k - 1) */                                   \
+        if (k <= LANES) {                                                          \
+            int step = k == 2 ? STEP_FLIP2 : k == 4 ? STEP_FLIP4 : STEP_FLIP8;     \
+            for (int r = 0; r < regs; r++) v[r] = exchange_##s(v[r], step);        \
+        } else {                                                                   \
+            int span = k / LANES - 1;                                              \
+            for (int r = 0; r < regs; r++) {                                       \
+                int partner = r ^ span;                                            \
+                if (partner < r) continue;                                         \
+                VEC b = reverse_##s(v[partner]);                                   \
+                VEC lo = MIN(v[r], b), hi = MAX(v[r], b);                          \
+                v[r] = lo;                                                         \
+                v[partner] = reverse_##s(hi);                                      \
+            }                                                                      \
+        }                                                                          \
+        /* Half-cleaners: i against i ^ j */                                       \
+        for (int j = k / 4; j >= 1; j /= 2) {                                      \
+            if (j >= LANES) {                                                      \
+                int span = j / LANES;                                              \
+                for (int r = 0; r < regs; r++) {                                   \
+                    if (r & span) continue;                                        \
+                    VEC lo = MIN(v[r], v[r + span]), hi = MAX(v[r], v[r + span]);  \
+                    v[r] = lo;                                                     \
+                    v[r + span] = hi;                                              \
+                }                                                                  \
+            } else {                                                               \
+                int step = j == 4 ? STEP_HALF4 : j == 2 ? STEP_HALF2 : STEP_FLIP2; \
+                for (int r = 0; r < regs; r++) v[r] = exchange_##s(v[r], step);    \
+            }                                                                      \
+        }                                                                          \
+    }                                                                              \
+}                                                                                  \
+                                                                                   \
+/* One copy per register count, so every loop above unrolls completely */        \
+__attribute__((target("avx2")))                                                    \
+static void bitonic1_##s(VEC *v) { bitonic_##s(v, 1); }                            \
+__attribute__((target("avx2")))                                                    \
+static void bitonic2_##s(VEC *v) { bitonic_##s(v, 2); }                            \
+__attribute__((target("avx2")))                                                    \
+static void bitonic4_##s(VEC *v) { bitonic_##s(v, 4); }                            \
+__attribute__((target("avx2")))                                                    \
+static void bitonic8_##s(VEC *v) { bitonic_##s(v, 8); }                            \
+                                                                                   \
+__attribute__((target("avx2")))                                                    \
+void network_sort_##s(T *a, int n) {                                               \
+    if (n < 2) return;                                                             \
+    int regs = n <= 8 ? 1 : n <= 16 ? 2 : n <= 32 ? 4 : 8;                         \
+    VEC v[NETWORK_MAX / LANES];                                                    \
+    int full = n / LANES;                                                          \
+    for (int r = 0; r < full; r++) v[r] = LOADU(a + r * LANES);                    \
+    if (full < regs) {                                                             \
+        /* Pad the tail with the largest value so it sorts to the end */           \
+        T tail[LANES];                                                             \
+        int rest = n - full * LANES;                                               \
+        for (int i = 0; i < LANES; i++) tail[i] = i < rest ? a[full * LANES + i] : PAD; \
+        v[full] = LOADU(tail);                                                     \
+        for (int r = full + 1; r < regs; r++) v[r] = SET1(PAD);                    \
+    }                                                                              \
+                                                                                   \
+    switch (regs) {                                                                \
+    case 1: bitonic1_##s(v); break;                                                \
+    case 2: bitonic2_##s(v); break;                                                \
+    case 4: bitonic4_##s(v); break;                                                \
+    default: bitonic8_##s(v); break;                                               \
+    }                                                                              \
+                                                                                   \
+    for (int r = 0; r < full; r++) STOREU(a + r * LANES, v[r]);                    \
+    if (full * LANES < n) {                                                        \
+        T tail[LANES];                                                             \
+        STOREU(tail, v[full]);                                                     \
+        memcpy(a + full * LANES, tail, (n - full * LANES) * sizeof(T));            \
+    }                                                                              \
+}
+
+#define LOADU_I32(p) _mm256_loadu_si256((const __m256i *)(p))
+#define STOREU_I32(p, v) _mm256_storeu_si256((__m256i *)(p), (v))
+#define BLEND_I32(a, b, mask) _mm256_blendv_epi8((a), (b), (mask))
+#define BLEND_F32(a, b, mask) _mm256_blendv_ps((a), (b), _mm256_castsi256_ps(mask))
+
+DEFINE_NETWORK(i32, int32_t, __m256i, LOADU_I32, STOREU_I32, _mm256_set1_epi32,
+               _mm256_min_epi32, _mm256_max_epi32, _mm256_permutevar8x32_epi32,
+               BLEND_I32, INT32_MAX)
+DEFINE_NETWORK(f32, float, __m256, _mm256_loadu_ps, _mm256_storeu_ps, _mm256_set1_ps,
+               _mm256_min_ps, _mm256_max_ps, _mm256_permutevar8x32_ps,
+               BLEND_F32, INFINITY)
+
+#else
+
+void network_sort_i32(int32_t *a, int n) { insertion_sort_i32(a, n); }
+void network_sort_f32(float *a, int n) { insertion_sort_f32(a, n); }
+
+#endif
+
+/* ---------- Public API ---------- */
+
+static int use_network = -1;
+
+/**
+ * @brief Sorts a small array (n <= 64) with the AVX2 network when the CPU
+ * supports it, otherwise with insertion sort.
+ */
+void small_sort_i32(int32_t *a, int n) {
+    if (use_network < 0) use_network = have_avx2();
+    if (use_network) network_sort_i32(a, n);
+    else insertion_sort_i32(a, n);
+}
+
+void small_sort_f32(float *a, int n) {
+    if (use_network < 0) use_network = have_avx2();
+    if (use_network) network_sort_f32(a, n);
+    else insertion_sort_f32(a, n);
+}
+
+/**
+ * @brief Sorts `count` consecutive arrays of `size` (<= 64) elements each.
+ */
+void batch_sort_i32(int32_t *data, size_t count, int size) {
+    for (size_t i = 0; i < count; i++) small_sort_i32(data + i * size, size);
+}
+
+void batch_sort_f32(float *data, size_t count, int size) {
+    for (size_t i = 0; i < count; i++) small_sort_f32(data + i * size, size);
+}
+
+/**
+ * Generates hybrid_sort_<s>(a, n, cutoff, base): quicksort with a
+ * median-of-3 pivot that calls base(a, len) on ranges of at most `cutoff`
+ * elements. Recursing into the smaller side bounds the stack at log2(n).
+ */
+#define DEFINE_HYBRID_SORT(s, T)                                                   \
+void hybrid_sort_##s(T *a, size_t n, int cutoff, void (*base)(T *, int)) {         \
+    while (n > (size_t)cutoff) {                                                   \
+        T *mid = a + n / 2, *last = a + n - 1, t;                                  \
+        if (*mid < *a) { t = *mid; *mid = *a; *a = t; }                            \
+        if (*last < *mid) {                                                        \
+            t = *last; *last = *mid; *mid = t;                                     \
+            if (*mid < *a) { t = *mid; *mid = *a; *a = t; }                        \
+        }                                                                          \
+        T pivot = *mid;                                                            \
+        size_t i = 0, j = n - 1;                                                   \
+        for (;;) {                                                                 \
+            while (a[i] < pivot) i++;                                              \
+            while (pivot < a[j]) j--;                                              \
+            if (i >= j) break;                                                     \
+            t = a[i]; a[i] = a[j]; a[j] = t;                                       \
+            i++;                                                                   \
+            j--;                                                                   \
+        }                                                                          \
+        /* [0, j] <= pivot <= [j + 1, n) */                                        \
+        size_t left = j + 1;                                                       \
+        if (left < n - left) {                                                     \
+            hybrid_sort_##s(a, left, cutoff, base);                                \
+            a += left;                                                             \
+            n -= left;                                                             \
+        } else {                                                                   \
+            hybrid_sort_##s(a + left, n - left, cutoff, base);                     \
+            n = left;                                                              \
+        }                                                                          \
+    }                                                                              \
+    base(a, (int)n);                                                               \
+}
+
+DEFINE_HYBRID_SORT(i32, int32_t)
+DEFINE_HYBRID_SORT(f32, float)
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static inline uint64_t next_random(uint64_t *s) {
+    *s ^= *s << 13;
+    *s ^= *s >> 7;
+    *s ^= *s << 17;
+    return *s;
+}
+
+int compare_i32(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+int compare_f32(const void *a, const void *b) {
+    float x = *(const float *)a, y = *(const float *)b;
+    return (x > y) - (x < y);
+}
+
+void qsort_i32(int32_t *a, int n) { qsort(a, n, sizeof(int32_t), compare_i32); }
+void qsort_f32(float *a, int n) { qsort(a, n, sizeof(float), compare_f32); }
+
+#define FILL_I32(r) ((int32_t)((r) >> 32))
+#define FILL_F32(r) ((float)(int32_t)((r) >> 32) * 1e-3f)
+
+/**
+ * Small-array throughput: sorts ELEMENTS_PER_TEST / size arrays of each
+ * size with every method. All outputs are compared with qsort's.
+ */
+#define DEFINE_SMALL_BENCH(s, T, FILL)                                             \
+int bench_small_##s(void) {                                                        \
+    const int sizes[] = { 8, 16, 32, 64, 5, 13, 27, 50 };                          \
+    int mismatches = 0;                                                            \
+    printf("\n%s arrays (million arrays per second)\n", #s);                       \
+    printf("%6s %12s %12s %12s %10s\n", "size", "network", "insertion", "qsort",   \
+           "vs insert");                                                           \
+    for (int si = 0; si < (int)(sizeof(sizes) / sizeof(sizes[0])); si++) {        \
+        int size = sizes[si];                                                      \
+        size_t count = ELEMENTS_PER_TEST / size, total = count * size;             \
+        T *input = (T *)malloc(total * sizeof(T));                                 \
+        T *work = (T *)malloc(total * sizeof(T));                                  \
+        T *expected = (T *)malloc(total * sizeof(T));                              \
+        if (!input || !work || !expected) {                                        \
+            fprintf(stderr, "Memory allocation failed.\n");                        \
+            exit(1);                                                               \
+        }                                                                          \
+        uint64_t r = 88172645463325252ull + size;                                  \
+        for (size_t i = 0; i < total; i++) input[i] = FILL(next_random(&r));       \
+                                                                                   \
+        double rate[3];                                                            \
+        void (*sorters[3])(T *, int) = { small_sort_##s, insertion_sort_##s,       \
+                                         qsort_##s };                              \
+        for (int m = 2; m >= 0; m--) {                                             \
+            memcpy(work, input, total * sizeof(T));                                \
+            double t0 = now_seconds();                                             \
+            for (size_t i = 0; i < count; i++) sorters[m](work + i * size, size);  \
+            rate[m] = count / (now_seconds() - t0) / 1e6;                          \
+            if (m == 2) memcpy(expected, work, total * sizeof(T));                 \
+            else if (memcmp(work, expected, total * sizeof(T)) != 0) mismatches++; \
+        }                                                                          \
+        printf("%6d %12.2f %12.2f %12.2f %9.2fx\n", size, rate[0], rate[1],        \
+               rate[2], rate[0] / rate[1]);                                        \
+        free(input);                                                               \
+        free(work);                                                                \
+        free(expected);                                                            \
+    }                                                                              \
+    return mismatches;                                                             \
+}
+
+DEFINE_SMALL_BENCH(i32, int32_t, FILL_I32)
+DEFINE_SMALL_BENCH(f32, float, FILL_F32)
+
+/**
+ * @brief Large sorts: the same quicksort with an insertion-sort base case
+ * and with the network base case, against qsort.
+ */
+int bench_hybrid(size_t n) {
+    int32_t *input = (int32_t *)malloc(n * sizeof(int32_t));
+    int32_t *work = (int32_t *)malloc(n * sizeof(int32_t));
+    int32_t *expected = (int32_t *)malloc(n * sizeof(int32_t));
+    if (!input || !work || !expected) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    uint64_t r = 88172645463325252ull;
+    for (size_t i = 0; i < n; i++) input[i] = FILL_I32(next_random(&r));
+    memcpy(expected, input, n * sizeof(int32_t));
+
+    double t0 = now_seconds();
+    qsort(expected, n, sizeof(int32_t), compare_i32);
+    double t_qsort = now_seconds() - t0;
+
+    memcpy(work, input, n * sizeof(int32_t));
+    t0 = now_seconds();
+    hybrid_sort_i32(work, n, INSERTION_CUTOFF, insertion_sort_i32);
+    double t_insertion = now_seconds() - t0;
+    int mismatches = memcmp(work, expected, n * sizeof(int32_t)) != 0;
+
+    memcpy(work, input, n * sizeof(int32_t));
+    t0 = now_seconds();
+    hybrid_sort_i32(work, n, QUICKSORT_CUTOFF, small_sort_i32);
+    double t_network = now_seconds() - t0;
+    mismatches += memcmp(work, expected, n * sizeof(int32_t)) != 0;
+
+    printf("%10zu %12.1f %12.1f %12.1f %9.2fx\n", n, t_network * 1e3, t_insertion * 1e3,
+           t_qsort * 1e3, t_insertion / t_network);
+    free(input);
+    free(work);
+    free(expected);
+    return mismatches;
+}
+
+int main(void) {
+    printf("AVX2 networks: %s\n", have_avx2() ? "enabled" : "not available, using insertion sort");
+
+    int32_t demo[] = { 64, 34, 25, 12, 22, 11, 90, 5, 77, 3, -8 };
+    int n = sizeof(demo) / sizeof(demo[0]);
+    small_sort_i32(demo, n);
+    printf("Sorted example: ");
+    for (int i = 0; i < n; i++) printf("%d ", demo[i]);
+    printf("\n");
+
+    int mismatches = bench_small_i32();
+    mismatches += bench_small_f32();
+
+    printf("\nQuicksort base case, random int32 (ms)\n");
+    printf("%10s %12s %12s %12s %10s\n", "n", "network/64", "insert/16", "qsort", "speedup");
+    for (size_t size = 1000000; size <= 10000000; size *= 10) mismatches += bench_hybrid(size);
+
+    if (mismatches) {
+        fprintf(stderr, "\n%d results differ from qsort.\n", mismatches);
+        return 1;
+    }
+    printf("\nAll results match qsort.\n");
+    return 0;
+}
@@ -0,0 +1,431 @@
+/**
+ * @file gemm_parallel.c
+ * @brief Multi-threaded matrix multiplication with a persistent worker pool.
+ *
+ * This program demonstrates:
+ * 1. A reusable pthread worker pool (workers sleep on a condition variable)
+ * 2. 2D partitioning of the output matrix into one block per worker
+ * 3. First-touch initialisation and thread pinning for NUMA/cache locality
+ * 4. Handling degenerate shapes (a single row or a single column of output)
+ * 5. Strong-scaling measurement from 1 thread up to every online core
+ *
+ * Matrices use the same contiguous, cache-line padded row-major layout and
+ * tiled i-k-j kernel as 01_basics_revision/matrix_multiplication.c.
+ *
+ * Usage:
+ * gcc -O3 -march=native -pthread gemm_parallel.c -o gemm_parallel
+ * ./gemm_parallel            (strong-scaling benchmark, n = 2048)
+ * ./gemm_parallel 4096       (choose the square problem size)
+ * ./gemm_parallel 4096 16    (scale up to 16 threads instead of all cores)
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#define MATRIX_ALIGNMENT 64
+#define INTS_PER_LINE (MATRIX_ALIGNMENT / (int)sizeof(int))
+#define BLOCK_I 64
+#define BLOCK_K 128
+#define BLOCK_J 256
+
+typedef struct {
+    int rows;
+    int cols;
+    int stride;
+    int *data;
+} Matrix;
+
+#define MAT_AT(m, i, j) ((m)->data[(size_t)(i) * (m)->stride + (j)])
+
+/**
+ * @brief Allocates a rows x cols matrix without touching its pages.
+ *
+ * The pages are left untouched so that whichever thread writes them first
+ * decides (under Linux's first-touch policy) which NUMA node they live on.
+ */
+Matrix *allocate_matrix(int rows, int cols) {
+    Matrix *matrix = (Matrix *)malloc(sizeof(Matrix));
+    if (matrix == NULL) return NULL;
+
+    matrix->rows = rows;
+    matrix->cols = cols;
+    matrix->stride = (cols + INTS_PER_LINE - 1) / INTS_PER_LINE * INTS_PER_LINE;
+    size_t bytes = (size_t)rows * matrix->stride * sizeof(int);
+    matrix->data = (int *)aligned_alloc(MATRIX_ALIGNMENT, bytes ? bytes : MATRIX_ALIGNMENT);
+    if (matrix->data == NULL) {
+        free(matrix);
+        return NULL;
+    }
+    return matrix;
+}
+
+void free_matrix(Matrix *matrix) {
+    if (matrix == NULL) return;
+    free(matrix->data);
+    free(matrix);
+}
+
+/* ---------- Worker pool ---------- */
+
+typedef void (*pool_task)(void *arg, int worker, int workers);
+
+typedef struct ThreadPool ThreadPool;
+
+typedef struct {
+    ThreadPool *pool;
+    int id;
+} WorkerInfo;
+
+/**
+ * Workers wait for `generation` to change, run the current task with their
+ * id, and report back through `pending`. The calling thread acts as worker 0,
+ * so a pool of n workers starts n - 1 threads.
+ */
+struct ThreadPool {
+    int workers;
+    pthread_t *threads;
+    WorkerInfo *info;
+    pthread_mutex_t lock;
+    pthread_cond_t start;
+    pthread_cond_t done;
+    unsigned long generation;
+    int pending;
+    int shutdown;
+    pool_task task;
+    void *arg;
+};
+
+/**
+ * @brief Pins the calling thread to one CPU so its cache (and the memory it
+ * first touched) stays local. Silently ignored where unsupported.
+ */
+void pin_to_cpu(int cpu) {
+#ifdef __linux__
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % (cpus > 0 ? cpus : 1), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+void *worker_main(void *p) {
+    WorkerInfo *info = (WorkerInfo *)p;
+    ThreadPool *pool = info->pool;
+    unsigned long seen = 0;
+
+    pin_to_cpu(info->id);
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->generation == seen && !pool->shutdown)
+            pthread_cond_wait(&pool->start, &pool->lock);
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        pool->task(pool->arg, info->id, pool->workers);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0)
+            pthread_cond_signal(&pool->done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+ThreadPool *pool_create(int workers) {
+    ThreadPool *pool = (ThreadPool *)calloc(1, sizeof(ThreadPool));
+    if (pool == NULL) return NULL;
+    pool->workers = workers;
+    pool->threads = (pthread_t *)malloc(workers * sizeof(pthread_t));
+    pool->info = (WorkerInfo *)malloc(workers * sizeof(WorkerInfo));
+    if (!pool->threads || !pool->info) {
+        free(pool->threads);
+        free(pool->info);
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->start, NULL);
+    pthread_cond_init(&pool->done, NULL);
+
+    for (int i = 1; i < workers; i++) {
+        pool->info[i].pool = pool;
+        pool->info[i].id = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_main, &pool->info[i]) != 0) {
+            fprintf(stderr, "Error: could not start worker thread %d\n", i);
+            exit(1);
+        }
+    }
+    pin_to_cpu(0);
+    return pool;
+}
+
+/**
+ * @brief Runs task(arg, id, workers) on every worker and waits for all.
+ */
+void pool_run(ThreadPool *pool, pool_task task, void *arg) {
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->pending = pool->workers - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg, 0, pool->workers);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void pool_destroy(ThreadPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+    for (int i = 1; i < pool->workers; i++)
+        pthread_join(pool->threads[i], NULL);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->start);
+    pthread_cond_destroy(&pool->done);
+    free(pool->threads);
+    free(pool->info);
+    free(pool);
+}
+
+/* ---------- Partitioning ---------- */
+
+/**
+ * @brief Splits `workers` into a pr x pc grid over an m x n output.
+ *
+ * Each worker reads (m / pr) rows of A and (n / pc) columns of B, so the
+ * grid minimising m / pr + n / pc minimises the data each worker streams.
+ * A single output row (m == 1) forces pr = 1, a single column pc = 1.
+ */
+void choose_grid(int workers, int m, int n, int *pr, int *pc) {
+    double best = -1.0;
+    *pr = 1;
+    *pc = workers;
+    for (int r = 1; r <= workers; r++) {
+        if (workers % r != 0) continue;
+        int c = workers / r;
+        if (r > m || (c - 1) * INTS_PER_LINE >= n) continue;
+        double cost = (double)m / r + (double)n / c;
+        if (best < 0 || cost < best) {
+            best = cost;
+            *pr = r;
+            *pc = c;
+        }
+    }
+    if (best < 0) {
+        // Not enough work for a full grid: split the longer dimension only
+        if (m >= n) { *pr = workers < m ? workers : m; *pc = 1; }
+        else { *pr = 1; *pc = workers; }
+    }
+}
+
+/**
+ * @brief Returns the start of part `idx` when splitting [0, total) into
+ * `parts` pieces whose boundaries are multiples of `align`.
+ */
+int split_point(int total, int parts, int idx, int align) {
+    long long units = (total + align - 1) / align;
+    long long at = units * idx / parts * align;
+    return at < total ? (int)at : total;
+}
+
+/* ---------- Kernels ---------- */
+
+/**
+ * @brief result[r0:r1, c0:c1] = a[r0:r1, :] * b[:, c0:c1] (tiled i-k-j).
+ */
+void multiply_block(const Matrix *a, const Matrix *b, Matrix *result,
+                    int r0, int r1, int c0, int c1) {
+    int shared = a->cols;
+
+    // First touch of this block's output happens on the owning thread
+    for (int i = r0; i < r1; i++)
+        memset(&MAT_AT(result, i, c0), 0, (c1 - c0) * sizeof(int));
+
+    if (c1 - c0 == 1) {
+        // Matrix-vector product: a dot product per row beats i-k-j here
+        for (int i = r0; i < r1; i++) {
+            const int *a_row = &MAT_AT(a, i, 0);
+            int sum = 0;
+            for (int k = 0; k < shared; k++)
+                sum += a_row[k] * MAT_AT(b, k, c0);
+            MAT_AT(result, i, c0) = sum;
+        }
+        return;
+    }
+
+    for (int ii = r0; ii < r1; ii += BLOCK_I) {
+        int i_end = ii + BLOCK_I < r1 ? ii + BLOCK_I : r1;
+        for (int kk = 0; kk < shared; kk += BLOCK_K) {
+            int k_end = kk + BLOCK_K < shared ? kk + BLOCK_K : shared;
+            for (int jj = c0; jj < c1; jj += BLOCK_J) {
+                int j_end = jj + BLOCK_J < c1 ? jj + BLOCK_J : c1;
+                for (int i = ii; i < i_end; i++) {
+                    int *restrict c_row = &MAT_AT(result, i, 0);
+                    for (int k = kk; k < k_end; k++) {
+                        int a_ik = MAT_AT(a, i, k);
+                        const int *restrict b_row = &MAT_AT(b, k, 0);
+                        for (int j = jj; j < j_end; j++)
+                            c_row[j] += a_ik * b_row[j];
+                    }
+                }
+            }
+        }
+    }
+}
+
+typedef struct {
+    const Matrix *a;
+    const Matrix *b;
+    Matrix *result;
+    int pr, pc;
+} GemmJob;
+
+void gemm_task(void *arg, int worker, int workers) {
+    GemmJob *job = (GemmJob *)arg;
+    (void)workers;
+    if (worker >= job->pr * job->pc) return;
+
+    int bi = worker / job->pc, bj = worker % job->pc;
+    int r0 = split_point(job->result->rows, job->pr, bi, 1);
+    int r1 = split_point(job->result->rows, job->pr, bi + 1, 1);
+    // Column boundaries on cache-line multiples avoid false sharing in C
+    int c0 = split_point(job->result->cols, job->pc, bj, INTS_PER_LINE);
+    int c1 = split_point(job->result->cols, job->pc, bj + 1, INTS_PER_LINE);
+    if (r0 < r1 && c0 < c1)
+        multiply_block(job->a, job->b, job->result, r0, r1, c0, c1);
+}
+
+/**
+ * @brief result = a * b using every worker of the pool.
+ */
+void parallel_multiply(ThreadPool *pool, const Matrix *a, const Matrix *b, Matrix *result) {
+    GemmJob job = { a, b, result, 1, 1 };
+    choose_grid(pool->workers, result->rows, result->cols, &job.pr, &job.pc);
+    pool_run(pool, gemm_task, &job);
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+typedef struct {
+    const Matrix *m;
+    unsigned seed;
+} FillJob;
+
+/**
+ * @brief Fills rows in parallel so input pages are spread like the work.
+ */
+void fill_task(void *arg, int worker, int workers) {
+    FillJob *job = (FillJob *)arg;
+    const Matrix *m = job->m;
+    int r0 = split_point(m->rows, workers, worker, 1);
+    int r1 = split_point(m->rows, workers, worker + 1, 1);
+    for (int i = r0; i < r1; i++) {
+        unsigned s = job->seed * 2654435761u + i;
+        for (int j = 0; j < m->stride; j++) {
+            s = s * 1103515245u + 12345u;
+            MAT_AT(m, i, j) = j < m->cols ? (int)((s >> 16) % 100) - 50 : 0;
+        }
+    }
+}
+
+/**
+ * @brief Strong scaling for one shape: fixed problem, growing thread count.
+ */
+void scaling_run(const char *label, int m, int k, int n, int max_threads) {
+    printf("\n%s: (%d x %d) * (%d x %d)\n", label, m, k, k, n);
+    printf("%8s %8s %12s %10s %10s %11s\n", "threads", "grid", "time (ms)", "GFLOP/s", "speedup", "efficiency");
+
+    Matrix *a = allocate_matrix(m, k);
+    Matrix *b = allocate_matrix(k, n);
+    Matrix *reference = allocate_matrix(m, n);
+    Matrix *result = allocate_matrix(m, n);
+    if (!a || !b || !reference || !result) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    double base_time = 0.0;
+    // Powers of two, then the full core count
+    for (int t = 1;; t = t * 2 < max_threads ? t * 2 : max_threads) {
+        ThreadPool *pool = pool_create(t);
+        if (pool == NULL) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            exit(1);
+        }
+        FillJob fa = { a, 1 }, fb = { b, 2 };
+        pool_run(pool, fill_task, &fa);
+        pool_run(pool, fill_task, &fb);
+
+        Matrix *out = (t == 1) ? reference : result;
+        parallel_multiply(pool, a, b, out); // warm-up
+        double t0 = now_seconds();
+        parallel_multiply(pool, a, b, out);
+        double elapsed = now_seconds() - t0;
+
+        int pr, pc;
+        choose_grid(t, m, n, &pr, &pc);
+        if (t == 1) base_time = elapsed;
+
+        int mismatch = 0;
+        for (int i = 0; i < m && t > 1 && !mismatch; i++)
+            mismatch = memcmp(&MAT_AT(reference, i, 0), &MAT_AT(result, i, 0), n * sizeof(int)) != 0;
+
+        char grid[32];
+        snprintf(grid, sizeof(grid), "%dx%d", pr, pc);
+        printf("%8d %8s %12.2f %10.2f %9.2fx %10.1f%%%s\n", t, grid, elapsed * 1e3,
+               2.0 * m * n * k / elapsed / 1e9, base_time / elapsed,
+               100.0 * base_time / elapsed / t, mismatch ? "  RESULT MISMATCH" : "");
+        pool_destroy(pool);
+        if (t == max_threads) break;
+    }
+
+    free_matrix(a);
+    free_matrix(b);
+    free_matrix(reference);
+    free_matrix(result);
+}
+
+int main(int argc, char *argv[]) {
+    int n = argc > 1 ? atoi(argv[1]) : 2048;
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int max_threads = cpus > 0 ? (int)cpus : 1;
+    if (argc > 2) max_threads = atoi(argv[2]);
+
+    if (n <= 0 || max_threads <= 0) {
+        fprintf(stderr, "Usage: %s [size] [max_threads]\n", argv[0]);
+        return 1;
+    }
+
+    printf("Online CPUs: %ld, scaling up to %d threads\n", cpus, max_threads);
+    scaling_run("Square", n, n, n, max_threads);
+    scaling_run("Single row (r1 = 1)", 1, 4 * n, 4 * n, max_threads);
+    scaling_run("Single column (c2 = 1)", 4 * n, 4 * n, 1, max_threads);
+    return 0;
+}
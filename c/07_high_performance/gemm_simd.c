@@ -0,0 +1,631 @@
+/**
+ * @file gemm_simd.c
+ * @brief Packed-panel GEMM with AVX2 / AVX-512 micro-kernels and runtime dispatch.
+ *
+ * This program demonstrates:
+ * 1. The three-level blocking scheme (NC / KC / MC) used by BLAS libraries
+ * 2. Packing A and B into contiguous, zero-padded micro-panels
+ * 3. Register-blocked micro-kernels written with SIMD intrinsics
+ * 4. Runtime CPU feature detection with a portable scalar fallback
+ * 5. Measuring achieved GFLOP/s against a measured FMA peak
+ *
+ * Kernels are compiled with per-function target attributes, so the program
+ * builds without -march flags and still runs on CPUs without AVX.
+ *
+ * Usage:
+ * gcc -O2 gemm_simd.c -o gemm_simd
+ * ./gemm_simd                  (benchmark every type and supported ISA)
+ * ./gemm_simd avx2             (restrict to one ISA: scalar, avx2, avx512)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS 1
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+#define GEMM_ALIGNMENT 64
+#define KC 256    // Depth of a packed panel (A and B micro-panels stay in L1)
+#define MC 96     // Rows of A packed at once (fits L2); multiple of every MR
+#define NC 3072   // Columns of B packed at once (fits L3); multiple of every NR
+
+typedef enum { ISA_SCALAR, ISA_AVX2, ISA_AVX512, ISA_COUNT } Isa;
+
+const char *isa_names[ISA_COUNT] = { "scalar", "avx2", "avx512" };
+
+/**
+ * @brief Returns 1 if the running CPU can execute kernels for `isa`.
+ */
+int isa_supported(Isa isa) {
+#if HAVE_X86_KERNELS
+    __builtin_cpu_init();
+    if (isa == ISA_AVX2)
+        return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    if (isa == ISA_AVX512)
+        return __builtin_cpu_supports("avx512f");
+#endif
+    return isa == ISA_SCALAR;
+}
+
+/**
+ * @brief Picks the widest instruction set the running CPU supports.
+ */
+Isa best_isa(void) {
+    if (isa_supported(ISA_AVX512)) return ISA_AVX512;
+    if (isa_supported(ISA_AVX2)) return ISA_AVX2;
+    return ISA_SCALAR;
+}
+
+void *aligned_buffer(size_t bytes) {
+    bytes = (bytes + GEMM_ALIGNMENT - 1) / GEMM_ALIGNMENT * GEMM_ALIGNMENT;
+    void *p = aligned_alloc(GEMM_ALIGNMENT, bytes ? bytes : GEMM_ALIGNMENT);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    return p;
+}
+
+/* ---------- Generic packing, scalar kernel and blocked driver ---------- */
+
+/**
+ * DEFINE_GEMM(T, suffix) instantiates for element type T:
+ *   - GemmKernel_suffix: micro-kernel descriptor (tile shape + function)
+ *   - pack_a_suffix / pack_b_suffix: copy a block into zero-padded panels
+ *   - kernel_scalar_suffix: portable 4x4 micro-kernel
+ *   - gemm_suffix: C = A * B for row-major matrices using a given kernel
+ *
+ * Packed A holds MR-row micro-panels laid out column by column; packed B
+ * holds NR-column micro-panels laid out row by row, so the micro-kernel
+ * reads both with unit stride. A micro-kernel computes one MR x NR tile of
+ * C += A_panel * B_panel; mr/nr give the valid part of edge tiles.
+ */
+#define DEFINE_GEMM(T, suffix)                                                  \
+typedef void (*kernel_fn_##suffix)(int kc, const T *a, const T *b,             \
+                                   T *c, int ldc, int mr, int nr);             \
+                                                                               \
+typedef struct {                                                               \
+    int mr, nr;                                                                \
+    kernel_fn_##suffix fn;                                                     \
+} GemmKernel_##suffix;                                                         \
+                                                                               \
+void pack_a_##suffix(int mc, int kc, const T *a, int lda, T *dst, int mr) {    \
+    for (int i = 0; i < mc; i += mr) {                                         \
+        int rows = mc - i < mr ? mc - i : mr;                                  \
+        for (int p = 0; p < kc; p++) {                                         \
+            for (int r = 0; r < rows; r++)                                     \
+                dst[r] = a[(size_t)(i + r) * lda + p];                         \
+            for (int r = rows; r < mr; r++)                                    \
+                dst[r] = 0;                                                    \
+            dst += mr;                                                         \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void pack_b_##suffix(int kc, int nc, const T *b, int ldb, T *dst, int nr) {    \
+    for (int j = 0; j < nc; j += nr) {                                         \
+        int cols = nc - j < nr ? nc - j : nr;                                  \
+        for (int p = 0; p < kc; p++) {                                         \
+            const T *src = b + (size_t)p * ldb + j;                            \
+            for (int c = 0; c < cols; c++)                                     \
+                dst[c] = src[c];                                               \
+            for (int c = cols; c < nr; c++)                                    \
+                dst[c] = 0;                                                    \
+            dst += nr;                                                         \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+void kernel_scalar_##suffix(int kc, const T *a, const T *b, T *c, int ldc,     \
+                            int mr, int nr) {                                  \
+    T acc[4][4] = {{0}};                                                       \
+    for (int p = 0; p < kc; p++) {                                             \
+        for (int i = 0; i < 4; i++)                                            \
+            for (int j = 0; j < 4; j++)                                        \
+                acc[i][j] += a[i] * b[j];                                      \
+        a += 4;                                                                \
+        b += 4;                                                                \
+    }                                                                          \
+    for (int i = 0; i < mr; i++)                                               \
+        for (int j = 0; j < nr; j++)                                           \
+            c[(size_t)i * ldc + j] += acc[i][j];                               \
+}                                                                              \
+                                                                               \
+void gemm_##suffix(const GemmKernel_##suffix *kern, int m, int n, int k,       \
+                   const T *a, int lda, const T *b, int ldb, T *c, int ldc) {  \
+    T *pa = (T *)aligned_buffer((size_t)MC * KC * sizeof(T));                  \
+    T *pb = (T *)aligned_buffer((size_t)KC * NC * sizeof(T));                  \
+    int mr = kern->mr, nr = kern->nr;                                          \
+                                                                               \
+    for (int i = 0; i < m; i++)                                                \
+        memset(c + (size_t)i * ldc, 0, n * sizeof(T));                         \
+                                                                               \
+    for (int jc = 0; jc < n; jc += NC) {                                       \
+        int nc = n - jc < NC ? n - jc : NC;                                    \
+        for (int pc = 0; pc < k; pc += KC) {                                   \
+            int kc = k - pc < KC ? k - pc : KC;                                \
+            pack_b_##suffix(kc, nc, b + (size_t)pc * ldb + jc, ldb, pb, nr);   \
+            for (int ic = 0; ic < m; ic += MC) {                               \
+                int mc = m - ic < MC ? m - ic : MC;                            \
+                pack_a_##suffix(mc, kc, a + (size_t)ic * lda + pc, lda,        \
+                                pa, mr);                                       \
+                for (int jr = 0; jr < nc; jr += nr) {                          \
+                    for (int ir = 0; ir < mc; ir += mr) {                      \
+                        kern->fn(kc, pa + (size_t)ir * kc,                     \
+                                 pb + (size_t)jr * kc,                         \
+                                 c + (size_t)(ic + ir) * ldc + jc + jr, ldc,   \
+                                 mc - ir < mr ? mc - ir : mr,                  \
+                                 nc - jr < nr ? nc - jr : nr);                 \
+                    }                                                          \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    free(pa);                                                                  \
+    free(pb);                                                                  \
+}
+
+DEFINE_GEMM(int, i32)
+DEFINE_GEMM(float, f32)
+DEFINE_GEMM(double, f64)
+
+/**
+ * Adds a full register tile (spilled to `tile`, row-major MR x NR) into the
+ * valid mr x nr corner of C. Used only for edge tiles.
+ */
+#define ADD_EDGE_TILE(tile, NR, c, ldc, mr, nr)                                \
+    for (int i_ = 0; i_ < (mr); i_++)                                          \
+        for (int j_ = 0; j_ < (nr); j_++)                                      \
+            (c)[(size_t)i_ * (ldc) + j_] += (tile)[i_ * (NR) + j_];
+
+/* ---------- AVX2 micro-kernels ---------- */
+
+#if HAVE_X86_KERNELS
+
+// 6 x 16 floats: 12 ymm accumulators, 2 ymm for B, 1 broadcast register
+__attribute__((target("avx2,fma")))
+void kernel_avx2_f32(int kc, const float *a, const float *b, float *c, int ldc,
+                     int mr, int nr) {
+    __m256 acc[6][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 6; i++)
+        acc[i][0] = acc[i][1] = _mm256_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m256 b0 = _mm256_load_ps(b);
+        __m256 b1 = _mm256_load_ps(b + 8);
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            __m256 ai = _mm256_broadcast_ss(a + i);
+            acc[i][0] = _mm256_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += 6;
+        b += 16;
+    }
+
+    if (mr == 6 && nr == 16) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            float *row = c + (size_t)i * ldc;
+            _mm256_storeu_ps(row, _mm256_add_ps(_mm256_loadu_ps(row), acc[i][0]));
+            _mm256_storeu_ps(row + 8, _mm256_add_ps(_mm256_loadu_ps(row + 8), acc[i][1]));
+        }
+    } else {
+        float tile[6 * 16] __attribute__((aligned(32)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            _mm256_store_ps(tile + i * 16, acc[i][0]);
+            _mm256_store_ps(tile + i * 16 + 8, acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 16, c, ldc, mr, nr)
+    }
+}
+
+// 6 x 8 doubles: 12 ymm accumulators
+__attribute__((target("avx2,fma")))
+void kernel_avx2_f64(int kc, const double *a, const double *b, double *c, int ldc,
+                     int mr, int nr) {
+    __m256d acc[6][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 6; i++)
+        acc[i][0] = acc[i][1] = _mm256_setzero_pd();
+
+    for (int p = 0; p < kc; p++) {
+        __m256d b0 = _mm256_load_pd(b);
+        __m256d b1 = _mm256_load_pd(b + 4);
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            __m256d ai = _mm256_broadcast_sd(a + i);
+            acc[i][0] = _mm256_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm256_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += 6;
+        b += 8;
+    }
+
+    if (mr == 6 && nr == 8) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            double *row = c + (size_t)i * ldc;
+            _mm256_storeu_pd(row, _mm256_add_pd(_mm256_loadu_pd(row), acc[i][0]));
+            _mm256_storeu_pd(row + 4, _mm256_add_pd(_mm256_loadu_pd(row + 4), acc[i][1]));
+        }
+    } else {
+        double tile[6 * 8] __attribute__((aligned(32)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            _mm256_store_pd(tile + i * 8, acc[i][0]);
+            _mm256_store_pd(tile + i * 8 + 4, acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 8, c, ldc, mr, nr)
+    }
+}
+
+// 6 x 16 int32: there is no integer FMA, so multiply then add
+__attribute__((target("avx2")))
+void kernel_avx2_i32(int kc, const int *a, const int *b, int *c, int ldc,
+                     int mr, int nr) {
+    __m256i acc[6][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 6; i++)
+        acc[i][0] = acc[i][1] = _mm256_setzero_si256();
+
+    for (int p = 0; p < kc; p++) {
+        __m256i b0 = _mm256_load_si256((const __m256i *)b);
+        __m256i b1 = _mm256_load_si256((const __m256i *)(b + 8));
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            __m256i ai = _mm256_set1_epi32(a[i]);
+            acc[i][0] = _mm256_add_epi32(acc[i][0], _mm256_mullo_epi32(ai, b0));
+            acc[i][1] = _mm256_add_epi32(acc[i][1], _mm256_mullo_epi32(ai, b1));
+        }
+        a += 6;
+        b += 16;
+    }
+
+    if (mr == 6 && nr == 16) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            __m256i *row = (__m256i *)(c + (size_t)i * ldc);
+            _mm256_storeu_si256(row, _mm256_add_epi32(_mm256_loadu_si256(row), acc[i][0]));
+            _mm256_storeu_si256(row + 1, _mm256_add_epi32(_mm256_loadu_si256(row + 1), acc[i][1]));
+        }
+    } else {
+        int tile[6 * 16] __attribute__((aligned(32)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 6; i++) {
+            _mm256_store_si256((__m256i *)(tile + i * 16), acc[i][0]);
+            _mm256_store_si256((__m256i *)(tile + i * 16 + 8), acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 16, c, ldc, mr, nr)
+    }
+}
+
+/* ---------- AVX-512 micro-kernels ---------- */
+
+// 8 x 32 floats: 16 zmm accumulators
+__attribute__((target("avx512f")))
+void kernel_avx512_f32(int kc, const float *a, const float *b, float *c, int ldc,
+                       int mr, int nr) {
+    __m512 acc[8][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++)
+        acc[i][0] = acc[i][1] = _mm512_setzero_ps();
+
+    for (int p = 0; p < kc; p++) {
+        __m512 b0 = _mm512_load_ps(b);
+        __m512 b1 = _mm512_load_ps(b + 16);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            __m512 ai = _mm512_set1_ps(a[i]);
+            acc[i][0] = _mm512_fmadd_ps(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_ps(ai, b1, acc[i][1]);
+        }
+        a += 8;
+        b += 32;
+    }
+
+    if (mr == 8 && nr == 32) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            float *row = c + (size_t)i * ldc;
+            _mm512_storeu_ps(row, _mm512_add_ps(_mm512_loadu_ps(row), acc[i][0]));
+            _mm512_storeu_ps(row + 16, _mm512_add_ps(_mm512_loadu_ps(row + 16), acc[i][1]));
+        }
+    } else {
+        float tile[8 * 32] __attribute__((aligned(64)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            _mm512_store_ps(tile + i * 32, acc[i][0]);
+            _mm512_store_ps(tile + i * 32 + 16, acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 32, c, ldc, mr, nr)
+    }
+}
+
+// 8 x 16 doubles: 16 zmm accumulators
+__attribute__((target("avx512f")))
+void kernel_avx512_f64(int kc, const double *a, const double *b, double *c, int ldc,
+                       int mr, int nr) {
+    __m512d acc[8][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++)
+        acc[i][0] = acc[i][1] = _mm512_setzero_pd();
+
+    for (int p = 0; p < kc; p++) {
+        __m512d b0 = _mm512_load_pd(b);
+        __m512d b1 = _mm512_load_pd(b + 8);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            __m512d ai = _mm512_set1_pd(a[i]);
+            acc[i][0] = _mm512_fmadd_pd(ai, b0, acc[i][0]);
+            acc[i][1] = _mm512_fmadd_pd(ai, b1, acc[i][1]);
+        }
+        a += 8;
+        b += 16;
+    }
+
+    if (mr == 8 && nr == 16) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            double *row = c + (size_t)i * ldc;
+            _mm512_storeu_pd(row, _mm512_add_pd(_mm512_loadu_pd(row), acc[i][0]));
+            _mm512_storeu_pd(row + 8, _mm512_add_pd(_mm512_loadu_pd(row + 8), acc[i][1]));
+        }
+    } else {
+        double tile[8 * 16] __attribute__((aligned(64)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            _mm512_store_pd(tile + i * 16, acc[i][0]);
+            _mm512_store_pd(tile + i * 16 + 8, acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 16, c, ldc, mr, nr)
+    }
+}
+
+// 8 x 32 int32: 16 zmm accumulators
+__attribute__((target("avx512f")))
+void kernel_avx512_i32(int kc, const int *a, const int *b, int *c, int ldc,
+                       int mr, int nr) {
+    __m512i acc[8][2];
+#pragma GCC unroll 8
+    for (int i = 0; i < 8; i++)
+        acc[i][0] = acc[i][1] = _mm512_setzero_si512();
+
+    for (int p = 0; p < kc; p++) {
+        __m512i b0 = _mm512_load_si512(b);
+        __m512i b1 = _mm512_load_si512(b + 16);
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            __m512i ai = _mm512_set1_epi32(a[i]);
+            acc[i][0] = _mm512_add_epi32(acc[i][0], _mm512_mullo_epi32(ai, b0));
+            acc[i][1] = _mm512_add_epi32(acc[i][1], _mm512_mullo_epi32(ai, b1));
+        }
+        a += 8;
+        b += 32;
+    }
+
+    if (mr == 8 && nr == 32) {
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            int *row = c + (size_t)i * ldc;
+            _mm512_storeu_si512(row, _mm512_add_epi32(_mm512_loadu_si512(row), acc[i][0]));
+            _mm512_storeu_si512(row + 16, _mm512_add_epi32(_mm512_loadu_si512(row + 16), acc[i][1]));
+        }
+    } else {
+        int tile[8 * 32] __attribute__((aligned(64)));
+#pragma GCC unroll 8
+        for (int i = 0; i < 8; i++) {
+            _mm512_store_si512(tile + i * 32, acc[i][0]);
+            _mm512_store_si512(tile + i * 32 + 16, acc[i][1]);
+        }
+        ADD_EDGE_TILE(tile, 32, c, ldc, mr, nr)
+    }
+}
+
+#endif /* HAVE_X86_KERNELS */
+
+/* ---------- Kernel tables and dispatch ---------- */
+
+#if HAVE_X86_KERNELS
+const GemmKernel_i32 kernels_i32[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_i32 }, { 6, 16, kernel_avx2_i32 }, { 8, 32, kernel_avx512_i32 } };
+const GemmKernel_f32 kernels_f32[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_f32 }, { 6, 16, kernel_avx2_f32 }, { 8, 32, kernel_avx512_f32 } };
+const GemmKernel_f64 kernels_f64[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_f64 }, { 6, 8, kernel_avx2_f64 }, { 8, 16, kernel_avx512_f64 } };
+#else
+const GemmKernel_i32 kernels_i32[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_i32 }, { 4, 4, kernel_scalar_i32 }, { 4, 4, kernel_scalar_i32 } };
+const GemmKernel_f32 kernels_f32[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_f32 }, { 4, 4, kernel_scalar_f32 }, { 4, 4, kernel_scalar_f32 } };
+const GemmKernel_f64 kernels_f64[ISA_COUNT] = {
+    { 4, 4, kernel_scalar_f64 }, { 4, 4, kernel_scalar_f64 }, { 4, 4, kernel_scalar_f64 } };
+#endif
+
+/**
+ * @brief Public entry points: C = A * B using the best kernel for this CPU.
+ */
+void sgemm(int m, int n, int k, const float *a, int lda, const float *b, int ldb,
+           float *c, int ldc) {
+    gemm_f32(&kernels_f32[best_isa()], m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+void dgemm(int m, int n, int k, const double *a, int lda, const double *b, int ldb,
+           double *c, int ldc) {
+    gemm_f64(&kernels_f64[best_isa()], m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+void igemm(int m, int n, int k, const int *a, int lda, const int *b, int ldb,
+           int *c, int ldc) {
+    gemm_i32(&kernels_i32[best_isa()], m, n, k, a, lda, b, ldb, c, ldc);
+}
+
+/* ---------- Peak measurement ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+#define PEAK_ITERS 20000000
+
+#if HAVE_X86_KERNELS
+// Twelve independent FMA chains hide FMA latency on both FMA ports
+__attribute__((target("avx2,fma")))
+double peak_avx2(int dbl) {
+    __m256 acc[12];
+    __m256 x = _mm256_set1_ps(1.0f), y = _mm256_set1_ps(1e-7f);
+    for (int i = 0; i < 12; i++) acc[i] = _mm256_set1_ps((float)i);
+    double t0 = now_seconds();
+    for (long it = 0; it < PEAK_ITERS; it++) {
+#pragma GCC unroll 12
+        for (int i = 0; i < 12; i++) acc[i] = _mm256_fmadd_ps(acc[i], x, y);
+    }
+    double t = now_seconds() - t0;
+    float sink[8];
+    for (int i = 1; i < 12; i++) acc[0] = _mm256_add_ps(acc[0], acc[i]);
+    _mm256_storeu_ps(sink, acc[0]);
+    if (sink[0] == 42.0f) printf(" ");
+    return 12.0 * PEAK_ITERS * (dbl ? 4 : 8) * 2 / t / 1e9;
+}
+
+__attribute__((target("avx512f")))
+double peak_avx512(int dbl) {
+    __m512 acc[12];
+    __m512 x = _mm512_set1_ps(1.0f), y = _mm512_set1_ps(1e-7f);
+    for (int i = 0; i < 12; i++) acc[i] = _mm512_set1_ps((float)i);
+    double t0 = now_seconds();
+    for (long it = 0; it < PEAK_ITERS; it++) {
+#pragma GCC unroll 12
+        for (int i = 0; i < 12; i++) acc[i] = _mm512_fmadd_ps(acc[i], x, y);
+    }
+    double t = now_seconds() - t0;
+    for (int i = 1; i < 12; i++) acc[0] = _mm512_add_ps(acc[0], acc[i]);
+    if (_mm512_reduce_add_ps(acc[0]) == 42.0f) printf(" ");
+    return 12.0 * PEAK_ITERS * (dbl ? 8 : 16) * 2 / t / 1e9;
+}
+#endif
+
+/**
+ * @brief Measured single-core FMA throughput in GFLOP/s (0 if unknown).
+ *
+ * Double-precision FMAs run at the same rate as single-precision ones, so
+ * the double peak is half the float peak for the same vector width.
+ */
+double measured_peak(Isa isa, int dbl) {
+#if HAVE_X86_KERNELS
+    if (isa == ISA_AVX2) return peak_avx2(dbl);
+    if (isa == ISA_AVX512) return peak_avx512(dbl);
+#endif
+    (void)isa; (void)dbl;
+    return 0.0;
+}
+
+/* ---------- Benchmark ---------- */
+
+typedef struct {
+    const char *name;
+    int m, n, k;
+} Shape;
+
+const Shape shapes[] = {
+    { "square 512", 512, 512, 512 },
+    { "square 1024", 1024, 1024, 1024 },
+    { "square 2048", 2048, 2048, 2048 },
+    { "tall-skinny A", 16384, 64, 64 },
+    { "tall-skinny C", 8192, 16, 1024 },
+};
+
+#define SHAPE_COUNT ((int)(sizeof(shapes) / sizeof(shapes[0])))
+
+/**
+ * @brief Times one shape for one type/ISA (best of three runs) and checks a
+ * sample of entries against a naive dot product.
+ */
+#define DEFINE_BENCH(T, suffix, TOL)                                           \
+double bench_##suffix(Isa isa, const Shape *s, int *ok) {                      \
+    T *a = (T *)aligned_buffer((size_t)s->m * s->k * sizeof(T));               \
+    T *b = (T *)aligned_buffer((size_t)s->k * s->n * sizeof(T));               \
+    T *c = (T *)aligned_buffer((size_t)s->m * s->n * sizeof(T));               \
+    for (size_t i = 0; i < (size_t)s->m * s->k; i++) a[i] = (T)(rand() % 7 - 3); \
+    for (size_t i = 0; i < (size_t)s->k * s->n; i++) b[i] = (T)(rand() % 7 - 3); \
+                                                                               \
+    double t = 1e30;                                                           \
+    for (int rep = 0; rep < 3; rep++) { /* best of 3, first run warms up */    \
+        double t0 = now_seconds();                                             \
+        gemm_##suffix(&kernels_##suffix[isa], s->m, s->n, s->k,                \
+                      a, s->k, b, s->n, c, s->n);                              \
+        double elapsed = now_seconds() - t0;                                   \
+        if (elapsed < t) t = elapsed;                                          \
+    }                                                                          \
+                                                                               \
+    *ok = 1;                                                                   \
+    for (int trial = 0; trial < 64; trial++) {                                 \
+        int i = rand() % s->m, j = rand() % s->n;                              \
+        T ref = 0;                                                             \
+        for (int p = 0; p < s->k; p++)                                         \
+            ref += a[(size_t)i * s->k + p] * b[(size_t)p * s->n + j];          \
+        if (fabs((double)ref - (double)c[(size_t)i * s->n + j]) > (TOL)) *ok = 0; \
+    }                                                                          \
+    free(a);                                                                   \
+    free(b);                                                                   \
+    free(c);                                                                   \
+    return 2.0 * s->m * s->n * s->k / t / 1e9;                                 \
+}
+
+DEFINE_BENCH(int, i32, 0)
+DEFINE_BENCH(float, f32, 1e-2)
+DEFINE_BENCH(double, f64, 1e-9)
+
+int main(int argc, char *argv[]) {
+    int only = -1;
+    if (argc > 1) {
+        for (int isa = 0; isa < ISA_COUNT; isa++)
+            if (strcmp(argv[1], isa_names[isa]) == 0) only = isa;
+        if (only < 0) {
+            fprintf(stderr, "Usage: %s [scalar|avx2|avx512]\n", argv[0]);
+            return 1;
+        }
+        if (!isa_supported((Isa)only)) {
+            fprintf(stderr, "Error: this CPU does not support %s.\n", argv[1]);
+            return 1;
+        }
+    }
+
+    printf("Runtime dispatch selects: %s\n", isa_names[best_isa()]);
+    srand(42);
+
+    for (int isa = 0; isa < ISA_COUNT; isa++) {
+        if ((only >= 0 && isa != only) || !isa_supported((Isa)isa)) continue;
+
+        double peak_f32 = measured_peak((Isa)isa, 0);
+        double peak_f64 = measured_peak((Isa)isa, 1);
+        printf("\n[%s] measured FMA peak: %.1f GFLOP/s (float), %.1f GFLOP/s (double)\n",
+               isa_names[isa], peak_f32, peak_f64);
+        printf("%-16s %12s %12s %8s %12s %8s\n",
+               "shape", "int32 GOP/s", "float GF/s", "% peak", "double GF/s", "% peak");
+
+        for (int s = 0; s < SHAPE_COUNT; s++) {
+            int ok_i, ok_f, ok_d;
+            double gi = bench_i32((Isa)isa, &shapes[s], &ok_i);
+            double gf = bench_f32((Isa)isa, &shapes[s], &ok_f);
+            double gd = bench_f64((Isa)isa, &shapes[s], &ok_d);
+            printf("%-16s %12.2f %12.2f %7.1f%% %12.2f %7.1f%%%s\n", shapes[s].name,
+                   gi, gf, peak_f32 > 0 ? 100.0 * gf / peak_f32 : 0.0,
+                   gd, peak_f64 > 0 ? 100.0 * gd / peak_f64 : 0.0,
+                   ok_i && ok_f && ok_d ? "" : "  RESULT MISMATCH");
+        }
+    }
+    return 0;
+}
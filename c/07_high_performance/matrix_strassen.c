@@ -0,0 +1,348 @@
+/**
+ * @file matrix_strassen.c
+ * @brief Cache-oblivious recursive multiply with an optional Strassen-Winograd layer.
+ *
+ * This program demonstrates:
+ * 1. Cache-oblivious divide and conquer: always halve the largest dimension
+ * 2. Strassen-Winograd (7 multiplications, 15 additions) above a crossover
+ * 3. Dynamic peeling to handle odd matrix sizes without padding
+ * 4. An arena allocator: all temporaries come from one up-front allocation
+ * 5. Finding the Strassen crossover size on the current machine
+ *
+ * Usage:
+ * gcc -O3 -march=native matrix_strassen.c -o strassen -lm
+ * ./strassen            (crossover search and comparison up to n = 2048)
+ * ./strassen 4096       (larger maximum size)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#define CO_LEAF 32            // Leaf size of the cache-oblivious recursion
+
+/**
+ * A row-major view into a matrix: element (i, j) is p[i * ld + j].
+ * Views let the recursion address quadrants without copying.
+ */
+typedef struct {
+    double *p;
+    int ld;
+} View;
+
+View sub_view(View v, int row, int col) {
+    View s = { v.p + (size_t)row * v.ld + col, v.ld };
+    return s;
+}
+
+#define AT(v, i, j) ((v).p[(size_t)(i) * (v).ld + (j)])
+
+/* ---------- Arena allocator ---------- */
+
+/**
+ * A bump allocator. Allocations are released in LIFO order by restoring a
+ * previously saved `used` mark, which matches the recursion's lifetimes.
+ */
+typedef struct {
+    double *base;
+    size_t capacity;
+    size_t used;
+} Arena;
+
+int arena_init(Arena *arena, size_t doubles) {
+    arena->base = (double *)malloc((doubles ? doubles : 1) * sizeof(double));
+    arena->capacity = doubles;
+    arena->used = 0;
+    return arena->base != NULL;
+}
+
+double *arena_alloc(Arena *arena, size_t doubles) {
+    if (arena->used + doubles > arena->capacity) {
+        fprintf(stderr, "Error: arena exhausted (%zu of %zu doubles in use)\n",
+                arena->used, arena->capacity);
+        exit(1);
+    }
+    double *p = arena->base + arena->used;
+    arena->used += doubles;
+    return p;
+}
+
+void arena_free(Arena *arena) {
+    free(arena->base);
+    arena->base = NULL;
+    arena->capacity = arena->used = 0;
+}
+
+/* ---------- Classical cache-oblivious multiply ---------- */
+
+/**
+ * @brief C += A * B for an m x k by k x n product.
+ *
+ * Splits whichever of m, n, k is largest until every dimension fits a
+ * CO_LEAF block, so each level of the cache hierarchy is used well without
+ * knowing its size.
+ */
+void co_multiply_add(View c, View a, View b, int m, int k, int n) {
+    if (m <= CO_LEAF && n <= CO_LEAF && k <= CO_LEAF) {
+        for (int i = 0; i < m; i++) {
+            double *restrict c_row = &AT(c, i, 0);
+            for (int p = 0; p < k; p++) {
+                double a_ip = AT(a, i, p);
+                const double *restrict b_row = &AT(b, p, 0);
+                for (int j = 0; j < n; j++)
+                    c_row[j] += a_ip * b_row[j];
+            }
+        }
+        return;
+    }
+
+    if (m >= n && m >= k) {
+        int h = m / 2;
+        co_multiply_add(c, a, b, h, k, n);
+        co_multiply_add(sub_view(c, h, 0), sub_view(a, h, 0), b, m - h, k, n);
+    } else if (n >= k) {
+        int h = n / 2;
+        co_multiply_add(c, a, b, m, k, h);
+        co_multiply_add(sub_view(c, 0, h), a, sub_view(b, 0, h), m, k, n - h);
+    } else {
+        int h = k / 2;
+        co_multiply_add(c, a, b, m, h, n);
+        co_multiply_add(c, sub_view(a, 0, h), sub_view(b, h, 0), m, k - h, n);
+    }
+}
+
+/**
+ * @brief C = A * B (overwriting C) with the cache-oblivious recursion.
+ */
+void co_multiply(View c, View a, View b, int m, int k, int n) {
+    for (int i = 0; i < m; i++)
+        memset(&AT(c, i, 0), 0, n * sizeof(double));
+    co_multiply_add(c, a, b, m, k, n);
+}
+
+/* ---------- Strassen-Winograd ---------- */
+
+// dst = x + sign * y for h x h blocks
+void block_add(View dst, View x, View y, int h, double sign) {
+    for (int i = 0; i < h; i++) {
+        double *restrict d = &AT(dst, i, 0);
+        const double *xr = &AT(x, i, 0), *yr = &AT(y, i, 0);
+        for (int j = 0; j < h; j++)
+            d[j] = xr[j] + sign * yr[j];
+    }
+}
+
+/**
+ * @brief Scratch doubles needed by strassen_multiply for size n.
+ */
+size_t strassen_scratch(int n, int crossover) {
+    if (n <= crossover) return 0;
+    int h = (n - (n & 1)) / 2;
+    size_t peel = (n & 1) ? (size_t)n : 0;
+    size_t level = 3 * (size_t)h * h > peel ? 3 * (size_t)h * h : peel;
+    return level + strassen_scratch(h, crossover);
+}
+
+/**
+ * @brief C = A * B for n x n matrices using Strassen-Winograd recursion.
+ *
+ * Uses the 7-multiplication Winograd variant with the Douglas et al.
+ * schedule, which needs only three h x h temporaries (X, Y, Z) per level;
+ * the seven products are written straight into C's quadrants. For odd n the
+ * last row and column are peeled off and fixed up with O(n^2) work.
+ */
+void strassen_multiply(View c, View a, View b, int n, int crossover, Arena *arena) {
+    if (n <= crossover) {
+        co_multiply(c, a, b, n, n, n);
+        return;
+    }
+
+    int even = n - (n & 1);
+    int h = even / 2;
+    size_t mark = arena->used;
+    View x = { arena_alloc(arena, (size_t)h * h), h };
+    View y = { arena_alloc(arena, (size_t)h * h), h };
+    View z = { arena_alloc(arena, (size_t)h * h), h };
+
+    View a11 = a, a12 = sub_view(a, 0, h), a21 = sub_view(a, h, 0), a22 = sub_view(a, h, h);
+    View b11 = b, b12 = sub_view(b, 0, h), b21 = sub_view(b, h, 0), b22 = sub_view(b, h, h);
+    View c11 = c, c12 = sub_view(c, 0, h), c21 = sub_view(c, h, 0), c22 = sub_view(c, h, h);
+
+    block_add(x, a11, a21, h, -1.0);                  // S3 = A11 - A21
+    block_add(y, b22, b12, h, -1.0);                  // T3 = B22 - B12
+    strassen_multiply(c21, x, y, h, crossover, arena);    // P7 = S3 * T3
+    block_add(x, a21, a22, h, 1.0);                   // S1 = A21 + A22
+    block_add(y, b12, b11, h, -1.0);                  // T1 = B12 - B11
+    strassen_multiply(c22, x, y, h, crossover, arena);    // P5 = S1 * T1
+    block_add(x, x, a11, h, -1.0);                    // S2 = S1 - A11
+    block_add(y, b22, y, h, -1.0);                    // T2 = B22 - T1
+    strassen_multiply(c12, x, y, h, crossover, arena);    // P6 = S2 * T2
+    block_add(x, a12, x, h, -1.0);                    // S4 = A12 - S2
+    strassen_multiply(c11, x, b22, h, crossover, arena);  // P3 = S4 * B22
+    strassen_multiply(z, a11, b11, h, crossover, arena);  // P1 = A11 * B11
+    block_add(c12, c12, z, h, 1.0);                   // U2 = P1 + P6
+    block_add(c21, c21, c12, h, 1.0);                 // U3 = U2 + P7
+    block_add(c12, c12, c22, h, 1.0);                 // U4 = U2 + P5
+    block_add(c22, c22, c21, h, 1.0);                 // C22 = U3 + P5
+    block_add(c12, c12, c11, h, 1.0);                 // C12 = U4 + P3
+    block_add(y, y, b21, h, -1.0);                    // T4 = T2 - B21
+    strassen_multiply(c11, a22, y, h, crossover, arena);  // P4 = A22 * T4
+    block_add(c21, c21, c11, h, -1.0);                // C21 = U3 - P4
+    strassen_multiply(c11, a12, b21, h, crossover, arena); // P2 = A12 * B21
+    block_add(c11, c11, z, h, 1.0);                   // C11 = P1 + P2
+
+    arena->used = mark;
+
+    if (n & 1) {
+        int last = n - 1;
+        // Leading block still misses the rank-1 term A[:even, last] * B[last, :even]
+        for (int i = 0; i < even; i++) {
+            double a_il = AT(a, i, last);
+            for (int j = 0; j < even; j++)
+                AT(c, i, j) += a_il * AT(b, last, j);
+        }
+        // Last column: copy B's column once so each dot product is unit-stride
+        double *b_col = arena_alloc(arena, n);
+        for (int p = 0; p < n; p++) b_col[p] = AT(b, p, last);
+        for (int i = 0; i < n; i++) {
+            const double *a_row = &AT(a, i, 0);
+            double sum = 0.0;
+            for (int p = 0; p < n; p++) sum += a_row[p] * b_col[p];
+            AT(c, i, last) = sum;
+        }
+        arena->used = mark;
+
+        // Last row: accumulate rows of B scaled by A's last row
+        double *c_row = &AT(c, last, 0);
+        memset(c_row, 0, last * sizeof(double));
+        for (int p = 0; p < n; p++) {
+            double a_lp = AT(a, last, p);
+            const double *b_row = &AT(b, p, 0);
+            for (int j = 0; j < last; j++) c_row[j] += a_lp * b_row[j];
+        }
+    }
+}
+
+/**
+ * @brief Convenience wrapper that sizes and owns the arena for one call.
+ */
+int multiply_strassen(double *c, const double *a, const double *b, int n, int crossover) {
+    Arena arena;
+    if (!arena_init(&arena, strassen_scratch(n, crossover))) return 0;
+    View vc = { c, n }, va = { (double *)a, n }, vb = { (double *)b, n };
+    strassen_multiply(vc, va, vb, n, crossover, &arena);
+    arena_free(&arena);
+    return 1;
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double max_abs_diff(const double *x, const double *y, size_t count) {
+    double worst = 0.0;
+    for (size_t i = 0; i < count; i++)
+        if (fabs(x[i] - y[i]) > worst) worst = fabs(x[i] - y[i]);
+    return worst;
+}
+
+/**
+ * Small sizes are repeated (up to 5 runs or 0.2 s) and the fastest run is
+ * kept, so the crossover search is not decided by timer noise.
+ */
+double time_classical(double *c, double *a, double *b, int n) {
+    View vc = { c, n }, va = { a, n }, vb = { b, n };
+    double best = 1e30, total = 0.0;
+    for (int rep = 0; rep < 5 && total < 0.2; rep++) {
+        double t0 = now_seconds();
+        co_multiply(vc, va, vb, n, n, n);
+        double t = now_seconds() - t0;
+        total += t;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+double time_strassen(double *c, const double *a, const double *b, int n, int crossover) {
+    double best = 1e30, total = 0.0;
+    for (int rep = 0; rep < 5 && total < 0.2; rep++) {
+        double t0 = now_seconds();
+        if (!multiply_strassen(c, a, b, n, crossover)) {
+            fprintf(stderr, "Memory allocation failed.\n");
+            exit(1);
+        }
+        double t = now_seconds() - t0;
+        total += t;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int max_n = argc > 1 ? atoi(argv[1]) : 2048;
+    if (max_n < 64) {
+        fprintf(stderr, "Usage: %s [max_n >= 64]\n", argv[0]);
+        return 1;
+    }
+
+    size_t count = (size_t)max_n * max_n;
+    double *a = (double *)malloc(count * sizeof(double));
+    double *b = (double *)malloc(count * sizeof(double));
+    double *ref = (double *)malloc(count * sizeof(double));
+    double *out = (double *)malloc(count * sizeof(double));
+    if (!a || !b || !ref || !out) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        return 1;
+    }
+    srand(7);
+    for (size_t i = 0; i < count; i++) {
+        a[i] = (double)rand() / RAND_MAX - 0.5;
+        b[i] = (double)rand() / RAND_MAX - 0.5;
+    }
+
+    // Step 1: where does a single Strassen level start to pay off?
+    printf("One Strassen level vs classical recursion (crossover search):\n");
+    printf("%6s %14s %14s %10s %12s\n", "n", "classical ms", "1-level ms", "ratio", "max error");
+    int crossover = 0;
+    for (int n = 64; n <= max_n; n *= 2) {
+        double tc = time_classical(ref, a, b, n);
+        double ts = time_strassen(out, a, b, n, n / 2);
+        printf("%6d %14.2f %14.2f %10.3f %12.2e\n", n, tc * 1e3, ts * 1e3, ts / tc,
+               max_abs_diff(ref, out, (size_t)n * n));
+        // Recurse only on halves that are themselves past the break-even size
+        if (crossover == 0 && ts < tc) crossover = n / 2;
+    }
+    if (crossover == 0) {
+        crossover = max_n;
+        printf("Strassen never won up to n = %d; classical is used throughout.\n", max_n);
+    } else {
+        printf("Measured crossover: recurse while n > %d\n", crossover);
+    }
+
+    // Step 2: full recursion with the measured crossover, plus odd sizes
+    printf("\nFull Strassen-Winograd (crossover %d) vs classical:\n", crossover);
+    printf("%6s %14s %14s %10s %12s %12s\n", "n", "classical ms", "strassen ms", "speedup",
+           "max error", "arena MB");
+    int sizes[] = { max_n / 4, max_n / 2 + 1, max_n / 2, max_n - 1, max_n };
+    for (int s = 0; s < (int)(sizeof(sizes) / sizeof(sizes[0])); s++) {
+        int n = sizes[s];
+        double tc = time_classical(ref, a, b, n);
+        double ts = time_strassen(out, a, b, n, crossover);
+        printf("%6d %14.2f %14.2f %9.2fx %12.2e %12.2f\n", n, tc * 1e3, ts * 1e3, tc / ts,
+               max_abs_diff(ref, out, (size_t)n * n),
+               strassen_scratch(n, crossover) * sizeof(double) / 1048576.0);
+    }
+
+    free(a);
+    free(b);
+    free(ref);
+    free(out);
+    return 0;
+}
@@ -0,0 +1,641 @@
+/**
+ * @file sparse_matrix.c
+ * @brief Sparse matrices in COO and CSR form with multi-threaded kernels.
+ *
+ * This program demonstrates:
+ * 1. Coordinate (COO) and Compressed Sparse Row (CSR) storage
+ * 2. Loading Matrix Market (.mtx) files, including symmetric and pattern files
+ * 3. SpMV (y = A x) and SpMM with a dense right-hand side (Y = A X)
+ * 4. SpGEMM (C = A B) using Gustavson's row-by-row algorithm with a dense
+ *    per-thread accumulator, in a symbolic (count) and numeric (fill) phase
+ * 5. Splitting rows across threads so every thread gets a similar nnz count
+ * 6. Comparing sparse and dense multiplication as density increases
+ *
+ * Usage:
+ * gcc -O3 -march=native -pthread sparse_matrix.c -o sparse_matrix
+ * ./sparse_matrix                   (density sweep on random 2048 x 2048 matrices)
+ * ./sparse_matrix 4096 8            (size 4096, 8 threads)
+ * ./sparse_matrix matrix.mtx [threads]   (benchmark a Matrix Market file)
+ */
+
+#define _POSIX_C_SOURCE 199309L
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#define SPMM_RHS_COLS 64   // Columns of the dense right-hand side in SpMM
+#define MAX_THREADS 256
+
+typedef struct {
+    int rows, cols;
+    long long nnz;
+    int *row;
+    int *col;
+    double *val;
+} CooMatrix;
+
+typedef struct {
+    int rows, cols;
+    long long nnz;
+    long long *row_ptr;  // rows + 1 offsets into col_idx / val
+    int *col_idx;
+    double *val;
+} CsrMatrix;
+
+void *xmalloc(size_t bytes) {
+    void *p = malloc(bytes ? bytes : 1);
+    if (p == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    return p;
+}
+
+void free_coo(CooMatrix *m) {
+    free(m->row);
+    free(m->col);
+    free(m->val);
+}
+
+void free_csr(CsrMatrix *m) {
+    free(m->row_ptr);
+    free(m->col_idx);
+    free(m->val);
+}
+
+/* ---------- Construction ---------- */
+
+/**
+ * @brief Converts COO to CSR with a counting sort on rows.
+ *
+ * Columns are sorted within each row and duplicate entries are summed, as
+ * Matrix Market files and random generators may both produce duplicates.
+ */
+CsrMatrix coo_to_csr(const CooMatrix *coo) {
+    CsrMatrix csr;
+    csr.rows = coo->rows;
+    csr.cols = coo->cols;
+    csr.row_ptr = (long long *)calloc(coo->rows + 1, sizeof(long long));
+    int *col = (int *)xmalloc(coo->nnz * sizeof(int));
+    double *val = (double *)xmalloc(coo->nnz * sizeof(double));
+    if (csr.row_ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    for (long long e = 0; e < coo->nnz; e++) csr.row_ptr[coo->row[e] + 1]++;
+    for (int i = 0; i < coo->rows; i++) csr.row_ptr[i + 1] += csr.row_ptr[i];
+
+    long long *next = (long long *)xmalloc(coo->rows * sizeof(long long));
+    memcpy(next, csr.row_ptr, coo->rows * sizeof(long long));
+    for (long long e = 0; e < coo->nnz; e++) {
+        long long at = next[coo->row[e]]++;
+        col[at] = coo->col[e];
+        val[at] = coo->val[e];
+    }
+    free(next);
+
+    // Sort each row by column (insertion sort: rows are short) and merge duplicates
+    long long out = 0;
+    for (int i = 0; i < coo->rows; i++) {
+        long long begin = csr.row_ptr[i], end = csr.row_ptr[i + 1];
+        for (long long a = begin + 1; a < end; a++) {
+            int c = col[a];
+            double v = val[a];
+            long long b = a - 1;
+            while (b >= begin && col[b] > c) {
+                col[b + 1] = col[b];
+                val[b + 1] = val[b];
+                b--;
+            }
+            col[b + 1] = c;
+            val[b + 1] = v;
+        }
+        csr.row_ptr[i] = out;
+        for (long long a = begin; a < end; a++) {
+            if (out > csr.row_ptr[i] && col[out - 1] == col[a]) {
+                val[out - 1] += val[a];
+            } else {
+                col[out] = col[a];
+                val[out] = val[a];
+                out++;
+            }
+        }
+    }
+    csr.row_ptr[coo->rows] = out;
+    csr.nnz = out;
+    csr.col_idx = col;
+    csr.val = val;
+    return csr;
+}
+
+/**
+ * @brief Random rows x cols COO matrix with about density * rows * cols entries.
+ */
+CooMatrix random_coo(int rows, int cols, double density, unsigned seed) {
+    CooMatrix m;
+    m.rows = rows;
+    m.cols = cols;
+    m.nnz = (long long)(density * rows * cols + 0.5);
+    if (m.nnz < 1) m.nnz = 1;
+    m.row = (int *)xmalloc(m.nnz * sizeof(int));
+    m.col = (int *)xmalloc(m.nnz * sizeof(int));
+    m.val = (double *)xmalloc(m.nnz * sizeof(double));
+
+    unsigned long long s = seed * 0x9E3779B97F4A7C15ULL + 1;
+    for (long long e = 0; e < m.nnz; e++) {
+        s ^= s << 13; s ^= s >> 7; s ^= s << 17;
+        m.row[e] = (int)(s % rows);
+        m.col[e] = (int)((s >> 32) % cols);
+        m.val[e] = (double)(s % 1000) / 500.0 - 1.0;
+    }
+    return m;
+}
+
+/**
+ * @brief Loads a Matrix Market coordinate file into COO form.
+ *
+ * Supports real/integer/pattern fields and general/symmetric/skew-symmetric
+ * storage; symmetric entries are expanded to both triangles.
+ *
+ * @return 1 on success, 0 on error (message already printed).
+ */
+int load_matrix_market(const char *filename, CooMatrix *m) {
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        perror("Error opening Matrix Market file");
+        return 0;
+    }
+
+    char line[1024], object[64], format[64], field[64], symmetry[64];
+    if (fgets(line, sizeof(line), fp) == NULL
+        || sscanf(line, "%%%%MatrixMarket %63s %63s %63s %63s", object, format, field, symmetry) != 4) {
+        fprintf(stderr, "Error: %s has no Matrix Market banner\n", filename);
+        fclose(fp);
+        return 0;
+    }
+    for (char *p = line; *p; p++) *p = (char)tolower((unsigned char)*p);
+    int pattern = strstr(line, "pattern") != NULL;
+    int symmetric = strstr(line, "symmetric") != NULL; // also skew-symmetric
+    int skew = strstr(line, "skew") != NULL;
+    if (strstr(line, "coordinate") == NULL || strstr(line, "complex") != NULL) {
+        fprintf(stderr, "Error: only real/integer/pattern coordinate matrices are supported\n");
+        fclose(fp);
+        return 0;
+    }
+
+    // Skip comments, then read the size line
+    long long entries;
+    do {
+        if (fgets(line, sizeof(line), fp) == NULL) {
+            fprintf(stderr, "Error: %s ends before the size line\n", filename);
+            fclose(fp);
+            return 0;
+        }
+    } while (line[0] == '%');
+    if (sscanf(line, "%d %d %lld", &m->rows, &m->cols, &entries) != 3
+        || m->rows <= 0 || m->cols <= 0 || entries < 0) {
+        fprintf(stderr, "Error: invalid size line in %s\n", filename);
+        fclose(fp);
+        return 0;
+    }
+
+    long long capacity = symmetric ? 2 * entries : entries;
+    m->row = (int *)xmalloc(capacity * sizeof(int));
+    m->col = (int *)xmalloc(capacity * sizeof(int));
+    m->val = (double *)xmalloc(capacity * sizeof(double));
+    m->nnz = 0;
+
+    for (long long e = 0; e < entries; e++) {
+        int i, j;
+        double v = 1.0;
+        int ok = pattern ? fscanf(fp, "%d %d", &i, &j) == 2
+                         : fscanf(fp, "%d %d %lf", &i, &j, &v) == 3;
+        if (!ok || i < 1 || i > m->rows || j < 1 || j > m->cols) {
+            fprintf(stderr, "Error: malformed entry %lld in %s\n", e + 1, filename);
+            fclose(fp);
+            free_coo(m);
+            return 0;
+        }
+        m->row[m->nnz] = i - 1;
+        m->col[m->nnz] = j - 1;
+        m->val[m->nnz++] = v;
+        if (symmetric && i != j) {
+            m->row[m->nnz] = j - 1;
+            m->col[m->nnz] = i - 1;
+            m->val[m->nnz++] = skew ? -v : v;
+        }
+    }
+    fclose(fp);
+    return 1;
+}
+
+/* ---------- Row partitioning across threads ---------- */
+
+typedef struct RowRange RowRange;
+typedef void (*row_task)(RowRange *range);
+
+struct RowRange {
+    int thread;
+    int row_begin, row_end;
+    row_task task;
+    void *ctx;
+};
+
+void *row_thread(void *arg) {
+    RowRange *range = (RowRange *)arg;
+    range->task(range);
+    return NULL;
+}
+
+/**
+ * @brief Runs task over all rows of `a`, split into contiguous row ranges
+ * holding roughly equal numbers of non-zeros (binary search on row_ptr).
+ */
+void parallel_rows(const CsrMatrix *a, int threads, row_task task, void *ctx) {
+    pthread_t tid[MAX_THREADS];
+    RowRange ranges[MAX_THREADS];
+    if (threads > MAX_THREADS) threads = MAX_THREADS;
+
+    int prev = 0;
+    for (int t = 0; t < threads; t++) {
+        long long target = a->nnz * (t + 1) / threads;
+        int lo = prev, hi = a->rows;
+        if (t == threads - 1) lo = a->rows;
+        while (lo < hi) {
+            int mid = lo + (hi - lo) / 2;
+            if (a->row_ptr[mid] < target) lo = mid + 1;
+            else hi = mid;
+        }
+        ranges[t].thread = t;
+        ranges[t].row_begin = prev;
+        ranges[t].row_end = lo;
+        ranges[t].task = task;
+        ranges[t].ctx = ctx;
+        prev = lo;
+    }
+
+    for (int t = 1; t < threads; t++)
+        if (pthread_create(&tid[t], NULL, row_thread, &ranges[t]) != 0) {
+            task(&ranges[t]); // Fall back to running it on this thread
+            tid[t] = 0;
+        }
+    task(&ranges[0]);
+    for (int t = 1; t < threads; t++)
+        if (tid[t]) pthread_join(tid[t], NULL);
+}
+
+/* ---------- SpMV and SpMM ---------- */
+
+typedef struct {
+    const CsrMatrix *a;
+    const double *x;
+    double *y;
+    int x_cols;   // Columns of X (1 for SpMV)
+} SpmmArgs;
+
+void spmm_rows(RowRange *r) {
+    SpmmArgs *args = (SpmmArgs *)r->ctx;
+    const CsrMatrix *a = args->a;
+    int nc = args->x_cols;
+
+    if (nc == 1) {
+        for (int i = r->row_begin; i < r->row_end; i++) {
+            double sum = 0.0;
+            for (long long e = a->row_ptr[i]; e < a->row_ptr[i + 1]; e++)
+                sum += a->val[e] * args->x[a->col_idx[e]];
+            args->y[i] = sum;
+        }
+        return;
+    }
+
+    // Each non-zero scales one contiguous row of X into the output row
+    for (int i = r->row_begin; i < r->row_end; i++) {
+        double *restrict y_row = args->y + (size_t)i * nc;
+        memset(y_row, 0, nc * sizeof(double));
+        for (long long e = a->row_ptr[i]; e < a->row_ptr[i + 1]; e++) {
+            double v = a->val[e];
+            const double *restrict x_row = args->x + (size_t)a->col_idx[e] * nc;
+            for (int j = 0; j < nc; j++)
+                y_row[j] += v * x_row[j];
+        }
+    }
+}
+
+/**
+ * @brief y = A x.
+ */
+void spmv(const CsrMatrix *a, const double *x, double *y, int threads) {
+    SpmmArgs args = { a, x, y, 1 };
+    parallel_rows(a, threads, spmm_rows, &args);
+}
+
+/**
+ * @brief Y = A X where X is a dense row-major a->cols x x_cols matrix.
+ */
+void spmm(const CsrMatrix *a, const double *x, int x_cols, double *y, int threads) {
+    SpmmArgs args = { a, x, y, x_cols };
+    parallel_rows(a, threads, spmm_rows, &args);
+}
+
+/* ---------- SpGEMM (Gustavson) ---------- */
+
+typedef struct {
+    const CsrMatrix *a;
+    const CsrMatrix *b;
+    CsrMatrix *c;
+    int phase;          // 0 = count non-zeros per row, 1 = fill values
+} SpgemmArgs;
+
+int compare_ints(const void *x, const void *y) {
+    int a = *(const int *)x, b = *(const int *)y;
+    return (a > b) - (a < b);
+}
+
+/**
+ * Row i of C is the sum of rows B[k, :] scaled by A[i, k]. A dense
+ * accumulator of width b->cols plus a "last row that touched column j"
+ * marker makes each update O(1); only the touched columns are visited when
+ * the row is written out.
+ */
+void spgemm_rows(RowRange *r) {
+    SpgemmArgs *args = (SpgemmArgs *)r->ctx;
+    const CsrMatrix *a = args->a, *b = args->b;
+    CsrMatrix *c = args->c;
+    int width = b->cols;
+
+    int *marker = (int *)xmalloc(width * sizeof(int));
+    double *acc = args->phase ? (double *)xmalloc(width * sizeof(double)) : NULL;
+    int *touched = (int *)xmalloc(width * sizeof(int));
+    for (int j = 0; j < width; j++) marker[j] = -1;
+
+    for (int i = r->row_begin; i < r->row_end; i++) {
+        int count = 0;
+        for (long long e = a->row_ptr[i]; e < a->row_ptr[i + 1]; e++) {
+            int k = a->col_idx[e];
+            double av = a->val[e];
+            for (long long f = b->row_ptr[k]; f < b->row_ptr[k + 1]; f++) {
+                int j = b->col_idx[f];
+                if (marker[j] != i) {
+                    marker[j] = i;
+                    touched[count++] = j;
+                    if (acc) acc[j] = 0.0;
+                }
+                if (acc) acc[j] += av * b->val[f];
+            }
+        }
+
+        if (args->phase == 0) {
+            c->row_ptr[i + 1] = count;
+        } else {
+            qsort(touched, count, sizeof(int), compare_ints);
+            long long out = c->row_ptr[i];
+            for (int t = 0; t < count; t++) {
+                c->col_idx[out + t] = touched[t];
+                c->val[out + t] = acc[touched[t]];
+            }
+        }
+    }
+    free(marker);
+    free(acc);
+    free(touched);
+}
+
+/**
+ * @brief C = A * B. The symbolic pass sizes each row of C exactly, so the
+ * numeric pass can write rows in parallel without synchronisation.
+ */
+CsrMatrix spgemm(const CsrMatrix *a, const CsrMatrix *b, int threads) {
+    CsrMatrix c;
+    c.rows = a->rows;
+    c.cols = b->cols;
+    c.row_ptr = (long long *)calloc(a->rows + 1, sizeof(long long));
+    if (c.row_ptr == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+
+    SpgemmArgs args = { a, b, &c, 0 };
+    parallel_rows(a, threads, spgemm_rows, &args);
+    for (int i = 0; i < a->rows; i++) c.row_ptr[i + 1] += c.row_ptr[i];
+    c.nnz = c.row_ptr[a->rows];
+    c.col_idx = (int *)xmalloc(c.nnz * sizeof(int));
+    c.val = (double *)xmalloc(c.nnz * sizeof(double));
+
+    args.phase = 1;
+    parallel_rows(a, threads, spgemm_rows, &args);
+    return c;
+}
+
+/* ---------- Dense baselines ---------- */
+
+double *csr_to_dense(const CsrMatrix *a) {
+    double *d = (double *)calloc((size_t)a->rows * a->cols, sizeof(double));
+    if (d == NULL) {
+        fprintf(stderr, "Memory allocation failed.\n");
+        exit(1);
+    }
+    for (int i = 0; i < a->rows; i++)
+        for (long long e = a->row_ptr[i]; e < a->row_ptr[i + 1]; e++)
+            d[(size_t)i * a->cols + a->col_idx[e]] = a->val[e];
+    return d;
+}
+
+/**
+ * @brief C = A * B for dense row-major matrices (tiled i-k-j, single thread).
+ */
+void dense_multiply(const double *a, const double *b, double *c, int m, int k, int n) {
+    const int bk = 128, bj = 256;
+    memset(c, 0, (size_t)m * n * sizeof(double));
+    for (int kk = 0; kk < k; kk += bk) {
+        int k_end = kk + bk < k ? kk + bk : k;
+        for (int jj = 0; jj < n; jj += bj) {
+            int j_end = jj + bj < n ? jj + bj : n;
+            for (int i = 0; i < m; i++) {
+                double *restrict c_row = c + (size_t)i * n;
+                for (int p = kk; p < k_end; p++) {
+                    double a_ip = a[(size_t)i * k + p];
+                    const double *restrict b_row = b + (size_t)p * n;
+                    for (int j = jj; j < j_end; j++)
+                        c_row[j] += a_ip * b_row[j];
+                }
+            }
+        }
+    }
+}
+
+/* ---------- Benchmark ---------- */
+
+double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+double max_abs_diff(const double *x, const double *y, size_t count) {
+    double worst = 0.0;
+    for (size_t i = 0; i < count; i++)
+        if (fabs(x[i] - y[i]) > worst) worst = fabs(x[i] - y[i]);
+    return worst;
+}
+
+double *random_dense(size_t count, unsigned seed) {
+    double *d = (double *)xmalloc(count * sizeof(double));
+    srand(seed);
+    for (size_t i = 0; i < count; i++) d[i] = (double)rand() / RAND_MAX - 0.5;
+    return d;
+}
+
+/**
+ * @brief Times SpMV, SpMM and (for square matrices) SpGEMM A*A on one matrix.
+ *
+ * SpGEMM is checked by comparing (A*A) x with A (A x).
+ */
+void benchmark_sparse(const CsrMatrix *a, int threads, double *spmv_ms, double *spmm_ms,
+                      double *spgemm_ms, long long *c_nnz, double *error) {
+    double *x = random_dense(a->cols, 1);
+    double *y = (double *)xmalloc(a->rows * sizeof(double));
+    double *xm = random_dense((size_t)a->cols * SPMM_RHS_COLS, 2);
+    double *ym = (double *)xmalloc((size_t)a->rows * SPMM_RHS_COLS * sizeof(double));
+
+    double t0 = now_seconds();
+    spmv(a, x, y, threads);
+    *spmv_ms = (now_seconds() - t0) * 1e3;
+
+    t0 = now_seconds();
+    spmm(a, xm, SPMM_RHS_COLS, ym, threads);
+    *spmm_ms = (now_seconds() - t0) * 1e3;
+
+    *spgemm_ms = -1.0;
+    *c_nnz = 0;
+    *error = 0.0;
+    if (a->rows == a->cols) {
+        t0 = now_seconds();
+        CsrMatrix c = spgemm(a, a, threads);
+        *spgemm_ms = (now_seconds() - t0) * 1e3;
+        *c_nnz = c.nnz;
+
+        double *cx = (double *)xmalloc(a->rows * sizeof(double));
+        double *aax = (double *)xmalloc(a->rows * sizeof(double));
+        spmv(&c, x, cx, threads);
+        spmv(a, y, aax, threads);
+        *error = max_abs_diff(cx, aax, a->rows);
+        free(cx);
+        free(aax);
+        free_csr(&c);
+    }
+
+    free(x);
+    free(y);
+    free(xm);
+    free(ym);
+}
+
+int run_file(const char *filename, int threads) {
+    CooMatrix coo;
+    if (!load_matrix_market(filename, &coo)) return 1;
+    CsrMatrix a = coo_to_csr(&coo);
+    free_coo(&coo);
+
+    printf("%s: %d x %d, %lld non-zeros (%.4f%% dense), %d threads\n", filename,
+           a.rows, a.cols, a.nnz, 100.0 * a.nnz / ((double)a.rows * a.cols), threads);
+
+    double t_mv, t_mm, t_gemm, err;
+    long long c_nnz;
+    benchmark_sparse(&a, threads, &t_mv, &t_mm, &t_gemm, &c_nnz, &err);
+    printf("SpMV:              %10.3f ms (%.2f GFLOP/s)\n", t_mv, 2.0 * a.nnz / t_mv / 1e6);
+    printf("SpMM (%d columns): %10.3f ms (%.2f GFLOP/s)\n", SPMM_RHS_COLS, t_mm,
+           2.0 * a.nnz * SPMM_RHS_COLS / t_mm / 1e6);
+    if (t_gemm >= 0)
+        printf("SpGEMM A*A:        %10.3f ms, %lld non-zeros in result, check error %.2e\n",
+               t_gemm, c_nnz, err);
+    free_csr(&a);
+    return 0;
+}
+
+int run_density_sweep(int n, int threads) {
+    printf("Random %d x %d matrices, %d threads\n\n", n, n, threads);
+
+    // Dense baselines do not depend on density, so time them once
+    double *da = random_dense((size_t)n * n, 3);
+    double *x = random_dense(n, 1);
+    double *y = (double *)xmalloc(n * sizeof(double));
+    double *xm = random_dense((size_t)n * SPMM_RHS_COLS, 2);
+    double *ym = (double *)xmalloc((size_t)n * SPMM_RHS_COLS * sizeof(double));
+    double *dc = (double *)xmalloc((size_t)n * n * sizeof(double));
+
+    double t0 = now_seconds();
+    dense_multiply(da, x, y, n, n, 1);
+    double dense_mv = (now_seconds() - t0) * 1e3;
+    t0 = now_seconds();
+    dense_multiply(da, xm, ym, n, n, SPMM_RHS_COLS);
+    double dense_mm = (now_seconds() - t0) * 1e3;
+    t0 = now_seconds();
+    dense_multiply(da, da, dc, n, n, n);
+    double dense_gemm = (now_seconds() - t0) * 1e3;
+    free(dc);
+
+    printf("Dense (1 thread): MV %.3f ms, MM x%d %.3f ms, GEMM %.1f ms\n\n",
+           dense_mv, SPMM_RHS_COLS, dense_mm, dense_gemm);
+    printf("%9s %10s %12s %8s %12s %8s %12s %8s %12s %10s\n", "density", "nnz",
+           "SpMV ms", "vs MV", "SpMM ms", "vs MM", "SpGEMM ms", "vs GEMM", "C nnz", "max error");
+
+    const double densities[] = { 0.0001, 0.001, 0.01, 0.05, 0.2 };
+    for (int d = 0; d < (int)(sizeof(densities) / sizeof(densities[0])); d++) {
+        CooMatrix coo = random_coo(n, n, densities[d], d + 10);
+        CsrMatrix a = coo_to_csr(&coo);
+        free_coo(&coo);
+
+        double t_mv, t_mm, t_gemm, err;
+        long long c_nnz;
+        benchmark_sparse(&a, threads, &t_mv, &t_mm, &t_gemm, &c_nnz, &err);
+
+        // SpMV and SpMM results are also checked against the dense kernels
+        double *sd = csr_to_dense(&a);
+        double *sy = (double *)xmalloc(n * sizeof(double));
+        double *dy = (double *)xmalloc(n * sizeof(double));
+        spmv(&a, x, sy, threads);
+        dense_multiply(sd, x, dy, n, n, 1);
+        double mv_err = max_abs_diff(sy, dy, n);
+        if (mv_err > err) err = mv_err;
+        free(sd);
+        free(sy);
+        free(dy);
+
+        printf("%8.2f%% %10lld %12.3f %7.1fx %12.3f %7.1fx %12.3f %7.1fx %12lld %10.2e\n",
+               densities[d] * 100.0, a.nnz, t_mv, dense_mv / t_mv, t_mm, dense_mm / t_mm,
+               t_gemm, dense_gemm / t_gemm, c_nnz, err);
+        free_csr(&a);
+    }
+
+    free(da);
+    free(x);
+    free(y);
+    free(xm);
+    free(ym);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int threads = cpus > 0 ? (int)cpus : 1;
+
+    if (argc > 1 && strstr(argv[1], ".mtx") != NULL) {
+        if (argc > 2) threads = atoi(argv[2]);
+        if (threads <= 0) threads = 1;
+        return run_file(argv[1], threads);
+    }
+
+    int n = argc > 1 ? atoi(argv[1]) : 2048;
+    if (argc > 2) threads = atoi(argv[2]);
+    if (n <= 0 || threads <= 0) {
+        fprintf(stderr, "Usage: %s [size [threads]] | %s file.mtx [threads]\n", argv[0], argv[0]);
+        return 1;
+    }
+    return run_density_sweep(n, threads);
+}